@@ -3,6 +3,7 @@
 //
 
 #include "FitterEngine.h"
+#include "MCMCEngine.h"
 #include "VersionConfig.h"
 #include "JsonUtils.h"
 #include "GlobalVariables.h"
@@ -36,6 +37,7 @@ int main(int argc, char** argv){
   clParser.addTriggerOption("dry-run", {"--dry-run", "-d"},"Perform the full sequence of initialization, but don't do the actual fit.");
   clParser.addTriggerOption("generateOneSigmaPlots", {"--one-sigma"}, "Generate one sigma plots");
   clParser.addTriggerOption("asimov", {"-a", "--asimov"}, "Use MC dataset to fill the data histograms");
+  clParser.addTriggerOption("mcmc", {"--mcmc"}, "Run the MCMC sampler (after the fit if enabled)");
 
   clParser.addOption("cache", {"-C", "--cache-enabled"}, "Enable the event weight cache");
   clParser.addOption("configFile", {"-c", "--config-file"}, "Specify path to the fitter config file");
@@ -44,9 +46,14 @@ int main(int argc, char** argv){
   clParser.addOption("scanParameters", {"--scan"}, "Enable parameter scan before and after the fit");
   clParser.addOption("toyFit", {"--toy"}, "Run a toy fit");
   clParser.addOption("randomSeed", {"-s", "--seed"}, "Set random seed");
+  clParser.addOption("checkpoint", {"--checkpoint"}, "Write fit checkpoints in the given file (default: <output file>.checkpoint)");
+  clParser.addOption("resume", {"--resume"}, "Resume the fit from a checkpoint file (default: the --checkpoint one)");
+  clParser.addOption("warmStart", {"--warm-start"}, "Start the fit from the post-fit parameters of a previous output file");
 
   clParser.getOptionPtr("scanParameters")->setAllowEmptyValue(true); // --scan can be followed or not by the number of steps
   clParser.getOptionPtr("toyFit")->setAllowEmptyValue(true); // --toy can be followed or not by the number of steps
+  clParser.getOptionPtr("checkpoint")->setAllowEmptyValue(true);
+  clParser.getOptionPtr("resume")->setAllowEmptyValue(true);
 
   LogInfo << "Usage: " << std::endl;
   LogInfo << clParser.getConfigSummary() << std::endl << std::endl;
@@ -155,6 +162,14 @@ int main(int argc, char** argv){
   fitter.setNbScanSteps(nbScanSteps);
   fitter.setEnablePostFitScan(enableParameterScan);
 
+  // Checkpoints
+  if( clParser.isOptionTriggered("checkpoint") or clParser.isOptionTriggered("resume") ){
+    std::string checkpointFilePath = clParser.getOptionVal("checkpoint", outFileName + ".checkpoint");
+    fitter.setCheckpointFilePath(checkpointFilePath);
+    if( clParser.isOptionTriggered("resume") ){ fitter.setResumeCheckpointFilePath(clParser.getOptionVal("resume", checkpointFilePath)); }
+  }
+  if( clParser.isOptionTriggered("warmStart") ){ fitter.setWarmStartFilePath(clParser.getOptionVal<std::string>("warmStart")); }
+
   if( isToyFit ){
     fitter.getPropagator().setThrowAsimovToyParameters(true);
     fitter.getPropagator().setIThrow(iToyFit);
@@ -186,6 +201,19 @@ int main(int argc, char** argv){
     fitter.fit();
   }
 
+  // --------------------------
+  // Posterior sampling:
+  // --------------------------
+  auto mcmcConfig = JsonUtils::fetchValue(jsonConfig, "mcmcEngineConfig", nlohmann::json());
+  if( not isDryRun and ( clParser.isOptionTriggered("mcmc") or JsonUtils::fetchValue(mcmcConfig, "enabled", false) ) ){
+    MCMCEngine mcmc;
+    mcmc.setConfig(mcmcConfig);
+    mcmc.setSaveDir(GenericToolbox::mkdirTFile(out, "MCMCEngine"));
+    mcmc.setFitterEngine(&fitter);
+    mcmc.initialize();
+    mcmc.run();
+  }
+
   LogWarning << "Closing output file \"" << out->GetName() << "\"..." << std::endl;
   out->Close();
   LogInfo << "Closed." << std::endl;
@@ -5,10 +5,12 @@
 #include "WeightMonotonicSpline.h"
 #include "WeightUniformSpline.h"
 #include "WeightGeneralSpline.h"
+#include "WeightGraph.h"
 #include "CacheIndexedSums.h"
 
 #include "FitParameterSet.h"
 #include "Dial.h"
+#include "DialRegistry.h"
 #include "SplineDial.h"
 #include "GraphDial.h"
 #include "NormDial.h"
@@ -64,6 +66,7 @@ Cache::Manager::Manager(int events, int parameters,
                         int compactSplines, int compactPoints,
                         int uniformSplines, int uniformPoints,
                         int generalSplines, int generalPoints,
+                        int graphs, int graphPoints,
                         int histBins) {
     LogInfo << "Creating cache manager" << std::endl;
 
@@ -113,6 +116,15 @@ Cache::Manager::Manager(int events, int parameters,
         fWeightsCache->AddWeightCalculator(fGeneralSplines.get());
         fTotalBytes += fGeneralSplines->GetResidentMemory();
 
+        fGraphs.reset(new Cache::Weight::Graph(
+                                  fWeightsCache->GetWeights(),
+                                  fParameterCache->GetParameters(),
+                                  fParameterCache->GetLowerClamps(),
+                                  fParameterCache->GetUpperClamps(),
+                                  graphs, graphPoints));
+        fWeightsCache->AddWeightCalculator(fGraphs.get());
+        fTotalBytes += fGraphs->GetResidentMemory();
+
         fHistogramsCache.reset(new Cache::IndexedSums(
                                   fWeightsCache->GetWeights(),
                                   histBins));
@@ -162,14 +174,19 @@ bool Cache::Manager::Build(FitSampleSet& sampleList) {
             if (event.getSampleBinIndex() < 0) {
                 throw std::runtime_error("Caching event that isn't used");
             }
-            for (const Dial* dial
-                     : event.getRawDialPtrList()) {
+            // The dial type is encoded in the registry id: no need to
+            // dynamic_cast the dials to classify them.
+            const DialIdList& dialIdList = event.getRawDialPtrList();
+            for (const uint32_t* idPtr = dialIdList.data();
+                 idPtr != dialIdList.data() + dialIdList.size(); ++idPtr) {
+                const Dial* dial = DialRegistry::getDial(*idPtr);
+                DialType::DialType dialType = DialRegistry::getDialType(*idPtr);
                 const FitParameter* fp = dial->getOwner()->getOwner();
                 usedParameters.insert(fp);
                 ++useCount[fp->getFullTitle()];
-                const SplineDial* sDial
-                    = dynamic_cast<const SplineDial*>(dial);
-                if (sDial) {
+                if (dialType == DialType::Spline) {
+                    const SplineDial* sDial
+                        = static_cast<const SplineDial*>(dial);
                     std::string splineType = Cache::Manager::SplineType(sDial);
                     if (sDial->getSplineType() == SplineDial::Monotonic
                         && splineType != "compactSpline") LogThrow("Bad mono");
@@ -200,14 +217,12 @@ bool Cache::Manager::Build(FitSampleSet& sampleList) {
                         throw std::runtime_error("Invalid spline type");
                     }
                 }
-                const GraphDial* gDial
-                    = dynamic_cast<const GraphDial*>(dial);
-                if (gDial) {
+                else if (dialType == DialType::Graph) {
                     ++graphs;
+                    graphPoints += Cache::Weight::Graph::FindPoints(
+                        static_cast<const GraphDial*>(dial));
                 }
-                const NormDial* nDial
-                    = dynamic_cast<const NormDial*>(dial);
-                if (nDial) {
+                else if (dialType == DialType::Norm) {
                     ++norms;
                 }
             }
@@ -284,8 +299,9 @@ bool Cache::Manager::Build(FitSampleSet& sampleList) {
                 << std::endl;
     }
     if (graphs > 0) {
-        LogInfo << "   Graph cache for " << graphPoints << " control points --"
+        LogInfo << "    Graph cache uses " << graphPoints << " control points --"
                 << " (" << 1.0*graphPoints/graphs << " points per graph)"
+                << " for " << graphs << " graphs"
                 << std::endl;
     }
 
@@ -301,6 +317,7 @@ bool Cache::Manager::Build(FitSampleSet& sampleList) {
                                  compactSplines,compactPoints,
                                  uniformSplines,uniformPoints,
                                  generalSplines,generalPoints,
+                                 graphs,graphPoints,
                                  histCells);
     }
 
@@ -403,6 +420,13 @@ bool Cache::Manager::Build(FitSampleSet& sampleList) {
                         throw std::runtime_error("Invalid spline type");
                     }
                 }
+                if(dial->getDialType() == DialType::Graph) {
+                    ++dialUsed;
+                    Cache::Manager::Get()
+                        ->fGraphs
+                        ->AddGraph(resultIndex,parIndex,
+                                   static_cast<GraphDial*>(dial));
+                }
                 if (!dialUsed) throw std::runtime_error("Unused dial");
             }
         }
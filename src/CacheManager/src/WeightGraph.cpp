@@ -0,0 +1,274 @@
+//
+// WeightGraph.cpp
+//
+
+#include "CacheWeights.h"
+#include "WeightBase.h"
+#include "WeightGraph.h"
+
+#include <algorithm>
+#include <iostream>
+#include <exception>
+#include <limits>
+#include <cmath>
+
+#include <hemi/hemi_error.h>
+#include <hemi/launch.h>
+#include <hemi/grid_stride_range.h>
+
+#include "Logger.h"
+LoggerInit([]{
+  Logger::setUserHeaderStr("[Cache]");
+});
+
+// The constructor
+Cache::Weight::Graph::Graph(
+    Cache::Weights::Results& weights,
+    Cache::Parameters::Values& parameters,
+    Cache::Parameters::Clamps& lowerClamps,
+    Cache::Parameters::Clamps& upperClamps,
+    std::size_t graphs, std::size_t points)
+    : Cache::Weight::Base("graph",weights,parameters),
+      fLowerClamp(lowerClamps), fUpperClamp(upperClamps),
+      fGraphsReserved(graphs), fGraphsUsed(0),
+      fGraphPointsReserved(points), fGraphPointsUsed(0) {
+
+    LogInfo << "Reserved " << GetName() << " Graphs: "
+            << GetGraphsReserved() << std::endl;
+    if (GetGraphsReserved() < 1) return;
+
+    fTotalBytes += GetGraphsReserved()*sizeof(int);      // fGraphResult
+    fTotalBytes += GetGraphsReserved()*sizeof(short);    // fGraphParameter
+    fTotalBytes += (1+GetGraphsReserved())*sizeof(int);  // fGraphIndex
+
+    // Calculate the space needed to store the graph data.  This needs to
+    // know how the graph data is packed for CalculateGraph.
+    fGraphPointsReserved = fGraphsReserved + 2*fGraphPointsReserved;
+
+#ifdef CACHE_MANAGER_SLOW_VALIDATION
+#warning Using SLOW VALIDATION in Cache::Weight::Graph::Graph
+    // Add validation code for the graph calculation.  This can be rather
+    // slow, so do not use if it is not required.
+    fTotalBytes += GetGraphsReserved()*sizeof(double);
+#endif
+
+    LogInfo << "Reserved " << GetName()
+            << " Graph Points: " << GetGraphPointsReserved()
+            << std::endl;
+    fTotalBytes += GetGraphPointsReserved()*sizeof(WEIGHT_BUFFER_FLOAT);  // fGraphPoints
+
+    LogInfo << "Approximate Memory Size for " << GetName()
+            << ": " << fTotalBytes/1E+9
+            << " GB" << std::endl;
+
+    try {
+        // Get the CPU/GPU memory for the graph index tables.  These are
+        // copied once during initialization so do not pin the CPU memory into
+        // the page set.
+        fGraphResult.reset(new hemi::Array<int>(GetGraphsReserved(),false));
+        fGraphParameter.reset(
+            new hemi::Array<short>(GetGraphsReserved(),false));
+        fGraphIndex.reset(new hemi::Array<int>(1+GetGraphsReserved(),false));
+
+#ifdef CACHE_MANAGER_SLOW_VALIDATION
+#warning Using SLOW VALIDATION in Cache::Weight::Graph::Graph
+        // Add validation code for the graph calculation.  This can be rather
+        // slow, so do not use if it is not required.
+        fGraphValue.reset(new hemi::Array<double>(GetGraphsReserved(),true));
+#endif
+
+        // Get the CPU/GPU memory for the graph points.  This is copied once
+        // during initialization so do not pin the CPU memory into the page
+        // set.
+        fGraphPoints.reset(
+            new hemi::Array<WEIGHT_BUFFER_FLOAT>(GetGraphPointsReserved(),false));
+    }
+    catch (std::bad_alloc&) {
+        LogError << "Failed to allocate memory, so stopping" << std::endl;
+        throw std::runtime_error("Not enough memory available");
+    }
+
+    // Initialize the caches.  Don't try to zero everything since the
+    // caches can be huge.
+    fGraphIndex->hostPtr()[0] = 0;
+}
+
+// The destructor
+Cache::Weight::Graph::~Graph() {}
+
+int Cache::Weight::Graph::FindPoints(const GraphDial* g) {
+    return g->getNbPoints();
+}
+
+void Cache::Weight::Graph::AddGraph(int resIndex, int parIndex,
+                                    GraphDial* gDial) {
+    if (resIndex < 0) {
+        LogError << "Invalid result index"
+               << std::endl;
+        throw std::runtime_error("Negative result index");
+    }
+    if (fWeights.size() <= resIndex) {
+        LogError << "Invalid result index"
+               << std::endl;
+        throw std::runtime_error("Result index out of bounds");
+    }
+    if (parIndex < 0) {
+        LogError << "Invalid parameter index"
+               << std::endl;
+        throw std::runtime_error("Negative parameter index");
+    }
+    if (fParameters.size() <= parIndex) {
+        LogError << "Invalid parameter index"
+               << std::endl;
+        throw std::runtime_error("Parameter index out of bounds");
+    }
+    if (gDial->getGraphData().size() < 3) {
+        LogError << "Insufficient points in graph"
+               << std::endl;
+        throw std::runtime_error("Invalid number of graph points");
+    }
+    int newIndex = fGraphsUsed++;
+    if (fGraphsUsed > fGraphsReserved) {
+        LogError << "Not enough space reserved for graphs"
+                  << std::endl;
+        throw std::runtime_error("Not enough space reserved for graphs");
+    }
+    fGraphResult->hostPtr()[newIndex] = resIndex;
+    fGraphParameter->hostPtr()[newIndex] = parIndex;
+    if (fGraphIndex->hostPtr()[newIndex] != fGraphPointsUsed) {
+        LogError << "Last graph point index should be at old end of graphs"
+                  << std::endl;
+        throw std::runtime_error("Problem with control indices");
+    }
+    int pointIndex = fGraphPointsUsed;
+    fGraphPointsUsed += gDial->getGraphData().size();
+    if (fGraphPointsUsed > fGraphPointsReserved) {
+        LogError << "Not enough space reserved for graph points"
+               << std::endl;
+        throw std::runtime_error("Not enough space reserved for graph points");
+    }
+    fGraphIndex->hostPtr()[newIndex+1] = fGraphPointsUsed;
+    for (std::size_t i = 0; i<gDial->getGraphData().size(); ++i) {
+        fGraphPoints->hostPtr()[pointIndex+i] = gDial->getGraphData().at(i);
+    }
+
+#ifdef CACHE_MANAGER_SLOW_VALIDATION
+#warning Using SLOW VALIDATION in Cache::Weight::Graph::AddGraph
+    gDial->setCacheManagerName(GetName());
+    gDial->setCacheManagerValuePointer(GetCachePointer(newIndex));
+#endif
+}
+
+int Cache::Weight::Graph::GetGraphParameterIndex(int gIndex) {
+    if (gIndex < 0) {
+        throw std::runtime_error("Graph index invalid");
+    }
+    if (GetGraphsUsed() <= gIndex) {
+        throw std::runtime_error("Graph index invalid");
+    }
+    return fGraphParameter->hostPtr()[gIndex];
+}
+
+int Cache::Weight::Graph::GetGraphPointCount(int gIndex) {
+    if (gIndex < 0) {
+        throw std::runtime_error("Graph index invalid");
+    }
+    if (GetGraphsUsed() <= gIndex) {
+        throw std::runtime_error("Graph index invalid");
+    }
+    int k = fGraphIndex->hostPtr()[gIndex+1]-fGraphIndex->hostPtr()[gIndex]-1;
+    return k/2;
+}
+
+////////////////////////////////////////////////////////////////////
+// This section is for the validation methods.  They should mostly be
+// NOOPs and should mostly not be called.
+
+#ifdef CACHE_MANAGER_SLOW_VALIDATION
+#warning Using SLOW VALIDATION in Cache::Weight::Graph::GetCachePointer
+// Get the intermediate graph result that is used to calculate an event
+// weight.  This can trigger a copy from the GPU to CPU, and must only be
+// enabled during validation.  Using this validation code also significantly
+// increases the amount of GPU memory required.  In a short sentence, "Do not
+// use this method."
+double* Cache::Weight::Graph::GetCachePointer(int gIndex) {
+    if (gIndex < 0) {
+        throw std::runtime_error("GetCachePointer: Graph index invalid");
+    }
+    if (GetGraphsUsed() <= gIndex) {
+        throw std::runtime_error("GetCachePointer: Graph index invalid");
+    }
+    // This can trigger a *slow* copy of the graph values from the GPU to the
+    // CPU.
+    return fGraphValue->hostPtr() + gIndex;
+}
+#endif
+
+#include "CalculateGraph.h"
+#include "CacheAtomicMult.h"
+
+namespace {
+
+    // A function to be used as the kernel on either the CPU or GPU.  This
+    // must be valid CUDA coda.
+    HEMI_KERNEL_FUNCTION(HEMIGraphsKernel,
+                         double* results,
+#ifdef CACHE_MANAGER_SLOW_VALIDATION
+#warning Using SLOW VALIDATION in Cache::Weight::Graph::HEMIGraphsKernel
+                         // inputs/output for validation
+                         double* graphValues,
+#endif
+                         const double* params,
+                         const double* lowerClamp,
+                         const double* upperClamp,
+                         const WEIGHT_BUFFER_FLOAT* points,
+                         const int* rIndex,
+                         const short* pIndex,
+                         const int* gIndex,
+                         const int NP) {
+        for (int i : hemi::grid_stride_range(0,NP)) {
+            const int id0 = gIndex[i];
+            const int id1 = gIndex[i+1];
+            const int dim = id1-id0;
+            const double x = params[pIndex[i]];
+            const double lClamp = lowerClamp[pIndex[i]];
+            const double uClamp = upperClamp[pIndex[i]];
+
+            double v = CalculateGraph(x, lClamp, uClamp, &points[id0], dim);
+
+#ifdef CACHE_MANAGER_SLOW_VALIDATION
+#warning Using SLOW VALIDATION in Cache::Weight::Graph::HEMIGraphsKernel
+            graphValues[i] = v;
+#endif
+            CacheAtomicMult(&results[rIndex[i]], v);
+        }
+    }
+}
+
+bool Cache::Weight::Graph::Apply() {
+    if (GetGraphsUsed() < 1) return false;
+
+    HEMIGraphsKernel graphsKernel;
+    hemi::launch(graphsKernel,
+                 fWeights.writeOnlyPtr(),
+#ifdef CACHE_MANAGER_SLOW_VALIDATION
+#warning Using SLOW VALIDATION in Cache::Weight::Graph::Apply
+                 fGraphValue->writeOnlyPtr(),
+#endif
+                 fParameters.readOnlyPtr(),
+                 fLowerClamp.readOnlyPtr(),
+                 fUpperClamp.readOnlyPtr(),
+                 fGraphPoints->readOnlyPtr(),
+                 fGraphResult->readOnlyPtr(),
+                 fGraphParameter->readOnlyPtr(),
+                 fGraphIndex->readOnlyPtr(),
+                 GetGraphsUsed()
+        );
+
+#ifdef CACHE_MANAGER_SLOW_VALIDATION
+#warning Using SLOW VALIDATION and copying graph values
+    fGraphValue->hostPtr();
+#endif
+
+    return true;
+}
@@ -0,0 +1 @@
+#include "WeightGraph.cpp"
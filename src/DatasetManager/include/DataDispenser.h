@@ -82,6 +82,7 @@ public:
 protected:
   void buildSampleToFillList();
   void doEventSelection();
+  bool doColumnarEventSelection(TChain& treeChain_, const std::vector<std::string>& sampleCutList_);
   void fetchRequestedLeaves();
   void preAllocateMemory();
   void readAndFill();
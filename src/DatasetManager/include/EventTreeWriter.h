@@ -24,7 +24,9 @@ public:
   void setParSetListPtr(const std::vector<FitParameterSet> *parSetListPtr);
 
   void writeSamples(TDirectory* saveDir_) const;
-  void writeEvents(TDirectory* saveDir_, const std::string& treeName_, const std::vector<PhysicsEvent> & eventList_) const;
+  // If packedContainerPtr_ is set, the leaves of the events are restored block by block from its packed leaves
+  void writeEvents(TDirectory* saveDir_, const std::string& treeName_, const std::vector<PhysicsEvent> & eventList_, const SampleElement* packedContainerPtr_ = nullptr) const;
+  void writeFrozenEvents(TDirectory* saveDir_, const std::string& treeName_, const SampleElement& container_) const;
 
 private:
   bool _writeDials_{false};
@@ -6,8 +6,10 @@
 #include "GlobalVariables.h"
 #include "SplineDial.h"
 #include "GraphDial.h"
+#include "DialRegistry.h"
 #include "DatasetLoader.h"
 #include "JsonUtils.h"
+#include "CompiledFormula.h"
 
 #include "GenericToolbox.Root.TreeEventBuffer.h"
 #include "GenericToolbox.Root.h"
@@ -17,6 +19,9 @@
 #include "TTreeFormulaManager.h"
 #include "TChain.h"
 #include "TChainElement.h"
+#include "TLeaf.h"
+#include "TLeafC.h"
+#include "TLeafElement.h"
 
 #include "sstream"
 
@@ -178,78 +183,85 @@ void DataDispenser::doEventSelection(){
   for( const auto& file: _parameters_.filePathList){ treeChain.Add(file.c_str()); }
   LogThrowIf(treeChain.GetEntries() == 0, "TChain is empty.");
 
-  LogInfo << "Defining selection formulas..." << std::endl;
-  treeChain.SetBranchStatus("*", true); // enabling every branch to define formula
-
-  TTreeFormula* treeSelectionCutFormula{nullptr};
-  std::vector<TTreeFormula*> sampleCutFormulaList(_cache_.samplesToFillList.size(), nullptr);
-  TTreeFormulaManager formulaManager; // TTreeFormulaManager handles the notification of multiple TTreeFormula for one TTChain
-
-  if( not _parameters_.selectionCutFormulaStr.empty() ){
-    treeSelectionCutFormula = new TTreeFormula("SelectionCutFormula", _parameters_.selectionCutFormulaStr.c_str(), &treeChain);
-    LogThrowIf(treeSelectionCutFormula->GetNdim() == 0,
-               "\"" << _parameters_.selectionCutFormulaStr << "\" could not be parsed by the TChain");
-
-    // The TChain will notify the formula that it has to update leaves addresses while swaping TFile
-    formulaManager.Add(treeSelectionCutFormula);
-    LogInfo << "Using tree selection cut: \"" << _parameters_.selectionCutFormulaStr << "\"" << std::endl;
-  }
-
   GenericToolbox::TablePrinter t;
   t.setColTitles({{"Sample"}, {"Selection Cut"}});
+  std::vector<std::string> sampleCutList(_cache_.samplesToFillList.size());
   for( size_t iSample = 0 ; iSample < _cache_.samplesToFillList.size() ; iSample++ ){
-
-    std::string selectionCut = _cache_.samplesToFillList[iSample]->getSelectionCutsStr();
+    sampleCutList[iSample] = _cache_.samplesToFillList[iSample]->getSelectionCutsStr();
     for( auto& replaceEntry : _cache_.leavesToOverrideList ){
-      GenericToolbox::replaceSubstringInsideInputString(selectionCut, replaceEntry, _parameters_.overrideLeafDict[replaceEntry]);
+      GenericToolbox::replaceSubstringInsideInputString(sampleCutList[iSample], replaceEntry, _parameters_.overrideLeafDict[replaceEntry]);
     }
-
-    t.addTableLine({{"\""+_cache_.samplesToFillList[iSample]->getName()+"\""}, {"\""+selectionCut+"\""}});
-    sampleCutFormulaList[iSample] = new TTreeFormula(_cache_.samplesToFillList[iSample]->getName().c_str(), selectionCut.c_str(), &treeChain);
-    LogThrowIf(sampleCutFormulaList[iSample]->GetNdim() == 0,
-               "\"" << selectionCut << "\" could not be parsed by the TChain");
-
-    // The TChain will notify the formula that it has to update leaves addresses while swaping TFile
-    formulaManager.Add(sampleCutFormulaList[iSample]);
+    t.addTableLine({{"\""+_cache_.samplesToFillList[iSample]->getName()+"\""}, {"\""+sampleCutList[iSample]+"\""}});
   }
-  treeChain.SetNotify(&formulaManager);
-  t.printTable();
-
-  LogInfo << "Enabling required branches..." << std::endl;
-  treeChain.SetBranchStatus("*", false);
-
-  if(treeSelectionCutFormula != nullptr) GenericToolbox::enableSelectedBranches(&treeChain, treeSelectionCutFormula);
-  for( auto& sampleFormula : sampleCutFormulaList ){
-    GenericToolbox::enableSelectedBranches(&treeChain, sampleFormula);
+  if( not _parameters_.selectionCutFormulaStr.empty() ){
+    LogInfo << "Using tree selection cut: \"" << _parameters_.selectionCutFormulaStr << "\"" << std::endl;
   }
+  t.printTable();
 
-  LogInfo << "Performing event selection..." << std::endl;
-  GenericToolbox::VariableMonitor readSpeed("bytes");
   Long64_t nEvents = treeChain.GetEntries();
   // for each event, which sample is active?
   _cache_.eventIsInSamplesList.resize(nEvents, std::vector<bool>(_cache_.samplesToFillList.size(), true));
-  std::string progressTitle = LogInfo.getPrefixString() + "Reading input dataset";
-  TFile* lastFilePtr{nullptr};
-  for( Long64_t iEvent = 0 ; iEvent < nEvents ; iEvent++ ){
-    readSpeed.addQuantity(treeChain.GetEntry(iEvent));
-    if( GenericToolbox::showProgressBar(iEvent, nEvents) ){
-      GenericToolbox::displayProgressBar(
-          iEvent, nEvents,progressTitle + " - " +
-                          GenericToolbox::padString(GenericToolbox::parseSizeUnits((unsigned int)(readSpeed.evalTotalGrowthRate())), 8)
-                          + "/s");
+
+  if( not this->doColumnarEventSelection(treeChain, sampleCutList) ){
+    LogInfo << "Defining selection formulas..." << std::endl;
+    treeChain.SetBranchStatus("*", true); // enabling every branch to define formula
+
+    TTreeFormula* treeSelectionCutFormula{nullptr};
+    std::vector<TTreeFormula*> sampleCutFormulaList(_cache_.samplesToFillList.size(), nullptr);
+    TTreeFormulaManager formulaManager; // TTreeFormulaManager handles the notification of multiple TTreeFormula for one TTChain
+
+    if( not _parameters_.selectionCutFormulaStr.empty() ){
+      treeSelectionCutFormula = new TTreeFormula("SelectionCutFormula", _parameters_.selectionCutFormulaStr.c_str(), &treeChain);
+      LogThrowIf(treeSelectionCutFormula->GetNdim() == 0,
+                 "\"" << _parameters_.selectionCutFormulaStr << "\" could not be parsed by the TChain");
+
+      // The TChain will notify the formula that it has to update leaves addresses while swaping TFile
+      formulaManager.Add(treeSelectionCutFormula);
+    }
+
+    for( size_t iSample = 0 ; iSample < _cache_.samplesToFillList.size() ; iSample++ ){
+      sampleCutFormulaList[iSample] = new TTreeFormula(_cache_.samplesToFillList[iSample]->getName().c_str(), sampleCutList[iSample].c_str(), &treeChain);
+      LogThrowIf(sampleCutFormulaList[iSample]->GetNdim() == 0,
+                 "\"" << sampleCutList[iSample] << "\" could not be parsed by the TChain");
+
+      // The TChain will notify the formula that it has to update leaves addresses while swaping TFile
+      formulaManager.Add(sampleCutFormulaList[iSample]);
     }
+    treeChain.SetNotify(&formulaManager);
 
-    if(treeSelectionCutFormula != nullptr and not GenericToolbox::doesEntryPassCut(treeSelectionCutFormula)){
-      for( size_t iSample = 0 ; iSample < sampleCutFormulaList.size() ; iSample++ ){ _cache_.eventIsInSamplesList[iEvent][iSample] = false; }
-      continue;
+    LogInfo << "Enabling required branches..." << std::endl;
+    treeChain.SetBranchStatus("*", false);
+
+    if(treeSelectionCutFormula != nullptr) GenericToolbox::enableSelectedBranches(&treeChain, treeSelectionCutFormula);
+    for( auto& sampleFormula : sampleCutFormulaList ){
+      GenericToolbox::enableSelectedBranches(&treeChain, sampleFormula);
     }
 
-    for( size_t iSample = 0 ; iSample < sampleCutFormulaList.size() ; iSample++ ){
-      if( not GenericToolbox::doesEntryPassCut(sampleCutFormulaList[iSample]) ){
-        _cache_.eventIsInSamplesList[iEvent][iSample] = false;
+    LogInfo << "Performing event selection..." << std::endl;
+    GenericToolbox::VariableMonitor readSpeed("bytes");
+    std::string progressTitle = LogInfo.getPrefixString() + "Reading input dataset";
+    for( Long64_t iEvent = 0 ; iEvent < nEvents ; iEvent++ ){
+      readSpeed.addQuantity(treeChain.GetEntry(iEvent));
+      if( GenericToolbox::showProgressBar(iEvent, nEvents) ){
+        GenericToolbox::displayProgressBar(
+            iEvent, nEvents,progressTitle + " - " +
+                            GenericToolbox::padString(GenericToolbox::parseSizeUnits((unsigned int)(readSpeed.evalTotalGrowthRate())), 8)
+                            + "/s");
       }
-    } // iSample
-  } // iEvent
+
+      if(treeSelectionCutFormula != nullptr and not GenericToolbox::doesEntryPassCut(treeSelectionCutFormula)){
+        for( size_t iSample = 0 ; iSample < sampleCutFormulaList.size() ; iSample++ ){ _cache_.eventIsInSamplesList[iEvent][iSample] = false; }
+        continue;
+      }
+
+      for( size_t iSample = 0 ; iSample < sampleCutFormulaList.size() ; iSample++ ){
+        if( not GenericToolbox::doesEntryPassCut(sampleCutFormulaList[iSample]) ){
+          _cache_.eventIsInSamplesList[iEvent][iSample] = false;
+        }
+      } // iSample
+    } // iEvent
+    treeChain.SetNotify(nullptr);
+  }
 
   LogInfo << "Counting requested event slots for each samples..." << std::endl;
   _cache_.sampleNbOfEvents.resize(_cache_.samplesToFillList.size(), 0);
@@ -270,6 +282,106 @@ void DataDispenser::doEventSelection(){
   }
 
 }
+bool DataDispenser::doColumnarEventSelection(TChain& treeChain_, const std::vector<std::string>& sampleCutList_){
+  // The cuts are compiled with the leaf names as parameters. Index 0 is the tree selection cut, then one per sample.
+  std::vector<std::string> cutStrList{_parameters_.selectionCutFormulaStr};
+  cutStrList.insert(cutStrList.end(), sampleCutList_.begin(), sampleCutList_.end());
+
+  std::vector<CompiledFormula> cutList(cutStrList.size());
+  std::vector<std::string> leafNameList;
+  for( size_t iCut = 0 ; iCut < cutStrList.size() ; iCut++ ){
+    if( cutStrList[iCut].empty() ){ continue; }
+    if( not cutList[iCut].compile(cutStrList[iCut], true) ){
+      LogInfo << "Selection cuts evaluated entry by entry: \"" << cutStrList[iCut] << "\" " << cutList[iCut].getErrorMessage() << std::endl;
+      return false;
+    }
+    for( auto& leafName : cutList[iCut].getParameterNameList() ){
+      if( not GenericToolbox::doesElementIsInVector(leafName, leafNameList) ){ leafNameList.emplace_back(leafName); }
+    }
+  }
+
+  // Only plain scalar leaves can be copied into the columns
+  treeChain_.LoadTree(0);
+  std::vector<TLeaf*> leafList(leafNameList.size(), nullptr);
+  for( size_t iLeaf = 0 ; iLeaf < leafNameList.size() ; iLeaf++ ){
+    leafList[iLeaf] = treeChain_.GetLeaf(leafNameList[iLeaf].c_str());
+    if(    leafList[iLeaf] == nullptr
+        or leafList[iLeaf]->GetLeafCount() != nullptr or leafList[iLeaf]->GetLenStatic() != 1
+        or leafList[iLeaf]->IsA() == TLeafElement::Class() or leafList[iLeaf]->IsA() == TLeafC::Class() ){
+      LogInfo << "Selection cuts evaluated entry by entry: \"" << leafNameList[iLeaf] << "\" is not a scalar leaf." << std::endl;
+      return false;
+    }
+  }
+
+  for( auto& cut : cutList ){
+    if( not cut.isValid() ){ continue; }
+    std::vector<int> indexList;
+    for( auto& leafName : cut.getParameterNameList() ){
+      indexList.emplace_back(GenericToolbox::findElementIndex(leafName, leafNameList));
+    }
+    cut.bindParameters(indexList);
+  }
+
+  LogInfo << "Enabling required branches..." << std::endl;
+  treeChain_.SetBranchStatus("*", false);
+  for( auto* leaf : leafList ){ treeChain_.SetBranchStatus(leaf->GetBranch()->GetName(), true); }
+
+  LogInfo << "Performing event selection on batches of entries (" << leafNameList.size() << " columns)..." << std::endl;
+  const size_t batchSize{4096};
+  std::vector<std::vector<double>> columnList(leafList.size(), std::vector<double>(batchSize, 0));
+  std::vector<const double*> columnPtrList;
+  for( auto& column : columnList ){ columnPtrList.emplace_back(column.data()); }
+  std::vector<double> stackBuffer;
+  std::vector<double> selectionMask(batchSize, 1);
+  std::vector<double> sampleMask(batchSize, 1);
+
+  GenericToolbox::VariableMonitor readSpeed("bytes");
+  Long64_t nEvents = treeChain_.GetEntries();
+  std::string progressTitle = LogInfo.getPrefixString() + "Reading input dataset";
+  int treeNumber{treeChain_.GetTreeNumber()};
+  for( Long64_t iFirstEvent = 0 ; iFirstEvent < nEvents ; iFirstEvent += Long64_t(batchSize) ){
+    size_t nRows = size_t(std::min(Long64_t(batchSize), nEvents - iFirstEvent));
+
+    // Fill the columns
+    for( size_t iRow = 0 ; iRow < nRows ; iRow++ ){
+      Long64_t iEvent = iFirstEvent + Long64_t(iRow);
+      readSpeed.addQuantity(treeChain_.GetEntry(iEvent));
+      if( GenericToolbox::showProgressBar(iEvent, nEvents) ){
+        GenericToolbox::displayProgressBar(
+            iEvent, nEvents,progressTitle + " - " +
+                            GenericToolbox::padString(GenericToolbox::parseSizeUnits((unsigned int)(readSpeed.evalTotalGrowthRate())), 8)
+                            + "/s");
+      }
+
+      if( treeChain_.GetTreeNumber() != treeNumber ){
+        // new file: the leaves belong to the new tree
+        treeNumber = treeChain_.GetTreeNumber();
+        for( size_t iLeaf = 0 ; iLeaf < leafList.size() ; iLeaf++ ){
+          leafList[iLeaf] = treeChain_.GetLeaf(leafNameList[iLeaf].c_str());
+          LogThrowIf(leafList[iLeaf] == nullptr, "Could not find leaf \"" << leafNameList[iLeaf] << "\" in tree #" << treeNumber);
+        }
+      }
+
+      for( size_t iLeaf = 0 ; iLeaf < leafList.size() ; iLeaf++ ){ columnList[iLeaf][iRow] = leafList[iLeaf]->GetValue(0); }
+    }
+
+    // Evaluate the cuts over the batch
+    if( cutList[0].isValid() ){ cutList[0].evalColumns(nRows, columnPtrList.data(), stackBuffer, selectionMask.data()); }
+    for( size_t iSample = 0 ; iSample < sampleCutList_.size() ; iSample++ ){
+      const double* mask{selectionMask.data()};
+      if( cutList[iSample+1].isValid() ){
+        cutList[iSample+1].evalColumns(nRows, columnPtrList.data(), stackBuffer, sampleMask.data());
+        for( size_t iRow = 0 ; iRow < nRows ; iRow++ ){ sampleMask[iRow] = ( selectionMask[iRow] != 0 and sampleMask[iRow] != 0 ); }
+        mask = sampleMask.data();
+      }
+      for( size_t iRow = 0 ; iRow < nRows ; iRow++ ){
+        if( mask[iRow] == 0 ){ _cache_.eventIsInSamplesList[iFirstEvent + Long64_t(iRow)][iSample] = false; }
+      }
+    } // iSample
+  } // iFirstEvent
+
+  return true;
+}
 void DataDispenser::fetchRequestedLeaves(){
   LogWarning << "Fetching requested leaves to extract from the trees..." << std::endl;
 
@@ -366,12 +478,11 @@ void DataDispenser::preAllocateMemory(){
   eventPlaceholder.setCommonLeafNameListPtr(std::make_shared<std::vector<std::string>>(_cache_.leavesRequestedForStorage));
   auto copyDict = eventPlaceholder.generateDict(tBuf, _parameters_.overrideLeafDict);
   eventPlaceholder.copyData(copyDict, true);
+  size_t dialCacheSize = 0;
   if( _parSetListPtrToLoad_ != nullptr ){
-    size_t dialCacheSize = 0;
     for( auto& parSet : *_parSetListPtrToLoad_ ){
       parSet.isUseOnlyOneParameterPerEvent() ? dialCacheSize++: dialCacheSize += parSet.getNbParameters();
     }
-    eventPlaceholder.getRawDialPtrList().resize(dialCacheSize);
   }
 
   _cache_.sampleIndexOffsetList.resize(_cache_.samplesToFillList.size());
@@ -383,6 +494,7 @@ void DataDispenser::preAllocateMemory(){
     _cache_.sampleEventListPtrToFill[iSample] = &container->eventList;
     _cache_.sampleIndexOffsetList[iSample] = _cache_.sampleEventListPtrToFill[iSample]->size();
     container->reserveEventMemory(_owner_->getDataSetIndex(), _cache_.sampleNbOfEvents[iSample], eventPlaceholder);
+    container->reserveDialMemory(_cache_.sampleNbOfEvents[iSample], dialCacheSize); // slices of one block per sample
   }
 
   // DIALS
@@ -428,6 +540,13 @@ void DataDispenser::preAllocateMemory(){
         }
       }
     }
+
+    // The events reference their dials by registry id
+    for( auto& dialSetPair : _cache_.dialSetPtrMap ){
+      for( auto* dialSet : dialSetPair.second ){
+        for( auto& dial : dialSet->getDialList() ){ DialRegistry::registerDial(dial.get()); }
+      }
+    }
   }
 
   LogInfo << "Current RAM is: " << GenericToolbox::parseSizeUnits(double(GenericToolbox::getProcessMemoryUsage())) << std::endl;
@@ -495,6 +614,20 @@ void DataDispenser::readAndFill(){
     evStore.setCommonLeafNameListPtr(std::make_shared<std::vector<std::string>>(_cache_.leavesRequestedForStorage));
     auto copyStoreDict = evStore.generateDict(tEventBuffer, _parameters_.overrideLeafDict);
 
+    // Apply conditions compiled once bound to the var indexes of the buffer, same ordering as _cache_.dialSetPtrMap
+    std::vector<std::vector<CompiledFormula>> applyConditionList;
+    for( auto& dialSetPair : _cache_.dialSetPtrMap ){
+      applyConditionList.emplace_back();
+      for( auto* dialSet : dialSetPair.second ){
+        applyConditionList.back().emplace_back( dialSet->getCompiledApplyCondition() );
+        auto& applyCondition = applyConditionList.back().back();
+        if( not applyCondition.isValid() ){ continue; }
+        std::vector<int> varIndexList;
+        for( auto& parName : applyCondition.getParameterNameList() ){ varIndexList.emplace_back(eventBuffer.findVarIndex(parName)); }
+        applyCondition.bindParameters(varIndexList);
+      }
+    }
+
 
     PhysicsEvent* eventPtr{nullptr};
 
@@ -512,7 +645,8 @@ void DataDispenser::readAndFill(){
     // Dials
     size_t eventDialOffset;
     DialSet* dialSetPtr;
-    size_t iDialSet, iDial;
+    size_t iDialSet, iDial, iParSet;
+    const CompiledFormula* applyConditionPtr;
     TGraph* grPtr{nullptr};
     SplineDial* spDialPtr;
     GraphDial* grDialPtr;
@@ -630,12 +764,17 @@ void DataDispenser::readAndFill(){
           // Now the event is ready. Let's index the dials:
           eventDialOffset = 0;
           // Loop over the parameter Sets (the ones which have a valid dialSet for this dataSet)
+          iParSet = 0;
           for( auto& dialSetPair : _cache_.dialSetPtrMap ){
+            auto& parSetApplyConditionList = applyConditionList[iParSet++];
             for( iDialSet = 0 ; iDialSet < dialSetPair.second.size() ; iDialSet++ ){
               dialSetPtr = dialSetPair.second[iDialSet];
 
               if( dialSetPtr->getApplyConditionFormula() != nullptr ){
-                if( eventBuffer.evalFormula(dialSetPtr->getApplyConditionFormula()) == 0 ){
+                applyConditionPtr = &parSetApplyConditionList[iDialSet];
+                if( ( applyConditionPtr->isValid() ?
+                      eventBuffer.evalFormula(*applyConditionPtr) :
+                      eventBuffer.evalFormula(dialSetPtr->getApplyConditionFormula()) ) == 0 ){
                   // next dialSet
                   continue;
                 }
@@ -653,7 +792,7 @@ void DataDispenser::readAndFill(){
                       spDialPtr->initialize();
                       spDialPtr->setIsReferenced(true);
                       // Adding dial in the event
-                      eventPtr->getRawDialPtrList()[eventDialOffset++] = spDialPtr;
+                      eventPtr->getRawDialPtrList().setDial(eventDialOffset++, spDialPtr);
                     }
                     else if( dialSetPtr->getGlobalDialType() == DialType::Graph ){
                       grDialPtr = (GraphDial*) dialSetPtr->getDialList()[iEntry].get();
@@ -662,7 +801,7 @@ void DataDispenser::readAndFill(){
                       grDialPtr->initialize();
                       grDialPtr->setIsReferenced(true);
                       // Adding dial in the event
-                      eventPtr->getRawDialPtrList()[eventDialOffset++] = grDialPtr;
+                      eventPtr->getRawDialPtrList().setDial(eventDialOffset++, grDialPtr);
                     }
                     else{
                       LogThrow("Unsupported event-by-event dial: " << DialType::DialTypeEnumNamespace::toString(dialSetPtr->getGlobalDialType()))
@@ -678,7 +817,7 @@ void DataDispenser::readAndFill(){
                     spDialPtr->initialize();
                     spDialPtr->setIsReferenced(true);
                     // Adding dial in the event
-                    eventPtr->getRawDialPtrList()[eventDialOffset++] = spDialPtr;
+                    eventPtr->getRawDialPtrList().setDial(eventDialOffset++, spDialPtr);
                   }
                   else if( dialSetPtr->getGlobalDialType() == DialType::Graph ){
                     grDialPtr = (GraphDial*) dialSetPtr->getDialList()[iEntry].get();
@@ -687,7 +826,7 @@ void DataDispenser::readAndFill(){
                     grDialPtr->initialize();
                     grDialPtr->setIsReferenced(true);
                     // Adding dial in the event
-                    eventPtr->getRawDialPtrList()[eventDialOffset++] = grDialPtr;
+                    eventPtr->getRawDialPtrList().setDial(eventDialOffset++, grDialPtr);
                   }
                   else{
                     LogThrow("Unsupported event-by-event dial: " << DialType::DialTypeEnumNamespace::toString(dialSetPtr->getGlobalDialType()))
@@ -733,7 +872,7 @@ void DataDispenser::readAndFill(){
                   // <------------------
                   if( isEventInDialBin ) {
                     dialSetPtr->getDialList()[iDial]->setIsReferenced(true);
-                    eventPtr->getRawDialPtrList()[eventDialOffset++] = dialSetPtr->getDialList()[iDial].get();
+                    eventPtr->getRawDialPtrList().setDial(eventDialOffset++, dialSetPtr->getDialList()[iDial].get());
                     break;
                   }
                 } // iDial
@@ -749,7 +888,6 @@ void DataDispenser::readAndFill(){
 
           // Resize the dialRef list
           eventPtr->getRawDialPtrList().resize(eventDialOffset);
-          eventPtr->getRawDialPtrList().shrink_to_fit();
 
         } // event has passed the selection?
       } // samples
@@ -762,11 +900,19 @@ void DataDispenser::readAndFill(){
   GlobalVariables::getParallelWorker().runJob(__METHOD_NAME__);
   GlobalVariables::getParallelWorker().removeJob(__METHOD_NAME__);
 
-  LogInfo << "Shrinking event lists..." << std::endl;
+  LogInfo << "Shrinking event lists and dial arenas..." << std::endl;
   for( size_t iSample = 0 ; iSample < _cache_.samplesToFillList.size() ; iSample++ ){
     auto* container = &_cache_.samplesToFillList[iSample]->getDataContainer();
     if(_parameters_.useMcContainer) container = &_cache_.samplesToFillList[iSample]->getMcContainer();
     container->shrinkEventList(_cache_.sampleIndexOffsetList[iSample]);
+    container->compactDialMemory();
+  }
+
+  // The event-by-event splines are only known now
+  for( auto& dialSetPair : _cache_.dialSetPtrMap ){
+    for( auto* dialSet : dialSetPair.second ){
+      if( not dialSet->getDialLeafName().empty() ){ dialSet->buildResponseTable(); }
+    }
   }
 }
 
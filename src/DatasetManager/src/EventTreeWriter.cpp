@@ -30,22 +30,39 @@ void EventTreeWriter::writeSamples(TDirectory* saveDir_) const{
 
     for( bool isData : {false, true} ) {
 
-      const auto *evListPtr = (isData ? &sample.getDataContainer().eventList : &sample.getMcContainer().eventList);
-      if (evListPtr->empty()) continue;
+      if( isData and sample.getDataContainer().isUsingFrozenColumns() ){
+        this->writeFrozenEvents(GenericToolbox::mkdirTFile(saveDir_, sample.getName()), "Data_TTree", sample.getDataContainer());
+        continue;
+      }
+
+      const auto *containerPtr = (isData ? &sample.getDataContainer() : &sample.getMcContainer());
+      if (containerPtr->eventList.empty()) continue;
 
       auto* saveDir = GenericToolbox::mkdirTFile(saveDir_, sample.getName());
 
       std::string treeName = (isData ? "Data_TTree" : "MC_TTree");
-      this->writeEvents(saveDir, treeName, *evListPtr);
+      this->writeEvents(saveDir, treeName, containerPtr->eventList, (containerPtr->isLeavesPacked() ? containerPtr : nullptr));
 
     }
   }
 
 }
-void EventTreeWriter::writeEvents(TDirectory *saveDir_, const std::string& treeName_, const std::vector<PhysicsEvent> & eventList_) const {
+void EventTreeWriter::writeEvents(TDirectory *saveDir_, const std::string& treeName_, const std::vector<PhysicsEvent> & eventList_, const SampleElement* packedContainerPtr_) const {
   LogThrowIf(saveDir_ == nullptr, "Save TDirectory is not set.");
   LogThrowIf(treeName_.empty(), "TTree name no set.");
 
+  // Packed leaves are decompressed one block at a time in a buffer event
+  PhysicsEvent leafEventBuffer;
+  std::vector<std::vector<std::vector<GenericToolbox::AnyType>>> leafBlockBuffer;
+  if( packedContainerPtr_ != nullptr ){ leafEventBuffer.setCommonLeafNameListPtr(eventList_[0].getCommonLeafNameListPtr()); }
+  auto getLeafEvent = [&](size_t iEvent_) -> const PhysicsEvent& {
+    if( packedContainerPtr_ == nullptr ){ return eventList_[iEvent_]; }
+    size_t iEventInBlock = iEvent_ % packedContainerPtr_->leafBlockSize;
+    if( iEventInBlock == 0 ){ packedContainerPtr_->unpackLeafBlock(iEvent_ / packedContainerPtr_->leafBlockSize, leafBlockBuffer); }
+    leafEventBuffer.getLeafContentList().swap(leafBlockBuffer[iEventInBlock]);
+    return leafEventBuffer;
+  };
+
   auto* oldDir = GenericToolbox::getCurrentTDirectory();
   saveDir_->cd();
 
@@ -69,14 +86,15 @@ void EventTreeWriter::writeEvents(TDirectory *saveDir_, const std::string& treeN
   tree->Branch("Event", &privateMemberArr.getRawDataArray()[0], leavesDefStr.c_str());
 
   GenericToolbox::RawDataArray loadedLeavesArr;
-  auto loadedLeavesDict = eventList_[0].generateLeavesDictionary(true);
+  const auto& firstLeafEvent = getLeafEvent(0);
+  auto loadedLeavesDict = firstLeafEvent.generateLeavesDictionary(true);
   std::vector<std::string> leafNamesList;
   leavesDefStr = "";
   for( auto& leafDef : loadedLeavesDict ){
     if( not leavesDefStr.empty() ) leavesDefStr += ":";
     leavesDefStr += leafDef.first;
     leafNamesList.emplace_back(leafDef.first.substr(0,leafDef.first.find("[")).substr(0, leafDef.first.find("/")));
-    leafDef.second(loadedLeavesArr, eventList_[0].getLeafHolder(leafNamesList.back())); // resize buffer
+    leafDef.second(loadedLeavesArr, firstLeafEvent.getLeafHolder(leafNamesList.back())); // resize buffer
   }
   loadedLeavesArr.lockArraySize();
   tree->Branch("Leaves", &loadedLeavesArr.getRawDataArray()[0], leavesDefStr.c_str());
@@ -126,6 +144,7 @@ void EventTreeWriter::writeEvents(TDirectory *saveDir_, const std::string& treeN
   std::string progressTitle = LogInfo.getPrefixString() + "Writing " + treeName_;
   size_t iEvent{0}; size_t nEvents = (eventList_.size());
   for( auto& event : eventList_ ){
+    const auto& leafEvent = getLeafEvent(iEvent);
     GenericToolbox::displayProgressBar(iEvent++,nEvents,progressTitle);
 
     privateMemberArr.resetCurrentByteOffset();
@@ -133,7 +152,7 @@ void EventTreeWriter::writeEvents(TDirectory *saveDir_, const std::string& treeN
 
     iLeaf = 0;
     loadedLeavesArr.resetCurrentByteOffset();
-    for( auto& leafDef : loadedLeavesDict ){ leafDef.second(loadedLeavesArr, event.getLeafHolder(leafNamesList[iLeaf++])); }
+    for( auto& leafDef : loadedLeavesDict ){ leafDef.second(loadedLeavesArr, leafEvent.getLeafHolder(leafNamesList[iLeaf++])); }
 
 //    if( _writeDials_ ){
 //      for( auto& spline : responseSplineList ){ *spline = flatSplinesList[iPar]; } // by default
@@ -150,3 +169,31 @@ void EventTreeWriter::writeEvents(TDirectory *saveDir_, const std::string& treeN
 
   if(oldDir != nullptr) oldDir->cd();
 }
+void EventTreeWriter::writeFrozenEvents(TDirectory *saveDir_, const std::string& treeName_, const SampleElement& container_) const {
+  // Referenced events: the leaves are the ones of MC_TTree (same ordering), only the frozen weights are specific.
+  // Compacted events: only the variables that have been kept.
+  LogThrowIf(saveDir_ == nullptr, "Save TDirectory is not set.");
+
+  auto* oldDir = GenericToolbox::getCurrentTDirectory();
+  saveDir_->cd();
+
+  auto* tree = new TTree(treeName_.c_str(), treeName_.c_str());
+  double eventWeight;
+  int sampleBinIndex;
+  tree->Branch("eventWeight", &eventWeight);
+  tree->Branch("sampleBinIndex", &sampleBinIndex);
+  std::vector<double> varValueList(container_.compactVarNameList.size(), 0);
+  for( size_t iVar = 0 ; iVar < varValueList.size() ; iVar++ ){
+    tree->Branch(container_.compactVarNameList[iVar].c_str(), &varValueList[iVar]);
+  }
+  for( size_t iEvent = 0 ; iEvent < container_.frozenWeightList.size() ; iEvent++ ){
+    eventWeight = container_.frozenWeightList[iEvent];
+    sampleBinIndex = container_.frozenBinIndexList[iEvent];
+    for( size_t iVar = 0 ; iVar < varValueList.size() ; iVar++ ){ varValueList[iVar] = container_.compactVarColumnList[iVar][iEvent]; }
+    tree->Fill();
+  }
+  tree->Write();
+  delete tree;
+
+  if(oldDir != nullptr) oldDir->cd();
+}
@@ -39,6 +39,7 @@ public:
   static bool enableMaskCheck;
   static bool disableDialCache;
   static bool throwIfResponseIsNegative;
+  static bool useResponseKernels; // if disabled, every evaluation goes through the generic checks (debug)
 
 protected:
   // Not supposed to define a bare Dial. Use the downcast instead
@@ -53,6 +54,7 @@ public:
   void setApplyConditionBin(DataBin *applyConditionBin);
   void setIsReferenced(bool isReferenced);
   void setOwner(const DialSet* dialSetPtr);
+  void setRegistryId(uint32_t registryId_);
 
   virtual void initialize();
 
@@ -64,6 +66,7 @@ public:
   DialType::DialType getDialType() const;
   const DataBin* getApplyConditionBinPtr() const;
   const DialSet* getOwner() const;
+  uint32_t getRegistryId() const;
 
   // getters
   DataBin* getApplyConditionBinPtr();
@@ -72,6 +75,7 @@ public:
   double getEffectiveDialParameter(double parameterValue_);
   double capDialResponse(double response_);
   double evalResponse();
+  double calcResponse(double parameterValue_); // bypasses the response cache: can be called concurrently for any value
 
   // virtual
   virtual double calcDial(double parameterValue_) = 0;
@@ -96,6 +100,7 @@ protected:
   // Internals
   GenericToolbox::NoCopyWrapper<std::mutex> _evalDialLock_;
   bool _isReferenced_{false};
+  uint32_t _registryId_{0xFFFFFFFF}; // see DialRegistry
   double _dialResponseCache_{std::nan("unset")};
   double _dialParameterCache_{std::nan("unset")};
 
@@ -0,0 +1,39 @@
+//
+// DialRegistry.h
+//
+
+#ifndef GUNDAM_DIALREGISTRY_H
+#define GUNDAM_DIALREGISTRY_H
+
+#include "Dial.h"
+
+#include "array"
+#include "vector"
+#include "cstdint"
+
+
+// Dense 32-bit ids of the dials referenced by the events: the high bits hold the dial type and the low bits the
+// index of the dial in the pool of its type. Events store these ids instead of Dial pointers.
+class DialRegistry{
+
+public:
+  static constexpr uint32_t invalidId{0xFFFFFFFF};
+  static constexpr int nbTypeBits{2};
+  static constexpr uint32_t indexMask{(uint32_t(1) << (32 - nbTypeBits)) - 1};
+
+  // Not thread safe: the dials are registered before the events are filled
+  static uint32_t registerDial(Dial* dialPtr_);
+  // Forgets every dial: the ids held by the events are invalid afterwards
+  static void reset();
+
+  static Dial* getDial(uint32_t id_){ return ( id_ == invalidId ? nullptr : _poolList_[id_ >> (32 - nbTypeBits)][id_ & indexMask] ); }
+  static DialType::DialType getDialType(uint32_t id_){ return DialType::DialType(id_ >> (32 - nbTypeBits)); }
+  static const std::vector<Dial*>& getPool(DialType::DialType dialType_);
+
+private:
+  static std::array<std::vector<Dial*>, size_t(1) << nbTypeBits> _poolList_; // [dialType][index]
+
+};
+
+
+#endif //GUNDAM_DIALREGISTRY_H
@@ -8,6 +8,7 @@
 #include "DialWrapper.h"
 #include "DataBinSet.h"
 #include "GlobalVariables.h"
+#include "CompiledFormula.h"
 
 #include "GenericToolbox.h"
 
@@ -17,9 +18,11 @@
 #include "string"
 #include "vector"
 #include "memory"
+#include "array"
 
 
 class FitParameter;
+class SplineDial;
 
 class DialSet {
 
@@ -35,8 +38,8 @@ public:
   void setOwner(const FitParameter* owner_);
   void setConfig(const nlohmann::json &config_);
 
-  void setMinDialResponse(double minDialResponse_){ _minDialResponse_ = minDialResponse_; }
-  void setMaxDialResponse(double maxDialResponse_){ _maxDialResponse_ = maxDialResponse_; }
+  void setMinDialResponse(double minDialResponse_){ _minDialResponse_ = minDialResponse_; this->selectResponseKernels(); }
+  void setMaxDialResponse(double maxDialResponse_){ _maxDialResponse_ = maxDialResponse_; this->selectResponseKernels(); }
 
   void initialize();
 
@@ -45,6 +48,7 @@ public:
   std::vector<DialWrapper> &getDialList();
   const std::vector<std::string> &getDataSetNameList() const;
   TFormula *getApplyConditionFormula() const;
+  const CompiledFormula& getCompiledApplyCondition() const { return _compiledApplyCondition_; }
   const std::string &getDialLeafName() const;
   const std::string &getDialSubType() const;
   DialType::DialType getGlobalDialType() const;
@@ -59,12 +63,25 @@ public:
 
   bool isAllowDialExtrapolation() const;
 
+  // Response kernels: evaluation specialized for the options of this set, chosen once initialized
+  typedef double (*ResponseKernel)(Dial& dial_, const DialSet& dialSet_, double parameterValue_);
+  ResponseKernel getResponseKernel(DialType::DialType dialType_) const { return _responseKernelList_[dialType_]; }
+
+  // Tabulated spline responses (opt-in): linear interpolation on a uniform grid instead of the exact spline
+  bool isResponseTabulated() const { return not _responseTable_.empty(); }
+  void buildResponseTable();
+
   // Core
   std::string getSummary() const;
   void applyGlobalParameters(Dial* dial_) const;
   void applyGlobalParameters(Dial& dial_) const;
 
 protected:
+  void selectResponseKernels();
+  template<typename DialClass, bool isTabulated_, bool isMirrored_, bool isCapped_, bool allowExtrapolation_>
+  static double evalResponseKernel(Dial& dial_, const DialSet& dialSet_, double parameterValue_);
+  template<bool allowExtrapolation_> double evalResponseTable(SplineDial& dial_, double parameterValue_) const;
+
   void readGlobals(const nlohmann::json &config_);
   bool initializeNormDialsWithParBinning();
   bool initializeDialsWithDefinition();
@@ -79,6 +96,7 @@ private:
   bool _isEnabled_{true};
   std::string _applyConditionStr_;
   std::shared_ptr<TFormula> _applyConditionFormula_{nullptr};
+  CompiledFormula _compiledApplyCondition_{}; // not valid: the TFormula is used
 
   // Internals
   bool _enableDialsSummary_{false};
@@ -100,6 +118,16 @@ private:
 
   bool _allowDialExtrapolation_{false};
 
+  std::array<ResponseKernel, 3> _responseKernelList_{}; // [dialType], nullptr until initialized
+
+  // Spline responses sampled on nodes x_k = min + k*step. Node-major: the values of every tabulated dial at one node
+  // are contiguous, so dials of this set evaluated one after the other read neighbouring memory.
+  int _responseTableNbPoints_{0}; // 0: exact evaluation
+  double _responseTableMin_{std::nan("unset")};
+  double _responseTableStep_{std::nan("unset")};
+  size_t _nbTabulatedDials_{0};
+  std::vector<double> _responseTable_{}; // [iNode * _nbTabulatedDials_ + iTabulatedDial]
+
   std::vector<DataBinSet> _binningCacheList_;
 
 };
@@ -66,6 +66,7 @@ public:
   // Core
   size_t getNbParameters() const;
   double getPenaltyChi2();
+  TMatrixD getPenaltyHessian() const; // d2(penalty)/dpi.dpj w.r.t. the effective parameter list
 
   // Throw / Shifts
   void moveFitParametersToPrior();
@@ -98,6 +99,13 @@ protected:
   void defineParameters();
 
   void fillDeltaParameterList();
+  void buildWhitenedPenalty();
+
+  // Decomposition cache
+  void defineDecompositionCacheKey();
+  TObject* readDecompositionCache(const std::string& objName_) const; // nullptr if not available, owned by the caller
+  void writeDecompositionCache(const TObject* obj_, const std::string& objName_) const;
+  double evalWhitenedPenaltyChi2();
 
 private:
   // User parameters
@@ -157,6 +165,19 @@ private:
 
   std::shared_ptr<TMatrixD> _choleskyMatrix_{nullptr};
 
+  // Decompositions stored on disk, keyed by a hash of the stripped matrix and the parameter mask
+  std::string _decompositionCacheFolder_{};
+  std::string _decompositionCacheKey_{};
+
+  // Whitened penalty: C = U^T.U (Cholesky), z = U^{-T}.delta -> chi2 = |z|^2
+  // Row j of U^{-1} is the response of z to delta_j: one moved parameter costs O(N)
+  bool _useWhitenedPenalty_{true};
+  int _maxNbIncrementalPenaltyUpdates_{1000}; // full refresh after that to limit rounding drift
+  int _nbIncrementalPenaltyUpdates_{0};
+  std::shared_ptr<TMatrixD> _choleskyUpperInverse_{nullptr};
+  std::vector<double> _whitenedDeltaList_{};
+  std::vector<double> _lastDeltaList_{};
+
 };
 
 
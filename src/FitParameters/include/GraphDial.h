@@ -8,6 +8,10 @@
 #include "TGraph.h"
 
 #include "Dial.h"
+#include "CalculateGraph.h"
+
+#include "vector"
+#include "limits"
 
 class GraphDial : public Dial {
 
@@ -21,12 +25,30 @@ public:
 
   void initialize() override;
 
+  int getNbPoints() const { return int(_graphData_.size() / 2); }
+  // Packed as CalculateGraph expects it: { extrapolate, y0, x0, y1, x1, ... }
+  const std::vector<double>& getGraphData() const { return _graphData_; }
+
   double calcDial(double parameterValue_) override;
+  template<bool allowExtrapolation_> double evalDial(double parameterValue_); // non-virtual, used by the response kernels
   std::string getSummary() override;
 
 private:
-  TGraph _graph_;
+  // The sorted points of the input graph, flattened at load: the TGraph is not kept
+  std::vector<double> _graphData_{};
 };
 
 
+
+template<bool allowExtrapolation_> double GraphDial::evalDial(double parameterValue_){
+  if( not allowExtrapolation_ ){
+    if     (parameterValue_ <= _graphData_[2])                      { return _graphData_[1]; }
+    else if(parameterValue_ >= _graphData_[_graphData_.size() - 1]) { return _graphData_[_graphData_.size() - 2]; }
+  }
+  return CalculateGraph(
+      parameterValue_, -std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(),
+      _graphData_.data(), int(_graphData_.size())
+  );
+}
+
 #endif //GUNDAM_GRAPHDIAL_H
@@ -8,6 +8,7 @@
 #include "Dial.h"
 
 #include "JsonUtils.h"
+#include "CompiledFormula.h"
 
 #include "nlohmann/json.hpp"
 #include "TFormula.h"
@@ -41,6 +42,7 @@ private:
 
   std::vector<Dial*> _dialRefList_{};
   TFormula _evalFormula_{};
+  CompiledFormula _compiledEvalFormula_{}; // x[i] = response of dial i, not valid: the TFormula is used
   TFormula _applyConditionFormula_{};
 
   std::vector<double> _dialResponsesCache_{};
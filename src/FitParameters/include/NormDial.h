@@ -21,6 +21,7 @@ public:
 
   double evalResponse(double parameterValue_) override;
   double calcDial(double parameterValue_) override;
+  template<bool allowExtrapolation_> double evalDial(double parameterValue_){ return parameterValue_; } // used by the response kernels
 
   std::string getSummary() override;
 
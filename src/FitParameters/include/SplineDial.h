@@ -29,6 +29,12 @@ public:
   std::string getSummary() override;
 
   double calcDial(double parameterValue_) override;
+  template<bool allowExtrapolation_> double evalDial(double parameterValue_); // non-virtual, used by the response kernels
+  double evalSpline(double parameterValue_);
+
+  bool isSplineValid() const { return _spline_.GetXmin() != _spline_.GetXmax(); }
+  void setResponseTableIndex(int responseTableIndex_){ _responseTableIndex_ = responseTableIndex_; }
+  int getResponseTableIndex() const { return _responseTableIndex_; }
 
   // Debug
   void writeSpline(const std::string &fileName_) const override;
@@ -42,6 +48,8 @@ protected:
   // The representation of the spline read from a root input file.
   TSpline3 _spline_;
 
+  int _responseTableIndex_{-1}; // column in the response table of the owner DialSet, -1 if not tabulated
+
 #ifdef ENABLE_SPLINE_DIAL_FAST_EVAL
   struct FastSpliner{
     double x, y, b, c, d, num;
@@ -93,4 +101,13 @@ protected:
   // DEBUG
 
 };
+
+template<bool allowExtrapolation_> double SplineDial::evalDial(double parameterValue_){
+  if( not allowExtrapolation_ ){
+    if     (parameterValue_ <= _spline_.GetXmin()) { parameterValue_ = _spline_.GetXmin(); }
+    else if(parameterValue_ >= _spline_.GetXmax()) { parameterValue_ = _spline_.GetXmax(); }
+  }
+  return this->evalSpline(parameterValue_);
+}
+
 #endif //GUNDAM_SPLINEDIAL_H
@@ -19,6 +19,7 @@ LoggerInit([]{
 bool Dial::enableMaskCheck{false};
 bool Dial::disableDialCache{false};
 bool Dial::throwIfResponseIsNegative{true};
+bool Dial::useResponseKernels{true};
 
 Dial::Dial(DialType::DialType dialType_) : _dialType_{dialType_} {}
 Dial::~Dial() = default;
@@ -38,6 +39,9 @@ void Dial::setIsReferenced(bool isReferenced) {
 void Dial::setOwner(const DialSet* dialSetPtr) {
   _owner_ = dialSetPtr;
 }
+void Dial::setRegistryId(uint32_t registryId_) {
+  _registryId_ = registryId_;
+}
 
 void Dial::initialize() {
   LogThrowIf( _dialType_ == DialType::Invalid, "_dialType_ is not set." )
@@ -63,6 +67,9 @@ const DialSet* Dial::getOwner() const {
 const DataBin* Dial::getApplyConditionBinPtr() const{ return _applyConditionBin_; }
 
 DataBin* Dial::getApplyConditionBinPtr(){ return _applyConditionBin_; }
+uint32_t Dial::getRegistryId() const {
+  return _registryId_;
+}
 DialType::DialType Dial::getDialType() const {
   return _dialType_;
 }
@@ -99,6 +106,13 @@ double Dial::capDialResponse(double response_){
 
   return response_;
 }
+double Dial::calcResponse(double parameterValue_){
+  if( Dial::useResponseKernels ){
+    auto kernel = _owner_->getResponseKernel(_dialType_);
+    if( kernel != nullptr ){ return kernel(*this, *_owner_, parameterValue_); }
+  }
+  return this->capDialResponse(this->calcDial(this->getEffectiveDialParameter(parameterValue_)));
+}
 double Dial::evalResponse(){
   return this->evalResponse( _owner_->getOwner()->getParameterValue() );
 }
@@ -106,7 +120,7 @@ double Dial::evalResponse(){
 // Virtual
 double Dial::evalResponse(double parameterValue_) {
   if( Dial::disableDialCache ){
-    return this->capDialResponse(this->calcDial(this->getEffectiveDialParameter(parameterValue_)));
+    return this->calcResponse(parameterValue_);
   }
 
   // Check if all is already up-to-date
@@ -121,7 +135,7 @@ double Dial::evalResponse(double parameterValue_) {
   if( _dialParameterCache_ == parameterValue_ ) return _dialResponseCache_; // stop if already updated by another threads
 
   // Edit the cache
-  _dialResponseCache_ = this->capDialResponse(this->calcDial(this->getEffectiveDialParameter(parameterValue_)));
+  _dialResponseCache_ = this->calcResponse(parameterValue_);
   _dialParameterCache_ = parameterValue_;
 
   return _dialResponseCache_;
@@ -0,0 +1,43 @@
+//
+// DialRegistry.cpp
+//
+
+#include "DialRegistry.h"
+
+#include "Logger.h"
+
+
+LoggerInit([]{
+  Logger::setUserHeaderStr("[DialRegistry]");
+});
+
+std::array<std::vector<Dial*>, size_t(1) << DialRegistry::nbTypeBits> DialRegistry::_poolList_{};
+
+uint32_t DialRegistry::registerDial(Dial* dialPtr_){
+  LogThrowIf(dialPtr_ == nullptr, "Can't register a null dial.");
+
+  int dialType = int(dialPtr_->getDialType());
+  LogThrowIf(dialType < 0 or dialType >= int(_poolList_.size()), "Invalid dial type: " << dialType);
+  auto& pool = _poolList_[dialType];
+
+  // already registered? (clones carry the id of their source, ids from before a reset() are stale)
+  uint32_t id = dialPtr_->getRegistryId();
+  if( id != invalidId and getDialType(id) == dialPtr_->getDialType()
+      and (id & indexMask) < pool.size() and pool[id & indexMask] == dialPtr_ ){ return id; }
+
+  LogThrowIf(pool.size() > indexMask, "Too many dials of type " << DialType::DialTypeEnumNamespace::toString(dialPtr_->getDialType()));
+
+  id = ( uint32_t(dialType) << (32 - nbTypeBits) ) | uint32_t(pool.size());
+  pool.emplace_back(dialPtr_);
+  dialPtr_->setRegistryId(id);
+  return id;
+}
+void DialRegistry::reset(){
+  // the dials may already be gone: their ids are left as they are and recognized as stale by registerDial()
+  for( auto& pool : _poolList_ ){ std::vector<Dial*>().swap(pool); }
+}
+
+const std::vector<Dial*>& DialRegistry::getPool(DialType::DialType dialType_){
+  LogThrowIf(int(dialType_) < 0 or int(dialType_) >= int(_poolList_.size()), "Invalid dial type: " << int(dialType_));
+  return _poolList_[dialType_];
+}
@@ -73,6 +73,9 @@ void DialSet::initialize() {
     _isEnabled_ = false;
   }
 
+  // event-by-event splines are tabulated once loaded
+  if( _globalDialLeafName_.empty() ){ this->buildResponseTable(); }
+  else{ this->selectResponseKernels(); }
 
 }
 
@@ -116,6 +119,133 @@ double DialSet::getMirrorRange() const {
   return _mirrorRange_;
 }
 
+template<typename DialClass, bool isTabulated_, bool isMirrored_, bool isCapped_, bool allowExtrapolation_>
+double DialSet::evalResponseKernel(Dial& dial_, const DialSet& dialSet_, double parameterValue_){
+  if( isMirrored_ ){
+    parameterValue_ = std::abs(std::fmod(parameterValue_ - dialSet_._mirrorLowEdge_, 2 * dialSet_._mirrorRange_));
+    if( parameterValue_ > dialSet_._mirrorRange_ ){ parameterValue_ = 2 * dialSet_._mirrorRange_ - parameterValue_; }
+    parameterValue_ += dialSet_._mirrorLowEdge_;
+  }
+
+  double response = isTabulated_ ?
+      dialSet_.evalResponseTable<allowExtrapolation_>(static_cast<SplineDial&>(dial_), parameterValue_) :
+      static_cast<DialClass&>(dial_).template evalDial<allowExtrapolation_>(parameterValue_);
+
+  if( isCapped_ ){
+    if     ( dialSet_._minDialResponse_ == dialSet_._minDialResponse_ and response < dialSet_._minDialResponse_ ){ response = dialSet_._minDialResponse_; }
+    else if( dialSet_._maxDialResponse_ == dialSet_._maxDialResponse_ and response > dialSet_._maxDialResponse_ ){ response = dialSet_._maxDialResponse_; }
+  }
+
+  // NaN or negative: the full checks only run on this rare branch
+  if( not ( response >= 0 ) ){ return dial_.capDialResponse(response); }
+  return response;
+}
+template<bool allowExtrapolation_>
+double DialSet::evalResponseTable(SplineDial& dial_, double parameterValue_) const{
+  double nodeCoordinate = (parameterValue_ - _responseTableMin_) / _responseTableStep_;
+
+  // not tabulated or out of the grid: exact spline
+  if( dial_.getResponseTableIndex() == -1 or not ( nodeCoordinate >= 0 ) or nodeCoordinate > _responseTableNbPoints_ - 1 ){
+    return dial_.evalDial<allowExtrapolation_>(parameterValue_);
+  }
+
+  auto iNode = size_t(nodeCoordinate);
+  if( iNode == size_t(_responseTableNbPoints_ - 1) ){ iNode--; } // last node
+  const double* nodeValue = &_responseTable_[iNode * _nbTabulatedDials_ + dial_.getResponseTableIndex()];
+  return nodeValue[0] + (nodeCoordinate - double(iNode)) * (nodeValue[_nbTabulatedDials_] - nodeValue[0]);
+}
+void DialSet::selectResponseKernels(){
+  bool isCapped = ( _minDialResponse_ == _minDialResponse_ or _maxDialResponse_ == _maxDialResponse_ );
+
+#define SELECT_RESPONSE_KERNEL(DialClass, isTabulated) \
+  ( _useMirrorDial_ ? \
+    ( isCapped ? \
+      ( _allowDialExtrapolation_ ? &DialSet::evalResponseKernel<DialClass, isTabulated, true, true, true> : &DialSet::evalResponseKernel<DialClass, isTabulated, true, true, false> ) : \
+      ( _allowDialExtrapolation_ ? &DialSet::evalResponseKernel<DialClass, isTabulated, true, false, true> : &DialSet::evalResponseKernel<DialClass, isTabulated, true, false, false> ) ) : \
+    ( isCapped ? \
+      ( _allowDialExtrapolation_ ? &DialSet::evalResponseKernel<DialClass, isTabulated, false, true, true> : &DialSet::evalResponseKernel<DialClass, isTabulated, false, true, false> ) : \
+      ( _allowDialExtrapolation_ ? &DialSet::evalResponseKernel<DialClass, isTabulated, false, false, true> : &DialSet::evalResponseKernel<DialClass, isTabulated, false, false, false> ) ) )
+
+  _responseKernelList_[DialType::Norm] = SELECT_RESPONSE_KERNEL(NormDial, false);
+  _responseKernelList_[DialType::Spline] = this->isResponseTabulated() ? SELECT_RESPONSE_KERNEL(SplineDial, true) : SELECT_RESPONSE_KERNEL(SplineDial, false);
+  _responseKernelList_[DialType::Graph] = SELECT_RESPONSE_KERNEL(GraphDial, false);
+
+#undef SELECT_RESPONSE_KERNEL
+}
+void DialSet::buildResponseTable(){
+  _responseTable_.clear();
+  _nbTabulatedDials_ = 0;
+
+  if( _responseTableNbPoints_ == 0 or not Dial::useResponseKernels ){
+    this->selectResponseKernels();
+    return;
+  }
+  LogThrowIf(_responseTableNbPoints_ < 2, "Invalid tabulatedResponseNbPoints: " << _responseTableNbPoints_)
+
+  std::vector<SplineDial*> splineList;
+  double xMin{std::nan("unset")};
+  double xMax{std::nan("unset")};
+  for( auto& dial : _dialList_ ){
+    if( dial->getDialType() != DialType::Spline ){ continue; }
+    auto* spline = static_cast<SplineDial*>(dial.get());
+    spline->setResponseTableIndex(-1);
+    if( not spline->isSplineValid() ){ continue; } // event-by-event dial left empty
+    spline->setResponseTableIndex(int(splineList.size()));
+    splineList.emplace_back(spline);
+    if( not ( xMin <= spline->getSplinePtr()->GetXmin() ) ){ xMin = spline->getSplinePtr()->GetXmin(); }
+    if( not ( xMax >= spline->getSplinePtr()->GetXmax() ) ){ xMax = spline->getSplinePtr()->GetXmax(); }
+  }
+  if( splineList.empty() ){
+    this->selectResponseKernels();
+    return;
+  }
+
+  // Grid over the allowed range of the dial parameter: the mirrored value never leaves the mirror edges, otherwise
+  // the parameter limits if any are set, or the knots range of the splines
+  if( _useMirrorDial_ ){
+    xMin = _mirrorLowEdge_;
+    xMax = _mirrorHighEdge_;
+  }
+  else if( _owner_->getMinValue() == _owner_->getMinValue() and _owner_->getMaxValue() == _owner_->getMaxValue() ){
+    xMin = _owner_->getMinValue();
+    xMax = _owner_->getMaxValue();
+  }
+  LogThrowIf(not ( xMax > xMin ), "Invalid range to tabulate the responses of " << _owner_->getFullTitle() << ": [" << xMin << ", " << xMax << "]")
+
+  _nbTabulatedDials_ = splineList.size();
+  _responseTableMin_ = xMin;
+  _responseTableStep_ = (xMax - xMin) / double(_responseTableNbPoints_ - 1);
+  _responseTable_.resize(size_t(_responseTableNbPoints_) * _nbTabulatedDials_);
+  for( int iNode = 0 ; iNode < _responseTableNbPoints_ ; iNode++ ){
+    double x = _responseTableMin_ + iNode * _responseTableStep_;
+    double* nodeValueList = &_responseTable_[iNode * _nbTabulatedDials_];
+    for( size_t iDial = 0 ; iDial < _nbTabulatedDials_ ; iDial++ ){
+      nodeValueList[iDial] = ( _allowDialExtrapolation_ ? splineList[iDial]->evalDial<true>(x) : splineList[iDial]->evalDial<false>(x) );
+    }
+  }
+
+  // Interpolation error against the exact splines, largest in the middle of the grid intervals
+  double maxError{0};
+  double maxErrorX{_responseTableMin_};
+  for( int iNode = 0 ; iNode < _responseTableNbPoints_ - 1 ; iNode++ ){
+    double x = _responseTableMin_ + (iNode + 0.5) * _responseTableStep_;
+    for( auto* spline : splineList ){
+      double error = std::abs(
+          ( _allowDialExtrapolation_ ? this->evalResponseTable<true>(*spline, x) : this->evalResponseTable<false>(*spline, x) )
+          - ( _allowDialExtrapolation_ ? spline->evalDial<true>(x) : spline->evalDial<false>(x) )
+      );
+      if( error > maxError ){ maxError = error; maxErrorX = x; }
+    }
+  }
+
+  LogInfo << _owner_->getFullTitle() << ": " << _nbTabulatedDials_ << " spline responses tabulated on "
+          << _responseTableNbPoints_ << " points in [" << xMin << ", " << xMax << "] ("
+          << GenericToolbox::parseSizeUnits(double(_responseTable_.size() * sizeof(double)))
+          << "), max |error| = " << maxError << " at x = " << maxErrorX << std::endl;
+
+  this->selectResponseKernels();
+}
+
 std::string DialSet::getSummary() const {
   std::stringstream ss;
   ss << "DialSet: Datasets: " << GenericToolbox::parseVectorAsString(_dataSetNameList_);
@@ -253,6 +383,11 @@ void DialSet::readGlobals(const nlohmann::json &config_){
     _applyConditionFormula_ = std::make_shared<TFormula>("_applyConditionFormula_", _applyConditionStr_.c_str());
     LogThrowIf(not _applyConditionFormula_->IsValid(),
                "\"" << _applyConditionStr_ << "\": could not be parsed as formula expression.")
+
+    if( not _compiledApplyCondition_.compile(_applyConditionStr_) ){
+      LogWarning << "\"" << _applyConditionStr_ << "\": " << _compiledApplyCondition_.getErrorMessage()
+                 << ", falling back to TFormula evaluation." << std::endl;
+    }
   }
 
   _minDialResponse_ = JsonUtils::fetchValue(config_, {{"minDialResponse"}, {"minimumSplineResponse"}}, _minDialResponse_);
@@ -267,6 +402,8 @@ void DialSet::readGlobals(const nlohmann::json &config_){
   }
 
   _allowDialExtrapolation_ = JsonUtils::fetchValue(config_, "allowDialExtrapolation", _allowDialExtrapolation_);
+
+  _responseTableNbPoints_ = JsonUtils::fetchValue(config_, "tabulatedResponseNbPoints", _responseTableNbPoints_);
 }
 bool DialSet::initializeNormDialsWithParBinning() {
 
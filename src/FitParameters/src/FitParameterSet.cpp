@@ -5,6 +5,7 @@
 #include "FitParameterSet.h"
 
 #include <memory>
+#include <algorithm>
 #include "JsonUtils.h"
 #include "GlobalVariables.h"
 
@@ -13,6 +14,12 @@
 #include "GenericToolbox.TablePrinter.h"
 #include "Logger.h"
 
+#include "TDecompChol.h"
+#include "TMD5.h"
+#include "TSystem.h"
+
+#include <cstdio>
+
 LoggerInit([]{
   Logger::setUserHeaderStr("[FitParameterSet]");
 } );
@@ -34,6 +41,7 @@ void FitParameterSet::reset() {
   _parameterPriorList_ = nullptr;
   _parameterNamesList_ = nullptr;
   _choleskyMatrix_ = nullptr;
+  _choleskyUpperInverse_ = nullptr;
 
   _parameterList_.clear();
 
@@ -88,23 +96,36 @@ void FitParameterSet::prepareFitParameters(){
   }
   _deltaParameterList_ = std::make_shared<TVectorD>(_strippedCovarianceMatrix_->GetNrows());
 
+  if( not _decompositionCacheFolder_.empty() ){ this->defineDecompositionCacheKey(); }
+
   if( not _useEigenDecompInFit_ ){
-    LogWarning << "Computing inverse of the stripped covariance matrix: "
-               << _strippedCovarianceMatrix_->GetNcols() << "x"
-               << _strippedCovarianceMatrix_->GetNrows() << std::endl;
-    _inverseStrippedCovarianceMatrix_ = std::shared_ptr<TMatrixD>((TMatrixD*)(_strippedCovarianceMatrix_->Clone()));
-    _inverseStrippedCovarianceMatrix_->Invert();
+    _inverseStrippedCovarianceMatrix_ = std::shared_ptr<TMatrixD>((TMatrixD*) this->readDecompositionCache("inverseStrippedCovarianceMatrix"));
+    if( _inverseStrippedCovarianceMatrix_ == nullptr ){
+      LogWarning << "Computing inverse of the stripped covariance matrix: "
+                 << _strippedCovarianceMatrix_->GetNcols() << "x"
+                 << _strippedCovarianceMatrix_->GetNrows() << std::endl;
+      _inverseStrippedCovarianceMatrix_ = std::shared_ptr<TMatrixD>((TMatrixD*)(_strippedCovarianceMatrix_->Clone()));
+      _inverseStrippedCovarianceMatrix_->Invert();
+      this->writeDecompositionCache(_inverseStrippedCovarianceMatrix_.get(), "inverseStrippedCovarianceMatrix");
+    }
+
+    if( _useWhitenedPenalty_ ){ this->buildWhitenedPenalty(); }
   }
   else {
     LogWarning << "Decomposing the stripped covariance matrix in set: " << getName() << std::endl;
     _eigenParameterList_.resize(_strippedCovarianceMatrix_->GetNrows());
 
-    _eigenDecomp_     = std::make_shared<TMatrixDSymEigen>(*_strippedCovarianceMatrix_);
-
     // Used for base swapping
-    _eigenValues_     = std::shared_ptr<TVectorD>( (TVectorD*) _eigenDecomp_->GetEigenValues().Clone() );
-    _eigenValuesInv_  = std::shared_ptr<TVectorD>( (TVectorD*) _eigenDecomp_->GetEigenValues().Clone() );
-    _eigenVectors_    = std::shared_ptr<TMatrixD>( (TMatrixD*) _eigenDecomp_->GetEigenVectors().Clone() );
+    _eigenValues_     = std::shared_ptr<TVectorD>( (TVectorD*) this->readDecompositionCache("eigenValues") );
+    _eigenVectors_    = std::shared_ptr<TMatrixD>( (TMatrixD*) this->readDecompositionCache("eigenVectors") );
+    if( _eigenValues_ == nullptr or _eigenVectors_ == nullptr ){
+      _eigenDecomp_     = std::make_shared<TMatrixDSymEigen>(*_strippedCovarianceMatrix_);
+      _eigenValues_     = std::shared_ptr<TVectorD>( (TVectorD*) _eigenDecomp_->GetEigenValues().Clone() );
+      _eigenVectors_    = std::shared_ptr<TMatrixD>( (TMatrixD*) _eigenDecomp_->GetEigenVectors().Clone() );
+      this->writeDecompositionCache(_eigenValues_.get(), "eigenValues");
+      this->writeDecompositionCache(_eigenVectors_.get(), "eigenVectors");
+    }
+    _eigenValuesInv_  = std::shared_ptr<TVectorD>( (TVectorD*) _eigenValues_->Clone() );
     _eigenVectorsInv_ = std::make_shared<TMatrixD>(TMatrixD::kTransposed, *_eigenVectors_ );
 
     double eigenCumulative = 0;
@@ -146,20 +167,33 @@ void FitParameterSet::prepareFitParameters(){
 
     } // iEigen
 
-    TMatrixD* eigenStateMatrix    = GenericToolbox::makeDiagonalMatrix(eigenState);
-    TMatrixD* diagInvMatrix = GenericToolbox::makeDiagonalMatrix(_eigenValuesInv_.get());
+    // the eigen truncation options are part of the cache key
+    std::shared_ptr<TMatrixD> cachedProjector( (TMatrixD*) this->readDecompositionCache("projectorMatrix") );
+    std::shared_ptr<TMatrixD> cachedInverse( (TMatrixD*) this->readDecompositionCache("inverseStrippedCovarianceMatrix") );
+    if( cachedProjector != nullptr and cachedInverse != nullptr ){
+      _projectorMatrix_ = cachedProjector;
+      _inverseStrippedCovarianceMatrix_ = cachedInverse;
+    }
+    else{
+      TMatrixD* eigenStateMatrix    = GenericToolbox::makeDiagonalMatrix(eigenState);
+      TMatrixD* diagInvMatrix = GenericToolbox::makeDiagonalMatrix(_eigenValuesInv_.get());
 
-    (*_projectorMatrix_) =  (*_eigenVectors_);
-    (*_projectorMatrix_) *= (*eigenStateMatrix);
-    (*_projectorMatrix_) *= (*_eigenVectorsInv_);
+      (*_projectorMatrix_) =  (*_eigenVectors_);
+      (*_projectorMatrix_) *= (*eigenStateMatrix);
+      (*_projectorMatrix_) *= (*_eigenVectorsInv_);
 
-    (*_inverseStrippedCovarianceMatrix_) =  (*_eigenVectors_);
-    (*_inverseStrippedCovarianceMatrix_) *= (*diagInvMatrix);
-    (*_inverseStrippedCovarianceMatrix_) *= (*_eigenVectorsInv_);
+      (*_inverseStrippedCovarianceMatrix_) =  (*_eigenVectors_);
+      (*_inverseStrippedCovarianceMatrix_) *= (*diagInvMatrix);
+      (*_inverseStrippedCovarianceMatrix_) *= (*_eigenVectorsInv_);
+
+      this->writeDecompositionCache(_projectorMatrix_.get(), "projectorMatrix");
+      this->writeDecompositionCache(_inverseStrippedCovarianceMatrix_.get(), "inverseStrippedCovarianceMatrix");
+
+      delete eigenStateMatrix;
+      delete diagInvMatrix;
+    }
 
     delete eigenState;
-    delete eigenStateMatrix;
-    delete diagInvMatrix;
 
     LogWarning << "Eigen decomposition with " << _nbEnabledEigen_ << " / " << _eigenValues_->GetNrows() << " vectors" << std::endl;
     if(_nbEnabledEigen_ != _eigenValues_->GetNrows() ){
@@ -252,6 +286,9 @@ double FitParameterSet::getPenaltyChi2() {
         chi2 += TMath::Sq( (eigenPar.getParameterValue() - eigenPar.getPriorValue()) / eigenPar.getStdDevValue() ) ;
       }
     }
+    else if( _choleskyUpperInverse_ != nullptr ){
+      chi2 = this->evalWhitenedPenaltyChi2();
+    }
     else{
       // make delta vector
       this->fillDeltaParameterList();
@@ -264,6 +301,39 @@ double FitParameterSet::getPenaltyChi2() {
   return chi2;
 }
 
+TMatrixD FitParameterSet::getPenaltyHessian() const{
+  // The penalty is quadratic: its Hessian does not depend on the current parameter values
+  const auto& parList = this->getEffectiveParameterList();
+  TMatrixD out(int(parList.size()), int(parList.size()));
+
+  if( not _isEnabled_ or _priorCovarianceMatrix_ == nullptr ){ return out; }
+
+  if( _useEigenDecompInFit_ ){
+    for( int iEigen = 0 ; iEigen < int(_eigenParameterList_.size()) ; iEigen++ ){
+      if( _eigenParameterList_[iEigen].isFixed() ) continue;
+      out[iEigen][iEigen] = 2. / TMath::Sq(_eigenParameterList_[iEigen].getStdDevValue());
+    }
+  }
+  else{
+    // map the stripped indices (as in fillDeltaParameterList) back to the parameter list
+    std::vector<int> strippedToParIndex;
+    for( int iPar = 0 ; iPar < int(_parameterList_.size()) ; iPar++ ){
+      const auto& par = _parameterList_[iPar];
+      if( par.isEnabled() and not par.isFixed() and not par.isFree() ){ strippedToParIndex.emplace_back(iPar); }
+    }
+    LogThrowIf(int(strippedToParIndex.size()) != _inverseStrippedCovarianceMatrix_->GetNrows(),
+               "Stripped covariance matrix doesn't match the number of fitted parameters in " << getName())
+
+    for( int iStripped = 0 ; iStripped < int(strippedToParIndex.size()) ; iStripped++ ){
+      for( int jStripped = 0 ; jStripped < int(strippedToParIndex.size()) ; jStripped++ ){
+        out[strippedToParIndex[iStripped]][strippedToParIndex[jStripped]] = 2. * (*_inverseStrippedCovarianceMatrix_)[iStripped][jStripped];
+      }
+    }
+  }
+
+  return out;
+}
+
 // Parameter throw
 void FitParameterSet::moveFitParametersToPrior(){
   LogInfo << "Moving back fit parameters to their prior value in set: " << getName() << std::endl;
@@ -290,11 +360,15 @@ void FitParameterSet::throwFitParameters(double gain_){
 //  if( not _useEigenDecompInFit_ ){
     LogInfo << "Throwing parameters for " << _name_ << " using Cholesky matrix" << std::endl;
 
+    if( _choleskyMatrix_ == nullptr ){
+      _choleskyMatrix_ = std::shared_ptr<TMatrixD>( (TMatrixD*) this->readDecompositionCache("choleskyMatrix") );
+    }
     if( _choleskyMatrix_ == nullptr ){
       LogInfo << "Generating Cholesky matrix in set: " << getName() << std::endl;
       _choleskyMatrix_ = std::shared_ptr<TMatrixD>(
           GenericToolbox::getCholeskyMatrix(_strippedCovarianceMatrix_.get())
       );
+      this->writeDecompositionCache(_choleskyMatrix_.get(), "choleskyMatrix");
     }
 
     auto throws = GenericToolbox::throwCorrelatedParameters(_choleskyMatrix_.get());
@@ -597,6 +671,9 @@ void FitParameterSet::readConfigOptions(){
     _globalParameterMaxValue_ = JsonUtils::fetchValue(parLimits, "maxValue", std::nan("UNSET"));
   }
 
+  _useWhitenedPenalty_ = JsonUtils::fetchValue(_config_, "useWhitenedPenalty", _useWhitenedPenalty_);
+  _decompositionCacheFolder_ = JsonUtils::fetchValue(_config_, "decompositionCacheFolder", _decompositionCacheFolder_);
+
   _useEigenDecompInFit_ = JsonUtils::fetchValue(_config_ , "useEigenDecompInFit", false);
   if( _useEigenDecompInFit_ ){
 
@@ -683,6 +760,152 @@ void FitParameterSet::defineParameters(){
   }
 }
 
+void FitParameterSet::buildWhitenedPenalty(){
+  // nothing from a previous build should survive
+  _choleskyUpperInverse_ = nullptr;
+  _whitenedDeltaList_.clear();
+  _lastDeltaList_.clear();
+  if( _strippedCovarianceMatrix_->GetNrows() == 0 ){ return; }
+  int nPars = _strippedCovarianceMatrix_->GetNrows();
+
+  _choleskyUpperInverse_ = std::shared_ptr<TMatrixD>( (TMatrixD*) this->readDecompositionCache("choleskyUpperInverse") );
+  if( _choleskyUpperInverse_ == nullptr ){
+    LogInfo << "Building whitened penalty from the Cholesky decomposition in set: " << getName() << std::endl;
+
+    TDecompChol choleskyDecomp(*_strippedCovarianceMatrix_);
+    if( not choleskyDecomp.Decompose() ){
+      LogAlert << "Cholesky decomposition failed for \"" << getName() << "\": using the inverted matrix for the penalty." << std::endl;
+      return;
+    }
+
+    // Invert the upper triangular factor by back substitution (U^{-1} is upper triangular too)
+    const TMatrixD& uMatrix = choleskyDecomp.GetU();
+    _choleskyUpperInverse_ = std::make_shared<TMatrixD>(nPars, nPars);
+    auto& uInv = *_choleskyUpperInverse_;
+    double sum;
+    for( int iCol = 0 ; iCol < nPars ; iCol++ ){
+      uInv[iCol][iCol] = 1. / uMatrix[iCol][iCol];
+      for( int iRow = iCol - 1 ; iRow >= 0 ; iRow-- ){
+        sum = 0;
+        for( int k = iRow + 1 ; k <= iCol ; k++ ){ sum += uMatrix[iRow][k] * uInv[k][iCol]; }
+        uInv[iRow][iCol] = -sum / uMatrix[iRow][iRow];
+      }
+    }
+    this->writeDecompositionCache(_choleskyUpperInverse_.get(), "choleskyUpperInverse");
+  }
+
+  // z is not yet computed: the first eval will do a full sweep
+  _whitenedDeltaList_.assign(nPars, 0);
+  _lastDeltaList_.assign(nPars, std::nan("unset"));
+  _nbIncrementalPenaltyUpdates_ = _maxNbIncrementalPenaltyUpdates_;
+}
+double FitParameterSet::evalWhitenedPenaltyChi2(){
+  this->fillDeltaParameterList();
+
+  int nPars = _deltaParameterList_->GetNrows();
+  if( nPars == 0 ){ return 0; }
+  const double* delta = _deltaParameterList_->GetMatrixArray();
+  const double* uInv = _choleskyUpperInverse_->GetMatrixArray(); // row major
+  double* z = &_whitenedDeltaList_[0];
+
+  int nMoved{0};
+  for( int iPar = 0 ; iPar < nPars ; iPar++ ){
+    if( delta[iPar] != _lastDeltaList_[iPar] ){ nMoved++; }
+  }
+
+  if( nMoved != 0 ){
+    if( _nbIncrementalPenaltyUpdates_ >= _maxNbIncrementalPenaltyUpdates_ or 4 * nMoved > nPars ){
+      // whole vector: z = sum_j delta_j . row_j(U^{-1}) -> N^2/2 operations on contiguous rows
+      std::fill(z, z + nPars, 0);
+      for( int jPar = 0 ; jPar < nPars ; jPar++ ){
+        if( delta[jPar] == 0 ) continue;
+        const double* uInvRow = &uInv[jPar * nPars];
+        for( int iPar = jPar ; iPar < nPars ; iPar++ ){ z[iPar] += delta[jPar] * uInvRow[iPar]; }
+      }
+      _nbIncrementalPenaltyUpdates_ = 0;
+    }
+    else{
+      // only the moved parameters: O(N) each
+      double shift;
+      for( int jPar = 0 ; jPar < nPars ; jPar++ ){
+        if( delta[jPar] == _lastDeltaList_[jPar] ) continue;
+        shift = delta[jPar] - _lastDeltaList_[jPar];
+        const double* uInvRow = &uInv[jPar * nPars];
+        for( int iPar = jPar ; iPar < nPars ; iPar++ ){ z[iPar] += shift * uInvRow[iPar]; }
+      }
+      _nbIncrementalPenaltyUpdates_++;
+    }
+    std::copy(delta, delta + nPars, _lastDeltaList_.begin());
+  }
+
+  double chi2{0};
+  for( int iPar = 0 ; iPar < nPars ; iPar++ ){ chi2 += z[iPar] * z[iPar]; }
+  return chi2;
+}
+void FitParameterSet::defineDecompositionCacheKey(){
+  // The decompositions only depend on the stripped matrix, the parameter mask and the eigen options
+  TMD5 md5;
+  md5.Update(
+      (const UChar_t*) _strippedCovarianceMatrix_->GetMatrixArray(),
+      UInt_t(_strippedCovarianceMatrix_->GetNoElements() * sizeof(double))
+  );
+  std::vector<UChar_t> parMask;
+  parMask.reserve(_parameterList_.size());
+  for( const auto& par : _parameterList_ ){
+    parMask.emplace_back( UChar_t(par.isEnabled()) | UChar_t(par.isFixed() << 1) | UChar_t(par.isFree() << 2) );
+  }
+  if( not parMask.empty() ){ md5.Update(&parMask[0], UInt_t(parMask.size())); }
+  std::stringstream ss;
+  ss << _useEigenDecompInFit_ << "/" << _maxNbEigenParameters_ << "/" << _maxEigenFraction_;
+  md5.Update((const UChar_t*) ss.str().c_str(), UInt_t(ss.str().size()));
+  md5.Final();
+
+  _decompositionCacheKey_ = _name_ + "_" + md5.AsString();
+  GenericToolbox::replaceSubstringInsideInputString(_decompositionCacheKey_, " ", "_");
+  GenericToolbox::replaceSubstringInsideInputString(_decompositionCacheKey_, "/", "_");
+  LogInfo << "Decomposition cache key for set \"" << getName() << "\": " << _decompositionCacheKey_ << std::endl;
+}
+TObject* FitParameterSet::readDecompositionCache(const std::string& objName_) const{
+  if( _decompositionCacheKey_.empty() ) return nullptr;
+
+  std::string filePath = _decompositionCacheFolder_ + "/" + _decompositionCacheKey_ + "_" + objName_ + ".root";
+  if( gSystem->AccessPathName(filePath.c_str()) ) return nullptr; // true if it can't be accessed
+
+  TObject* out{nullptr};
+  std::unique_ptr<TFile> cacheFile( TFile::Open(filePath.c_str(), "READ") );
+  if( cacheFile != nullptr and not cacheFile->IsZombie() ){
+    auto* obj = cacheFile->Get(objName_.c_str());
+    if( obj != nullptr ){ out = obj->Clone(); }
+    cacheFile->Close();
+  }
+  if( out != nullptr ){ LogInfo << "Loaded \"" << objName_ << "\" from decomposition cache: " << filePath << std::endl; }
+  else{ LogAlert << "Could not read \"" << objName_ << "\" from decomposition cache: " << filePath << std::endl; }
+  return out;
+}
+void FitParameterSet::writeDecompositionCache(const TObject* obj_, const std::string& objName_) const{
+  if( _decompositionCacheKey_.empty() or obj_ == nullptr ) return;
+
+  // one file per object, written aside then renamed: concurrent jobs never see a partial file
+  GenericToolbox::mkdirPath(_decompositionCacheFolder_);
+  std::string filePath = _decompositionCacheFolder_ + "/" + _decompositionCacheKey_ + "_" + objName_ + ".root";
+  std::string tempFilePath = filePath + ".tmp" + std::to_string(gSystem->GetPid());
+
+  std::unique_ptr<TFile> cacheFile( TFile::Open(tempFilePath.c_str(), "RECREATE") );
+  if( cacheFile == nullptr or cacheFile->IsZombie() ){
+    LogAlert << "Could not write decomposition cache: " << tempFilePath << std::endl;
+    return;
+  }
+  cacheFile->cd();
+  obj_->Write(objName_.c_str());
+  cacheFile->Close();
+
+  if( std::rename(tempFilePath.c_str(), filePath.c_str()) != 0 ){
+    LogAlert << "Could not move decomposition cache to: " << filePath << std::endl;
+    std::remove(tempFilePath.c_str());
+    return;
+  }
+  LogInfo << "Written \"" << objName_ << "\" in decomposition cache: " << filePath << std::endl;
+}
 void FitParameterSet::fillDeltaParameterList(){
   int iFit{0};
   for( const auto& par : _parameterList_ ){
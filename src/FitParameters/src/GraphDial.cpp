@@ -18,34 +18,40 @@ GraphDial::GraphDial() : Dial{DialType::Graph} {
 
 void GraphDial::reset() {
   this->Dial::reset();
-  _graph_ = TGraph();
+  _graphData_.clear();
 }
 
 void GraphDial::initialize() {
   this->Dial::initialize();
-  LogThrowIf( _graph_.GetN() == 0 )
+  LogThrowIf( _graphData_.empty() )
+  _graphData_[0] = ( _owner_->isAllowDialExtrapolation() ? 1 : 0 ); // only read by the cache manager
 }
 
 std::string GraphDial::getSummary() {
   std::stringstream ss;
   ss << Dial::getSummary();
-  ss << " (graph{nPt=" << _graph_.GetN() << "})";
+  ss << " (graph{nPt=" << this->getNbPoints() << "})";
   return ss.str();
 }
 
 
 double GraphDial::calcDial(double parameterValue_) {
-  if( not _owner_->isAllowDialExtrapolation() ){
-    if     (parameterValue_ <= _graph_.GetX()[0])                { return _graph_.GetY()[0]; }
-    else if(parameterValue_ >= _graph_.GetX()[_graph_.GetN()-1]) { return _graph_.GetY()[_graph_.GetN() - 1]; }
-  }
-  return _graph_.Eval(parameterValue_);
+  if( _owner_->isAllowDialExtrapolation() ){ return this->evalDial<true>(parameterValue_); }
+  return this->evalDial<false>(parameterValue_);
 }
 
 void GraphDial::setGraph(const TGraph &graph) {
-  LogThrowIf(_graph_.GetN() != 0, "Graph already set.")
+  LogThrowIf(not _graphData_.empty(), "Graph already set.")
   LogThrowIf(graph.GetN() == 0, "Invalid input graph")
-  _graph_ = graph;
-  _graph_.Sort();
+
+  TGraph sortedGraph(graph);
+  sortedGraph.Sort();
+
+  _graphData_.resize(1 + 2 * sortedGraph.GetN());
+  _graphData_[0] = 1;
+  for( int iPt = 0 ; iPt < sortedGraph.GetN() ; iPt++ ){
+    _graphData_[1 + 2 * iPt] = sortedGraph.GetY()[iPt];
+    _graphData_[1 + 2 * iPt + 1] = sortedGraph.GetX()[iPt];
+  }
 }
 
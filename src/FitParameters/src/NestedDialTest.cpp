@@ -24,6 +24,7 @@ void NestedDialTest::setFormulaStr(const std::string& formulaStr_){
   _evalFormula_ = TFormula(formulaStr_.c_str(), formulaStr_.c_str());
   LogThrowIf(not _evalFormula_.IsValid(), "\"" << formulaStr_ << "\": could not be parsed as formula expression.")
   _dialResponsesCache_.resize(_evalFormula_.GetNdim(), std::nan("unset"));
+  _compiledEvalFormula_.compile(formulaStr_);
 }
 void NestedDialTest::setApplyConditionStr(const std::string& applyConditionStr_){
   _applyConditionFormula_ = TFormula(applyConditionStr_.c_str(), applyConditionStr_.c_str());
@@ -37,6 +38,10 @@ void NestedDialTest::initialize() {
 
 
 double NestedDialTest::eval(const std::vector<Dial*>& dialRefList_) {
+  if( _compiledEvalFormula_.isValid() and _compiledEvalFormula_.getParameterNameList().empty()
+      and _compiledEvalFormula_.getNbVariables() <= int(dialRefList_.size()) ){
+    return _compiledEvalFormula_.eval([&](int iDial_){ return dialRefList_[iDial_]->evalResponse(); });
+  }
   this->updateDialResponseCache(dialRefList_);
   return _evalFormula_.EvalPar(&_dialResponsesCache_[0]);
 }
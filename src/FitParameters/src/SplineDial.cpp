@@ -25,6 +25,7 @@ SplineDial::SplineDial() : Dial(DialType::Spline) {
 void SplineDial::reset() {
   this->Dial::reset();
   _spline_ = TSpline3();
+  _responseTableIndex_ = -1;
 }
 
 void SplineDial::copySpline(const TSpline3* splinePtr_){
@@ -80,10 +81,10 @@ const TSpline3* SplineDial::getSplinePtr() const {
 }
 
 double SplineDial::calcDial(double parameterValue_) {
-  if( not _owner_->isAllowDialExtrapolation() ){
-    if     (parameterValue_ <= _spline_.GetXmin()) { parameterValue_ = _spline_.GetXmin(); }
-    else if(parameterValue_ >= _spline_.GetXmax()) { parameterValue_ = _spline_.GetXmax(); }
-  }
+  if( _owner_->isAllowDialExtrapolation() ){ return this->evalDial<true>(parameterValue_); }
+  return this->evalDial<false>(parameterValue_);
+}
+double SplineDial::evalSpline(double parameterValue_) {
 #ifdef USE_TSPLINE3_EVAL
   return _spline_.Eval(parameterValue_);
 #else
@@ -31,6 +31,7 @@ public:
 
   // Post init
   void copyMcEventListToDataContainer();
+  void referenceMcEventListInDataContainer(bool isHistogramOnly_ = false);
   void clearMcContainers();
 
   // Getters
@@ -49,6 +50,9 @@ public:
   void updateSampleBinEventList() const;
   void updateSampleHistograms() const;
 
+protected:
+  void evalLikelihoodOnBinArrays(int iThread_) const;
+
 private:
   bool _isInitialized_{false};
   bool _showTimeStats_{false};
@@ -58,6 +62,20 @@ private:
   std::shared_ptr<JointProbability::JointProbability> _jointProbabilityPtr_{nullptr};
   std::vector<std::string> _eventByEventDialLeafList_;
 
+  // Flat bin arrays of all samples concatenated (no under/overflow): filled before each llh eval
+  int _nbBinsPerThreadThreshold_{256};
+  std::vector<size_t> _sampleBinOffsetList_{};
+  mutable std::vector<double> _mcBinContentArray_{};
+  mutable std::vector<double> _mcBinSumw2Array_{};
+  mutable std::vector<double> _dataBinContentArray_{};
+  mutable std::vector<double> _llhPerThreadBuffer_{}; // [iThread][iSample]
+
+  // Per-sample llh cache: only re-evaluated when the mc or data histogram version has changed
+  bool _useSampleLlhCache_{true};
+  mutable std::vector<double> _llhPerSampleCache_{};
+  mutable std::vector<char> _isSampleLlhStaleList_{};
+  mutable std::vector<std::pair<size_t, size_t>> _llhCacheVersionList_{}; // {mc, data} histogramVersion
+
 };
 
 
@@ -7,6 +7,7 @@
 
 #include "FitSample.h"
 
+#include <cstddef>
 
 
 namespace JointProbability{
@@ -25,23 +26,45 @@ namespace JointProbability{
       for( int iBin = 1 ; iBin <= nBins ; iBin++ ){ out += this->eval(sample_, iBin); }
       return out;
     }
+
+    // batch eval over contiguous bin arrays: MC content, MC sum of squared weights, data content.
+    // One virtual call per array -> the inner loop is inlined per llh type (see evalBinArray).
+    virtual double eval(const double* mcArray_, const double* mcSumw2Array_, const double* dataArray_, size_t nBins_) const;
+
+  protected:
+    template<typename T> static double evalBinArray(const double* mcArray_, const double* mcSumw2Array_, const double* dataArray_, size_t nBins_){
+      double out{0};
+      for( size_t iBin = 0 ; iBin < nBins_ ; iBin++ ){ out += T::evalBin(mcArray_[iBin], mcSumw2Array_[iBin], dataArray_[iBin]); }
+      return out;
+    }
+
   };
 
   class PoissonLLH : public JointProbability{
+  public:
     double eval(const FitSample& sample_, int bin_) override;
+    double eval(const double* mcArray_, const double* mcSumw2Array_, const double* dataArray_, size_t nBins_) const override;
+    static inline double evalBin(double predVal_, double mcSumw2_, double dataVal_);
   };
 
   class BarlowLLH : public JointProbability{
+  public:
     double eval(const FitSample& sample_, int bin_) override;
-  private:
-    double rel_var, b, c, beta, mc_hat, chi2;
+    double eval(const double* mcArray_, const double* mcSumw2Array_, const double* dataArray_, size_t nBins_) const override;
+    static inline double evalBin(double predVal_, double mcSumw2_, double dataVal_);
   };
 
   class BarlowLLH_BANFF_OA2020 : public JointProbability{
+  public:
     double eval(const FitSample& sample_, int bin_) override;
+    double eval(const double* mcArray_, const double* mcSumw2Array_, const double* dataArray_, size_t nBins_) const override;
+    static inline double evalBin(double predVal_, double mcSumw2_, double dataVal_);
   };
   class BarlowLLH_BANFF_OA2021 : public JointProbability{
+  public:
     double eval(const FitSample& sample_, int bin_) override;
+    double eval(const double* mcArray_, const double* mcSumw2Array_, const double* dataArray_, size_t nBins_) const override;
+    static inline double evalBin(double predVal_, double mcSumw2_, double dataVal_);
   };
 
 }
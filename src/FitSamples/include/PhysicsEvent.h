@@ -7,7 +7,9 @@
 
 #include "FitParameterSet.h"
 #include "Dial.h"
+#include "DialRegistry.h"
 #include "NestedDialTest.h"
+#include "CompiledFormula.h"
 
 #include "GenericToolbox.Root.TreeEventBuffer.h"
 #include "GenericToolbox.Root.LeafHolder.h"
@@ -20,6 +22,72 @@
 #include "vector"
 #include "string"
 #include "map"
+#include "cstdint"
+#include "stdexcept"
+
+// Fixed-capacity list of the registry ids of the dials applied on an event. It is normally a slice of the dial arena of
+// the SampleElement holding the event and doesn't own that memory. A copy owns its ids instead, so it never refers to
+// the arena of another container (SampleElement::compactDialMemory() moves them back in an arena).
+// Iterating over it gives the Dial pointers.
+class DialIdList {
+
+public:
+  class const_iterator {
+  public:
+    explicit const_iterator(const uint32_t* idPtr_) : _idPtr_(idPtr_) {}
+    Dial* operator*() const { return DialRegistry::getDial(*_idPtr_); }
+    const_iterator& operator++(){ ++_idPtr_; return *this; }
+    bool operator==(const const_iterator& other_) const { return _idPtr_ == other_._idPtr_; }
+    bool operator!=(const const_iterator& other_) const { return _idPtr_ != other_._idPtr_; }
+  private:
+    const uint32_t* _idPtr_;
+  };
+
+  DialIdList() = default;
+  DialIdList(const DialIdList& other_){ *this = other_; }
+  DialIdList(DialIdList&& other_) noexcept { *this = std::move(other_); }
+  DialIdList& operator=(const DialIdList& other_){
+    if( this == &other_ ){ return *this; }
+    _ownedIdList_.assign(other_._bufferPtr_, other_._bufferPtr_ + other_._size_);
+    _bufferPtr_ = ( _ownedIdList_.empty() ? nullptr : _ownedIdList_.data() );
+    _size_ = other_._size_;
+    _capacity_ = other_._size_;
+    return *this;
+  }
+  DialIdList& operator=(DialIdList&& other_) noexcept {
+    _ownedIdList_ = std::move(other_._ownedIdList_); // the heap buffer, hence _bufferPtr_, is kept
+    _bufferPtr_ = other_._bufferPtr_;
+    _size_ = other_._size_;
+    _capacity_ = other_._capacity_;
+    other_._bufferPtr_ = nullptr;
+    other_._size_ = 0;
+    other_._capacity_ = 0;
+    return *this;
+  }
+
+  void setBuffer(uint32_t* bufferPtr_, size_t capacity_){
+    std::vector<uint32_t>().swap(_ownedIdList_);
+    _bufferPtr_ = bufferPtr_; _size_ = uint32_t(capacity_); _capacity_ = uint32_t(capacity_);
+  }
+  void resize(size_t size_){ if( size_ > _capacity_ ){ throw std::runtime_error("DialIdList can't grow over its capacity"); } _size_ = uint32_t(size_); }
+  void setDial(size_t index_, const Dial* dialPtr_){ _bufferPtr_[index_] = dialPtr_->getRegistryId(); }
+
+  size_t size() const { return _size_; }
+  size_t capacity() const { return _capacity_; }
+  bool empty() const { return _size_ == 0; }
+  const uint32_t* data() const { return _bufferPtr_; }
+
+  Dial* operator[](size_t index_) const { return DialRegistry::getDial(_bufferPtr_[index_]); }
+  const_iterator begin() const { return const_iterator(_bufferPtr_); }
+  const_iterator end() const { return const_iterator(_bufferPtr_ + _size_); }
+
+private:
+  uint32_t* _bufferPtr_{nullptr};
+  uint32_t _size_{0};
+  uint32_t _capacity_{0};
+  std::vector<uint32_t> _ownedIdList_{}; // only filled for copies
+
+};
 
 class PhysicsEvent {
 
@@ -47,8 +115,8 @@ public:
   double getEventWeight() const;
   double getFakeDataWeight() const;
   int getSampleBinIndex() const;
-  std::vector<Dial *> &getRawDialPtrList();
-  const std::vector<Dial *> &getRawDialPtrList() const;
+  DialIdList &getRawDialPtrList();
+  const DialIdList &getRawDialPtrList() const;
   const std::vector<GenericToolbox::AnyType>& getLeafHolder(const std::string &leafName_) const;
   const std::vector<GenericToolbox::AnyType>& getLeafHolder(int index_) const;
   const std::vector<std::vector<GenericToolbox::AnyType>> &getLeafContentList() const;
@@ -77,6 +145,7 @@ public:
 
   // Eval
   double evalFormula(TFormula* formulaPtr_, std::vector<int>* indexDict_ = nullptr) const;
+  double evalFormula(const CompiledFormula& formula_) const; // parameters bound to the var indexes of this event
 
   // Misc
   void print() const;
@@ -110,7 +179,7 @@ private:
   std::vector<std::vector<GenericToolbox::AnyType>> _leafContentList_;
 
   // Cache variables
-  std::vector<Dial*> _rawDialPtrList_{};
+  DialIdList _rawDialPtrList_{};
   std::vector<std::pair<NestedDialTest*, std::vector<Dial*>>> _nestedDialRefList_{};
   mutable std::vector<std::vector<double>> _varToDoubleCache_{};
 
@@ -59,10 +59,23 @@ struct HistHolder{
 
   // Flags
   bool isBaseSplitHist{false};
+};
+
+struct EventBinTable{
+  // Built once per event list (MC or data of a given sample): all of its histograms are filled in one sweep
+  const std::vector<PhysicsEvent>* eventListPtr{nullptr};
+  const std::vector<double>* weightListPtr{nullptr}; // frozen weights of referenced events, the event ones if nullptr
+  const SampleElement* compactContainerPtr{nullptr}; // compacted or packed events: variables read from its columns
+  size_t nbEvents{0};
+  bool isData{false};
 
-  // Caches
-  bool isBinCacheBuilt{false};
-  std::vector<std::vector<const PhysicsEvent*>> _binEventPtrList_;
+  // One column per plotted variable: the split histograms of a variable share the same column
+  // since an event can only belong to one of them
+  size_t nbColumns{0};
+  size_t nbFillSlots{0}; // total number of bins fed by this event list
+
+  std::vector<int> fillSlotTable{}; // [iEvent*nbColumns + iColumn] -> fill slot, -1 if not filled
+  std::vector<std::pair<size_t, size_t>> histSlotOffsetList{}; // {index in the HistHolder list, first fill slot}
 };
 
 struct CanvasHolder{
@@ -94,13 +107,16 @@ public:
   // Getters
   const std::vector<HistHolder> &getHistHolderList(int cacheSlot_ = 0) const;
   const std::vector<HistHolder> &getComparisonHistHolderList() const;
+  const std::vector<EventBinTable> &getEventBinTableList() const;
   std::map<std::string, std::shared_ptr<TCanvas>> getBufferCanvasList() const;
 
   // Core
   bool isEmpty() const;
 
   void generateSamplePlots(TDirectory *saveDir_ = nullptr, int cacheSlot_ = 0);
-  void generateSampleHistograms(TDirectory *saveDir_ = nullptr, int cacheSlot_ = 0);
+  // If fillSlotDeltaList_ is provided, hists are made of the last full fill + fillSlotDeltaList_[iTable][iFillSlot]
+  // (an empty entry means the table is unchanged) instead of looping over the events
+  void generateSampleHistograms(TDirectory *saveDir_ = nullptr, int cacheSlot_ = 0, const std::vector<std::vector<double>>* fillSlotDeltaList_ = nullptr);
   void generateCanvas(const std::vector<HistHolder> &histHolderList_, TDirectory *saveDir_ = nullptr, bool stackHist_ = true);
 
   void generateComparisonPlots(const std::vector<HistHolder> &histsToStackOther_, const std::vector<HistHolder> &histsToStackReference_, TDirectory *saveDir_ = nullptr);
@@ -112,7 +128,10 @@ public:
   std::vector<std::string> fetchRequestedLeafNames();
 
 protected:
-  void buildEventBinCache(const std::vector<HistHolder *> &histPtrToFillList, const std::vector<PhysicsEvent> *eventListPtr, bool isData_);
+  void buildEventBinTables(const std::vector<HistHolder>& histHolderList_);
+  void fillHistograms(size_t iTable_, std::vector<HistHolder>& histHolderList_);
+  void writeFillSlotsInHistograms(const EventBinTable& table_, const std::vector<double>& fillSlotContent_,
+                                  const std::vector<double>& fillSlotDelta_, std::vector<HistHolder>& histHolderList_);
 
 private:
   nlohmann::json _config_;
@@ -129,6 +148,11 @@ private:
   std::vector<HistHolder> _comparisonHistHolderList_;
   std::map<std::string, std::shared_ptr<TCanvas>> _bufferCanvasList_;
 
+  // Fill caches (shared by all the cache slots: the HistHolder lists have the same layout)
+  std::vector<EventBinTable> _eventBinTableList_;
+  std::vector<std::vector<double>> _fillBufferPerThread_;
+  std::vector<std::vector<double>> _fillSlotContentList_; // [iTable][iFillSlot] content of the last full fill
+
 };
 
 
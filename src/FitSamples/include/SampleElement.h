@@ -27,6 +27,32 @@ public:
   // Events
   std::vector<PhysicsEvent> eventList;
 
+  // Reference mode (Asimov): the events are the ones of another container, only their frozen weight and bin are kept
+  const std::vector<PhysicsEvent>* referencedEventListPtr{nullptr};
+  std::vector<double> frozenWeightList;
+  std::vector<int> frozenBinIndexList;
+  bool isHistogramOnly{false}; // events are dropped once locked
+
+  // Compact mode: the events are dropped, only their frozen weight, bin and the requested variables are kept
+  bool isCompacted{false};
+  std::vector<std::string> compactVarNameList;
+  std::vector<std::vector<double>> compactVarColumnList; // [iVar][iEvent], also the hot columns of packed leaves
+
+  // Packed leaves: the hot variables (binning, plots) are kept in the compact columns, the other leaves are
+  // serialized in compressed blocks of events which are only restored to write the event trees
+  struct LeafBlock{
+    size_t nbEvents{0};
+    size_t rawSize{0};
+    bool isCompressed{true};
+    std::vector<char> buffer{};
+  };
+  std::vector<LeafBlock> leafBlockList;
+  std::vector<std::vector<GenericToolbox::AnyType>> leafPrototypeList; // [iLeaf] -> one element holding the type, none if always empty
+  size_t leafBlockSize{0};
+
+  // Dial arena: the dial id lists of the events are slices of these blocks
+  std::vector<std::vector<uint32_t>> dialIdBlockList;
+
   // Datasets
   std::vector<size_t> dataSetIndexList;
   std::vector<size_t> eventOffSetList;
@@ -39,18 +65,37 @@ public:
   double histScale{1};
   bool isLocked{false};
 
+  // Bumped each time the histogram content actually changes: used by the llh cache
+  size_t histogramVersion{0};
+  std::vector<char> isHistogramChangedPerThread; // [iThread], filled by refillHistogram
+
   // Methods
   void reserveEventMemory(size_t dataSetIndex_, size_t nEvents, const PhysicsEvent &eventBuffer_);
+  void reserveDialMemory(size_t nEvents_, size_t nDialsPerEvent_);
+  void compactDialMemory();
+  void releaseDialMemory();
+  void referenceEvents(const std::vector<PhysicsEvent>& eventList_);
+  void dropEvents();
+  void compactEvents(const std::vector<std::string>& varNameList_);
+  void packLeaves(const std::vector<std::string>& hotVarNameList_, int compressionSettings_ = 404, size_t blockSize_ = 4096);
+  void unpackLeafBlock(size_t iBlock_, std::vector<std::vector<std::vector<GenericToolbox::AnyType>>>& leafContentListBuffer_) const;
   void shrinkEventList(size_t newTotalSize_);
   void updateEventBinIndexes(int iThread_ = -1);
   void updateBinEventList(int iThread_ = -1);
   void refillHistogram(int iThread_ = -1);
   void rescaleHistogram();
+  void updateHistogramVersion();
 
   void throwStatError();
 
   double getSumWeights() const;
   size_t getNbBinnedEvents() const;
+  bool isReferencingEvents() const;
+  bool isUsingFrozenColumns() const;
+  bool isLeavesPacked() const;
+  size_t getPackedLeavesSize() const;
+  size_t getNbEvents() const;
+  double getCompactVarValue(size_t iEvent_, const std::string& varName_) const;
 
   // debug
   void print() const;
@@ -76,6 +76,7 @@ void FitSample::initialize() {
       int(_binning_.getBinsList().size()), 0, int(_binning_.getBinsList().size())
   );
   _mcContainer_.histogram->SetDirectory(nullptr);
+  _mcContainer_.isHistogramChangedPerThread.resize(GlobalVariables::getNbThreads(), false);
 
   _dataContainer_.name = "Data_" + _name_;
   _dataContainer_.binning = _binning_;
@@ -85,6 +86,7 @@ void FitSample::initialize() {
       int(_binning_.getBinsList().size()), 0, int(_binning_.getBinsList().size())
   );
   _dataContainer_.histogram->SetDirectory(nullptr);
+  _dataContainer_.isHistogramChangedPerThread.resize(GlobalVariables::getNbThreads(), false);
 }
 
 bool FitSample::isEnabled() const {
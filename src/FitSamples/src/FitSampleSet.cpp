@@ -15,6 +15,8 @@
 #include <TTreeFormulaManager.h>
 
 #include <memory>
+#include <numeric>
+#include <algorithm>
 
 
 LoggerInit([]{ Logger::setUserHeaderStr("[FitSampleSet]"); });
@@ -29,6 +31,15 @@ void FitSampleSet::reset() {
   _fitSampleList_.clear();
 
   _eventByEventDialLeafList_.clear();
+
+  _sampleBinOffsetList_.clear();
+  _mcBinContentArray_.clear();
+  _mcBinSumw2Array_.clear();
+  _dataBinContentArray_.clear();
+  _llhPerThreadBuffer_.clear();
+  _llhPerSampleCache_.clear();
+  _isSampleLlhStaleList_.clear();
+  _llhCacheVersionList_.clear();
 }
 
 void FitSampleSet::setConfig(const nlohmann::json &config) {
@@ -106,6 +117,32 @@ void FitSampleSet::initialize() {
   else if( llhMethod == "BarlowLLH_BANFF_OA2021" ) {  _jointProbabilityPtr_ = std::make_shared<JointProbability::BarlowLLH_BANFF_OA2021>(); }
   else{ LogThrow("Unknown LLH Method: " << llhMethod); }
 
+  // Flat bin arrays for the llh kernels
+  size_t nBinsTotal{0};
+  for( auto& sample : _fitSampleList_ ){
+    _sampleBinOffsetList_.emplace_back(nBinsTotal);
+    nBinsTotal += sample.getBinning().getBinsList().size();
+  }
+  _mcBinContentArray_.resize(nBinsTotal, 0);
+  _mcBinSumw2Array_.resize(nBinsTotal, 0);
+  _dataBinContentArray_.resize(nBinsTotal, 0);
+  _llhPerThreadBuffer_.resize(GlobalVariables::getNbThreads() * _fitSampleList_.size(), 0);
+
+  _useSampleLlhCache_ = JsonUtils::fetchValue(_config_, "useSampleLlhCache", _useSampleLlhCache_);
+  _llhPerSampleCache_.resize(_fitSampleList_.size(), 0);
+  _isSampleLlhStaleList_.resize(_fitSampleList_.size(), true);
+  _llhCacheVersionList_.resize(_fitSampleList_.size(), {size_t(-1), size_t(-1)});
+
+  _nbBinsPerThreadThreshold_ = JsonUtils::fetchValue(_config_, "llhNbBinsPerThreadThreshold", _nbBinsPerThreadThreshold_);
+  LogInfo << "Likelihood evaluated on " << nBinsTotal << " concatenated bins";
+  if( GlobalVariables::getNbThreads() > 1 and nBinsTotal >= size_t(_nbBinsPerThreadThreshold_ * GlobalVariables::getNbThreads()) ){
+    LogInfo << " using " << GlobalVariables::getNbThreads() << " threads";
+  }
+  LogInfo << "." << std::endl;
+
+  std::function<void(int)> evalLikelihoodFct = [this](int iThread){ this->evalLikelihoodOnBinArrays(iThread); };
+  GlobalVariables::getParallelWorker().addJob("FitSampleSet::evalLikelihood", evalLikelihoodFct);
+
   _isInitialized_ = true;
 }
 
@@ -126,12 +163,93 @@ bool FitSampleSet::empty() const {
   return _fitSampleList_.empty();
 }
 double FitSampleSet::evalLikelihood() const{
-  double llh = 0.;
-  for( auto& sample : _fitSampleList_ ){ llh += this->evalLikelihood(sample); }
-  return llh;
+  // only the samples which histograms have changed since the last call are evaluated
+  bool isAnySampleStale{false};
+  for( size_t iSample = 0 ; iSample < _fitSampleList_.size() ; iSample++ ){
+    _isSampleLlhStaleList_[iSample] = (
+        not _useSampleLlhCache_
+        or _llhCacheVersionList_[iSample].first != _fitSampleList_[iSample].getMcContainer().histogramVersion
+        or _llhCacheVersionList_[iSample].second != _fitSampleList_[iSample].getDataContainer().histogramVersion
+    );
+    if( _isSampleLlhStaleList_[iSample] ){ isAnySampleStale = true; }
+  }
+
+  if( isAnySampleStale ){
+    if( GlobalVariables::getNbThreads() > 1
+        and _mcBinContentArray_.size() >= size_t(_nbBinsPerThreadThreshold_ * GlobalVariables::getNbThreads()) ){
+      GlobalVariables::getParallelWorker().runJob("FitSampleSet::evalLikelihood");
+    }
+    else{
+      this->evalLikelihoodOnBinArrays(-1);
+    }
+
+    // summed in thread order -> reproducible result for a given nb of threads
+    for( size_t iSample = 0 ; iSample < _fitSampleList_.size() ; iSample++ ){
+      if( not _isSampleLlhStaleList_[iSample] ) continue;
+      _llhPerSampleCache_[iSample] = 0;
+      for( size_t iThread = 0 ; iThread < _llhPerThreadBuffer_.size() / _fitSampleList_.size() ; iThread++ ){
+        _llhPerSampleCache_[iSample] += _llhPerThreadBuffer_[iThread * _fitSampleList_.size() + iSample];
+      }
+      _llhCacheVersionList_[iSample].first = _fitSampleList_[iSample].getMcContainer().histogramVersion;
+      _llhCacheVersionList_[iSample].second = _fitSampleList_[iSample].getDataContainer().histogramVersion;
+    }
+  }
+
+  return std::accumulate(_llhPerSampleCache_.begin(), _llhPerSampleCache_.end(), double(0.));
 }
 double FitSampleSet::evalLikelihood(const FitSample& sample_) const{
-  return _jointProbabilityPtr_->eval(sample_);
+  // the histograms are already contiguous for a single sample: skip the underflow bin
+  return _jointProbabilityPtr_->eval(
+      sample_.getMcContainer().histogram->GetArray() + 1,
+      sample_.getMcContainer().histogram->GetSumw2()->GetArray() + 1,
+      sample_.getDataContainer().histogram->GetArray() + 1,
+      size_t(sample_.getMcContainer().histogram->GetNbinsX())
+  );
+}
+void FitSampleSet::evalLikelihoodOnBinArrays(int iThread_) const{
+  int nbThreads = GlobalVariables::getNbThreads();
+  if( iThread_ == -1 ){
+    nbThreads = 1;
+    iThread_ = 0;
+    std::fill(_llhPerThreadBuffer_.begin(), _llhPerThreadBuffer_.end(), 0);
+  }
+
+  // [iThread][iSample] slots of this thread
+  double* llhSlotList = &_llhPerThreadBuffer_[iThread_ * _fitSampleList_.size()];
+  std::fill(llhSlotList, llhSlotList + _fitSampleList_.size(), 0);
+
+  // each thread handles a contiguous slice of the concatenated bins
+  size_t nBinsTotal = _mcBinContentArray_.size();
+  size_t sliceBegin = (nBinsTotal * iThread_) / nbThreads;
+  size_t sliceEnd = (nBinsTotal * (iThread_ + 1)) / nbThreads;
+  if( sliceBegin == sliceEnd ){ return; }
+
+  // gather the slice from the sample histograms (bin 0 is the underflow)
+  size_t beginInSample, endInSample;
+  for( size_t iSample = 0 ; iSample < _fitSampleList_.size() ; iSample++ ){
+    if( not _isSampleLlhStaleList_[iSample] ) continue;
+    auto& sample = _fitSampleList_[iSample];
+    beginInSample = std::max(sliceBegin, _sampleBinOffsetList_[iSample]);
+    endInSample = std::min(sliceEnd, _sampleBinOffsetList_[iSample] + sample.getMcContainer().histogram->GetNbinsX());
+    if( beginInSample >= endInSample ) continue;
+
+    int firstBin = int(beginInSample - _sampleBinOffsetList_[iSample]) + 1;
+    int lastBin = int(endInSample - _sampleBinOffsetList_[iSample]) + 1;
+    std::copy(sample.getMcContainer().histogram->GetArray() + firstBin,
+              sample.getMcContainer().histogram->GetArray() + lastBin,
+              &_mcBinContentArray_[beginInSample]);
+    std::copy(sample.getMcContainer().histogram->GetSumw2()->GetArray() + firstBin,
+              sample.getMcContainer().histogram->GetSumw2()->GetArray() + lastBin,
+              &_mcBinSumw2Array_[beginInSample]);
+    std::copy(sample.getDataContainer().histogram->GetArray() + firstBin,
+              sample.getDataContainer().histogram->GetArray() + lastBin,
+              &_dataBinContentArray_[beginInSample]);
+
+    llhSlotList[iSample] = _jointProbabilityPtr_->eval(
+        &_mcBinContentArray_[beginInSample], &_mcBinSumw2Array_[beginInSample], &_dataBinContentArray_[beginInSample],
+        endInSample - beginInSample
+    );
+  }
 }
 
 void FitSampleSet::copyMcEventListToDataContainer(){
@@ -142,12 +260,22 @@ void FitSampleSet::copyMcEventListToDataContainer(){
         std::begin(sample.getMcContainer().eventList),
         std::end(sample.getMcContainer().eventList)
     );
+    // the copies own their dial ids one by one: back in a single block
+    sample.getDataContainer().compactDialMemory();
+  }
+}
+void FitSampleSet::referenceMcEventListInDataContainer(bool isHistogramOnly_){
+  for( auto& sample : _fitSampleList_ ){
+    LogInfo << "Referencing MC events in sample \"" << sample.getName() << "\"" << std::endl;
+    sample.getDataContainer().referenceEvents(sample.getMcContainer().eventList);
+    sample.getDataContainer().isHistogramOnly = isHistogramOnly_;
   }
 }
 void FitSampleSet::clearMcContainers(){
   for( auto& sample : _fitSampleList_ ){
     LogInfo << "Clearing event list for \"" << sample.getName() << "\"" << std::endl;
     sample.getMcContainer().eventList.clear();
+    sample.getMcContainer().releaseDialMemory();
   }
 }
 
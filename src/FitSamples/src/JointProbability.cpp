@@ -15,44 +15,78 @@ LoggerInit([]{
 
 namespace JointProbability{
 
+  double JointProbability::eval(const double* mcArray_, const double* mcSumw2Array_, const double* dataArray_, size_t nBins_) const{
+    LogThrow("Batch eval over bin arrays is not implemented for this JointProbability.");
+    return 0;
+  }
+
+  // Bin accessors: the MC histograms are always filled with Sumw2 (see FitSample::initialize)
+  // GetBinError(bin) is sqrt(sumw2[bin]), the per-bin kernels take sumw2 as input.
+
   double PoissonLLH::eval(const FitSample& sample_, int bin_){
-    double predVal = sample_.getMcContainer().histogram->GetBinContent(bin_);
-    double dataVal = sample_.getDataContainer().histogram->GetBinContent(bin_);
-    if(predVal <= 0){
-      LogAlert << "Zero MC events in bin " << bin_ << ". predVal = " << predVal << ", dataVal = " << dataVal
+    return evalBin(
+        sample_.getMcContainer().histogram->GetBinContent(bin_),
+        sample_.getMcContainer().histogram->GetSumw2()->GetAt(bin_),
+        sample_.getDataContainer().histogram->GetBinContent(bin_)
+    );
+  }
+  double PoissonLLH::eval(const double* mcArray_, const double* mcSumw2Array_, const double* dataArray_, size_t nBins_) const{
+    return evalBinArray<PoissonLLH>(mcArray_, mcSumw2Array_, dataArray_, nBins_);
+  }
+  inline double PoissonLLH::evalBin(double predVal_, double mcSumw2_, double dataVal_){
+    if(predVal_ <= 0){
+      LogAlert << "Zero MC events in bin. predVal = " << predVal_ << ", dataVal = " << dataVal_
                << ". Setting chi2_stat = 0 for this bin." << std::endl;
       return 0;
     }
-    return 2.0 * (predVal - dataVal + dataVal * TMath::Log(dataVal / predVal));
+    return 2.0 * (predVal_ - dataVal_ + dataVal_ * TMath::Log(dataVal_ / predVal_));
   }
 
   double BarlowLLH::eval(const FitSample& sample_, int bin_){
-    rel_var = sample_.getMcContainer().histogram->GetBinError(bin_) / TMath::Sq(sample_.getMcContainer().histogram->GetBinContent(bin_));
-    b       = (sample_.getMcContainer().histogram->GetBinContent(bin_) * rel_var) - 1;
-    c       = 4 * sample_.getDataContainer().histogram->GetBinContent(bin_) * rel_var;
+    return evalBin(
+        sample_.getMcContainer().histogram->GetBinContent(bin_),
+        sample_.getMcContainer().histogram->GetSumw2()->GetAt(bin_),
+        sample_.getDataContainer().histogram->GetBinContent(bin_)
+    );
+  }
+  double BarlowLLH::eval(const double* mcArray_, const double* mcSumw2Array_, const double* dataArray_, size_t nBins_) const{
+    return evalBinArray<BarlowLLH>(mcArray_, mcSumw2Array_, dataArray_, nBins_);
+  }
+  inline double BarlowLLH::evalBin(double predVal_, double mcSumw2_, double dataVal_){
+    double rel_var = std::sqrt(mcSumw2_) / TMath::Sq(predVal_);
+    double b       = (predVal_ * rel_var) - 1;
+    double c       = 4 * dataVal_ * rel_var;
 
-    beta   = (-b + std::sqrt(b * b + c)) / 2.0;
-    mc_hat = sample_.getMcContainer().histogram->GetBinContent(bin_) * beta;
+    double beta   = (-b + std::sqrt(b * b + c)) / 2.0;
+    double mc_hat = predVal_ * beta;
 
     // Calculate the following LLH:
     //-2lnL = 2 * beta*mc - data + data * ln(data / (beta*mc)) + (beta-1)^2 / sigma^2
     // where sigma^2 is the same as above.
-    chi2 = 0.0;
-    if(sample_.getDataContainer().histogram->GetBinContent(bin_) <= 0.0) {
+    double chi2;
+    if(dataVal_ <= 0.0) {
       chi2 = 2 * mc_hat;
       chi2 += (beta - 1) * (beta - 1) / rel_var;
     }
     else{
-      chi2 = 2 * (mc_hat - sample_.getDataContainer().histogram->GetBinContent(bin_));
-      if(sample_.getDataContainer().histogram->GetBinContent(bin_) > 0.0) {
-        chi2 += 2 * sample_.getDataContainer().histogram->GetBinContent(bin_) *
-                std::log(sample_.getDataContainer().histogram->GetBinContent(bin_) / mc_hat);
-      }
+      chi2 = 2 * (mc_hat - dataVal_);
+      chi2 += 2 * dataVal_ * std::log(dataVal_ / mc_hat);
       chi2 += (beta - 1) * (beta - 1) / rel_var;
     }
     return chi2;
   }
+
   double BarlowLLH_BANFF_OA2020::eval(const FitSample& sample_, int bin_){
+    return evalBin(
+        sample_.getMcContainer().histogram->GetBinContent(bin_),
+        sample_.getMcContainer().histogram->GetSumw2()->GetAt(bin_),
+        sample_.getDataContainer().histogram->GetBinContent(bin_)
+    );
+  }
+  double BarlowLLH_BANFF_OA2020::eval(const double* mcArray_, const double* mcSumw2Array_, const double* dataArray_, size_t nBins_) const{
+    return evalBinArray<BarlowLLH_BANFF_OA2020>(mcArray_, mcSumw2Array_, dataArray_, nBins_);
+  }
+  inline double BarlowLLH_BANFF_OA2020::evalBin(double predVal_, double mcSumw2_, double dataVal_){
     // From BANFF: origin/OA2020 branch -> BANFFBinnedSample::CalcLLRContrib()
 
     //Loop over all the bins one by one using their unique bin index.
@@ -60,9 +94,9 @@ namespace JointProbability{
     //over underflow or overflow bins.
     double chisq{0};
 
-    double dataVal = sample_.getDataContainer().histogram->GetBinContent(bin_);
-    double predVal = sample_.getMcContainer().histogram->GetBinContent(bin_);
-    double mcuncert = sample_.getMcContainer().histogram->GetBinError(bin_);
+    double dataVal = dataVal_;
+    double predVal = predVal_;
+    double mcuncert = std::sqrt(mcSumw2_); // TH1::GetBinError()
 
     //implementing Barlow-Beeston correction for LH calculation
     //the following comments are inspired/copied from Clarence's comments in the MaCh3
@@ -112,19 +146,28 @@ namespace JointProbability{
     }
 
     if(std::isinf(chisq)){
-      LogAlert << "Infinite chi2 " << predVal << " " << dataVal
-               << sample_.getMcContainer().histogram->GetBinError(bin_) << " "
-               << sample_.getMcContainer().histogram->GetBinContent(bin_) << std::endl;
+      LogAlert << "Infinite chi2 " << predVal << " " << dataVal << " " << mcuncert << std::endl;
     }
 
     return chisq;
   }
+
   double BarlowLLH_BANFF_OA2021::eval(const FitSample& sample_, int bin_){
+    return evalBin(
+        sample_.getMcContainer().histogram->GetBinContent(bin_),
+        sample_.getMcContainer().histogram->GetSumw2()->GetAt(bin_),
+        sample_.getDataContainer().histogram->GetBinContent(bin_)
+    );
+  }
+  double BarlowLLH_BANFF_OA2021::eval(const double* mcArray_, const double* mcSumw2Array_, const double* dataArray_, size_t nBins_) const{
+    return evalBinArray<BarlowLLH_BANFF_OA2021>(mcArray_, mcSumw2Array_, dataArray_, nBins_);
+  }
+  inline double BarlowLLH_BANFF_OA2021::evalBin(double predVal_, double mcSumw2_, double dataVal_){
     // From OA2021_Eb branch -> BANFFBinnedSample::CalcLLRContrib
 
-    double dataVal = sample_.getDataContainer().histogram->GetBinContent(bin_);
-    double predVal = sample_.getMcContainer().histogram->GetBinContent(bin_);
-    double mcuncert = sample_.getMcContainer().histogram->GetBinError(bin_);
+    double dataVal = dataVal_;
+    double predVal = predVal_;
+    double mcuncert = std::sqrt(mcSumw2_); // TH1::GetBinError()
 
     double chisq = 0.0;
 
@@ -190,9 +233,7 @@ namespace JointProbability{
 
     if (std::isinf(chisq))
     {
-      LogAlert << "Infinite chi2 " << predVal << " " << dataVal
-               << sample_.getMcContainer().histogram->GetBinError(bin_) << " "
-               << sample_.getMcContainer().histogram->GetBinContent(bin_) << std::endl;
+      LogAlert << "Infinite chi2 " << predVal << " " << dataVal << " " << mcuncert << std::endl;
     }
 //    }
 
@@ -20,7 +20,7 @@ PhysicsEvent::~PhysicsEvent() { this->reset(); }
 void PhysicsEvent::reset() {
   _commonLeafNameListPtr_ = nullptr;
   _leafContentList_.clear();
-  _rawDialPtrList_.clear();
+  _rawDialPtrList_ = DialIdList();
 
   // Weight carriers
   _dataSetIndex_=-1;
@@ -141,10 +141,10 @@ const std::vector<std::vector<GenericToolbox::AnyType>> &PhysicsEvent::getLeafCo
 std::vector<std::vector<GenericToolbox::AnyType>> &PhysicsEvent::getLeafContentList(){
   return _leafContentList_;
 }
-std::vector<Dial *> &PhysicsEvent::getRawDialPtrList() {
+DialIdList &PhysicsEvent::getRawDialPtrList() {
   return _rawDialPtrList_;
 }
-const std::vector<Dial *> &PhysicsEvent::getRawDialPtrList() const{
+const DialIdList &PhysicsEvent::getRawDialPtrList() const{
   return _rawDialPtrList_;
 }
 
@@ -166,7 +166,7 @@ void PhysicsEvent::reweightUsingDialCache(){
 #ifdef USE_ACCUMULATE_PHYSICSEVENT
   _eventWeight_ = std::accumulate(
     _rawDialPtrList_.begin(), _rawDialPtrList_.end(), _treeWeight_,
-    [](double weight_, auto& dial){
+    [](double weight_, Dial* dial){
       if( dial == nullptr or dial->isMasked() ) return weight_;
 #ifdef CACHE_MANAGER_SLOW_VALIDATION
     double response = dial->evalResponse();
@@ -266,7 +266,7 @@ void PhysicsEvent::reweightUsingDialCache(){
 #else
   // bare dials
   _eventWeight_ = _treeWeight_;
-  for( auto& dial : _rawDialPtrList_ ){
+  for( auto* dial : _rawDialPtrList_ ){
     if( dial == nullptr ) return;
     if( Dial::enableMaskCheck and dial->isMasked() ){ continue; }
     _eventWeight_ *= dial->evalResponse();
@@ -424,6 +424,9 @@ double PhysicsEvent::evalFormula(TFormula* formulaPtr_, std::vector<int>* indexD
 
   return formulaPtr_->EvalPar(nullptr, &parArray[0]);
 }
+double PhysicsEvent::evalFormula(const CompiledFormula& formula_) const{
+  return formula_.eval([this](int varIndex_){ return this->getVarAsDouble(varIndex_); });
+}
 
 std::string PhysicsEvent::getSummary() const {
   std::stringstream ss;
@@ -469,12 +472,11 @@ void PhysicsEvent::print() const {
 }
 void PhysicsEvent::trimDialCache(){
   size_t newSize{0};
-  for( auto& dial : _rawDialPtrList_ ){
+  for( auto* dial : _rawDialPtrList_ ){
     if( dial == nullptr ) break;
     newSize++;
   }
   _rawDialPtrList_.resize(newSize);
-  _rawDialPtrList_.shrink_to_fit();
 
   // nested dials
   newSize = 0;
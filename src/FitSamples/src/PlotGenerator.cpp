@@ -19,6 +19,8 @@
 #include "string"
 #include "vector"
 #include "sstream"
+#include "algorithm"
+#include "limits"
 
 LoggerInit([]{
   Logger::setUserHeaderStr("[PlotGenerator]");
@@ -42,6 +44,8 @@ void PlotGenerator::reset() {
   _fitSampleSetPtr_ = nullptr;
 
   _histHolderCacheList_.resize(1);
+  _eventBinTableList_.clear();
+  _fillSlotContentList_.clear();
 }
 
 void PlotGenerator::setConfig(const nlohmann::json &config_) {
@@ -65,6 +69,8 @@ void PlotGenerator::initialize() {
 void PlotGenerator::defineHistogramHolders() {
   LogWarning << __METHOD_NAME__ << std::endl;
   _histHolderCacheList_[0].clear();
+  _eventBinTableList_.clear();
+  _fillSlotContentList_.clear();
 
   HistHolder histDefBase;
   if( _fitSampleSetPtr_ != nullptr ){
@@ -291,6 +297,9 @@ const std::vector<HistHolder> &PlotGenerator::getHistHolderList(int cacheSlot_)
 const std::vector<HistHolder> &PlotGenerator::getComparisonHistHolderList() const {
   return _comparisonHistHolderList_;
 }
+const std::vector<EventBinTable> &PlotGenerator::getEventBinTableList() const {
+  return _eventBinTableList_;
+}
 std::map<std::string, std::shared_ptr<TCanvas>> PlotGenerator::getBufferCanvasList() const {
   return _bufferCanvasList_;
 }
@@ -303,7 +312,7 @@ void PlotGenerator::generateSamplePlots(TDirectory *saveDir_, int cacheSlot_) {
   this->generateSampleHistograms(GenericToolbox::mkdirTFile(saveDir_, "histograms"), cacheSlot_);
   this->generateCanvas(_histHolderCacheList_[cacheSlot_], GenericToolbox::mkdirTFile(saveDir_, "canvas"));
 }
-void PlotGenerator::generateSampleHistograms(TDirectory *saveDir_, int cacheSlot_) {
+void PlotGenerator::generateSampleHistograms(TDirectory *saveDir_, int cacheSlot_, const std::vector<std::vector<double>>* fillSlotDeltaList_) {
   LogWarning << __METHOD_NAME__ << std::endl;
 
   if( _histogramsDefinition_.empty() ){
@@ -360,69 +369,20 @@ void PlotGenerator::generateSampleHistograms(TDirectory *saveDir_, int cacheSlot
 
   // Fill histograms
   if( _fitSampleSetPtr_ != nullptr ){
-    for( const auto& sample : _fitSampleSetPtr_->getFitSampleList() ){
-      // Datasets:
-      for( bool isData : { false, true } ){
-
-        const std::vector<PhysicsEvent>* eventListPtr;
-        std::vector<HistHolder*> histPtrToFillList;
-
-        if( isData ){
-          eventListPtr = &sample.getDataContainer().eventList;
-
-          // which hist should be filled?
-          for( auto& histDef : _histHolderCacheList_[cacheSlot_] ){
-            if(histDef.isData and histDef.fitSamplePtr == &sample ){
-              histPtrToFillList.emplace_back( &histDef );
-            }
-          }
-        }
-        else{
-          eventListPtr = &sample.getMcContainer().eventList;
-
-          // which hist should be filled?
-          for( auto& histDef : _histHolderCacheList_[cacheSlot_] ){
-            if(not histDef.isData and histDef.fitSamplePtr == &sample ){
-              histPtrToFillList.emplace_back( &histDef );
-            }
-          }
-        }
-
-        for( auto& histPtrToFill : histPtrToFillList ){
-          if( not histPtrToFill->isBinCacheBuilt ){
-            // If any, launch rebuild cache
-            LogInfo << "Build event bin cache for sample \"" << sample.getName() << "\"" << std::endl;
-            this->buildEventBinCache(histPtrToFillList, eventListPtr, isData);
-            break; // all caches done at once
-          }
-        }
-
-
-        // Filling the selected histograms
-        int nThreads = GlobalVariables::getNbThreads();
-        std::function<void(int)> fillJob = [&]( int iThread ){
-          int iEvent = -1;
-          int iHist = -1;
-          std::string pBarTitle;
-          if( iThread == 0 ) pBarTitle = LogDebug.getPrefixString() + "Filling histograms of sample \"" + sample.getName() + "\"";
-
-          for( auto& hist : histPtrToFillList ){
-            for( int iBin = iThread+1 ; iBin <= hist->histPtr->GetNbinsX() ; iBin += nThreads ){
-              hist->histPtr->SetBinContent(iBin, 0);
-              for( auto* evtPtr : hist->_binEventPtrList_[iBin-1] ){
-                hist->histPtr->AddBinContent(iBin, evtPtr->getEventWeight());
-              }
-              hist->histPtr->SetBinError(iBin, TMath::Sqrt(hist->histPtr->GetBinContent(iBin)));
-            }
-          }
-        };
-
-        GlobalVariables::getParallelWorker().addJob("fillJob", fillJob);
-        GlobalVariables::getParallelWorker().runJob("fillJob");
-        GlobalVariables::getParallelWorker().removeJob("fillJob");
-
-      } // isData loop
-    } // sample
+    if( _eventBinTableList_.empty() ){ this->buildEventBinTables(_histHolderCacheList_[cacheSlot_]); }
+    if( fillSlotDeltaList_ == nullptr ){
+      for( size_t iTable = 0 ; iTable < _eventBinTableList_.size() ; iTable++ ){
+        this->fillHistograms(iTable, _histHolderCacheList_[cacheSlot_]);
+      }
+    }
+    else{
+      LogThrowIf(_fillSlotContentList_.size() != _eventBinTableList_.size(), "No full fill to start from.")
+      LogThrowIf(fillSlotDeltaList_->size() != _eventBinTableList_.size(), "Fill slot deltas don't match the event bin tables.")
+      for( size_t iTable = 0 ; iTable < _eventBinTableList_.size() ; iTable++ ){
+        this->writeFillSlotsInHistograms(_eventBinTableList_[iTable], _fillSlotContentList_[iTable],
+                                         (*fillSlotDeltaList_)[iTable], _histHolderCacheList_[cacheSlot_]);
+      }
+    }
   }
   else{
     LogThrow("Samples not set.")
@@ -870,37 +830,164 @@ std::vector<std::string> PlotGenerator::fetchRequestedLeafNames(){
   return varNameList;
 }
 
-void PlotGenerator::buildEventBinCache(const std::vector<HistHolder *> &histPtrToFillList, const std::vector<PhysicsEvent> *eventListPtr, bool isData_) {
+void PlotGenerator::buildEventBinTables(const std::vector<HistHolder>& histHolderList_){
+  LogInfo << "Building the event bin tables..." << std::endl;
+  _eventBinTableList_.clear();
+
+  for( const auto& sample : _fitSampleSetPtr_->getFitSampleList() ){
+    for( bool isData : { false, true } ){
+      EventBinTable table;
+      table.eventListPtr = ( isData ? &sample.getDataContainer().eventList : &sample.getMcContainer().eventList );
+      if( isData and sample.getDataContainer().isReferencingEvents() ){
+        table.eventListPtr = sample.getDataContainer().referencedEventListPtr;
+        table.weightListPtr = &sample.getDataContainer().frozenWeightList;
+      }
+      else if( isData and sample.getDataContainer().isCompacted ){
+        table.eventListPtr = nullptr;
+        table.weightListPtr = &sample.getDataContainer().frozenWeightList;
+        table.compactContainerPtr = &sample.getDataContainer();
+      }
+      // packed leaves: the plotted variables are read from the hot columns of the container owning the events
+      if( table.eventListPtr == &sample.getMcContainer().eventList and sample.getMcContainer().isLeavesPacked() ){
+        table.compactContainerPtr = &sample.getMcContainer();
+      }
+      else if( table.eventListPtr == &sample.getDataContainer().eventList and sample.getDataContainer().isLeavesPacked() ){
+        table.compactContainerPtr = &sample.getDataContainer();
+      }
+      table.nbEvents = ( isData ? sample.getDataContainer().getNbEvents() : sample.getMcContainer().getNbEvents() );
+      table.isData = isData;
+
+      std::vector<size_t> histSlotOffset(histHolderList_.size(), 0);
+      std::vector<std::vector<size_t>> columnList; // hist indices sharing a column
+      for( size_t iHist = 0 ; iHist < histHolderList_.size() ; iHist++ ){
+        const auto& hist = histHolderList_[iHist];
+        if( hist.fitSamplePtr != &sample or hist.isData != isData ) continue;
+
+        histSlotOffset[iHist] = table.nbFillSlots;
+        table.histSlotOffsetList.emplace_back(iHist, table.nbFillSlots);
+        table.nbFillSlots += size_t(hist.histPtr->GetNbinsX());
+
+        bool isPlaced{false};
+        for( auto& column : columnList ){
+          if( hist.splitVarName.empty() ) break; // no split: nothing to share
+          const auto& ref = histHolderList_[column[0]];
+          if( ref.varToPlot != hist.varToPlot or ref.splitVarName != hist.splitVarName
+              or ref.xEdges != hist.xEdges or ref.histPtr->GetNbinsX() != hist.histPtr->GetNbinsX() ) continue;
+          if( std::any_of(column.begin(), column.end(), [&](size_t i){ return histHolderList_[i].splitVarValue == hist.splitVarValue; }) ) continue;
+          column.emplace_back(iHist);
+          isPlaced = true;
+          break;
+        }
+        if( not isPlaced ){ columnList.emplace_back(1, iHist); }
+      }
+      if( table.histSlotOffsetList.empty() ) continue;
+      LogThrowIf(table.nbFillSlots > size_t(std::numeric_limits<int>::max()), "Too many histogram bins to be indexed for sample: " << sample.getName())
+
+      LogInfo << "Build event bin table for sample \"" << sample.getName() << "\" (" << (isData ? "data" : "mc") << "): "
+              << table.nbEvents << " events x " << columnList.size() << " columns." << std::endl;
+
+      table.nbColumns = columnList.size();
+      table.fillSlotTable.resize(table.nbEvents * table.nbColumns, -1);
+
+      std::function<void(int)> fillEventBinTable = [&](int iThread_){
+        int nThreads = GlobalVariables::getNbThreads();
+        if( iThread_ == -1 ){ iThread_ = 0; nThreads = 1; }
+
+        // compacted events only have their columns left, packed events their hot columns
+        auto getVarAsDouble = [&](size_t iEvent_, const std::string& varName_){
+          if( table.compactContainerPtr != nullptr ){ return table.compactContainerPtr->getCompactVarValue(iEvent_, varName_); }
+          return (*table.eventListPtr)[iEvent_].getVarAsDouble(varName_);
+        };
+        auto getSampleBinIndex = [&](size_t iEvent_){
+          if( table.eventListPtr == nullptr ){ return table.compactContainerPtr->frozenBinIndexList[iEvent_]; }
+          return (*table.eventListPtr)[iEvent_].getSampleBinIndex();
+        };
 
-  std::function<void(int)> fillEventHistCache = [&](int iThread_){
-    int iHistCache{-1};
-    std::string pBarTitle;
-    for( auto& histPtrToFill : histPtrToFillList ){
-      iHistCache++;
+        size_t nEvents = table.nbEvents;
+        for( size_t iEvent = nEvents*iThread_/nThreads ; iEvent < nEvents*(iThread_+1)/nThreads ; iEvent++ ){
+          int* rowPtr = &table.fillSlotTable[iEvent * table.nbColumns];
 
-      if( iHistCache % GlobalVariables::getNbThreads() != iThread_ ) continue;
+          for( size_t iColumn = 0 ; iColumn < columnList.size() ; iColumn++ ){
+            const auto& ref = histHolderList_[columnList[iColumn][0]];
 
-      if( not histPtrToFill->isBinCacheBuilt ){
+            size_t iHist = columnList[iColumn][0];
+            if( not ref.splitVarName.empty() ){
+              int splitValue = int(getVarAsDouble(iEvent, ref.splitVarName));
+              auto histIndexIt = std::find_if(columnList[iColumn].begin(), columnList[iColumn].end(),
+                                              [&](size_t i){ return histHolderList_[i].splitVarValue == splitValue; });
+              if( histIndexIt == columnList[iColumn].end() ) continue;
+              iHist = *histIndexIt;
+            }
 
-        histPtrToFill->_binEventPtrList_.resize(histPtrToFill->histPtr->GetNbinsX());
-        int iBin{-1};
-        for( const auto& event : *eventListPtr ){
-          if( histPtrToFill->splitVarName.empty() or event.getVarValue<int>(histPtrToFill->splitVarName) == histPtrToFill->splitVarValue){
-            if( histPtrToFill->varToPlot == "Raw" ) iBin = event.getSampleBinIndex();
-            else iBin = histPtrToFill->histPtr->FindBin(event.getVarAsDouble(histPtrToFill->varToPlot));
-            if( iBin > 0 and iBin <= histPtrToFill->histPtr->GetNbinsX() ){
+            int iBin;
+            if( ref.varToPlot == "Raw" ) iBin = getSampleBinIndex(iEvent);
+            else iBin = ref.histPtr->GetXaxis()->FindFixBin(getVarAsDouble(iEvent, ref.varToPlot));
+            if( iBin > 0 and iBin <= ref.histPtr->GetNbinsX() ){
               // so it's a valid bin!
-              histPtrToFill->_binEventPtrList_[iBin-1].emplace_back(&event);
+              rowPtr[iColumn] = int(histSlotOffset[iHist]) + iBin - 1;
             }
           }
         }
-        histPtrToFill->isBinCacheBuilt = true;
+      };
+
+      GlobalVariables::getParallelWorker().addJob("fillEventBinTable", fillEventBinTable);
+      GlobalVariables::getParallelWorker().runJob("fillEventBinTable");
+      GlobalVariables::getParallelWorker().removeJob("fillEventBinTable");
+
+      _eventBinTableList_.emplace_back(std::move(table));
+    } // isData
+  } // sample
+
+}
+void PlotGenerator::fillHistograms(size_t iTable_, std::vector<HistHolder>& histHolderList_){
+  const auto& table_ = _eventBinTableList_[iTable_];
+
+  int nThreads = GlobalVariables::getNbThreads();
+  if( _fillBufferPerThread_.size() < size_t(nThreads) ){ _fillBufferPerThread_.resize(nThreads); }
+
+  // Single sweep over the events: each thread accumulates its partial sums in its own buffer
+  std::function<void(int)> fillJob = [&](int iThread_){
+    int nJobThreads = nThreads;
+    if( iThread_ == -1 ){ iThread_ = 0; nJobThreads = 1; }
+
+    auto& buffer = _fillBufferPerThread_[iThread_];
+    buffer.assign(table_.nbFillSlots, 0);
+
+    size_t nEvents = table_.nbEvents;
+    size_t iEventEnd = nEvents*(iThread_+1)/nJobThreads;
+    const int* rowPtr = table_.fillSlotTable.data() + nEvents*iThread_/nJobThreads * table_.nbColumns;
+    for( size_t iEvent = nEvents*iThread_/nJobThreads ; iEvent < iEventEnd ; iEvent++ ){
+      double weight = ( table_.weightListPtr != nullptr ? (*table_.weightListPtr)[iEvent] : (*table_.eventListPtr)[iEvent].getEventWeight() );
+      for( size_t iColumn = 0 ; iColumn < table_.nbColumns ; iColumn++ ){
+        if( rowPtr[iColumn] != -1 ){ buffer[rowPtr[iColumn]] += weight; }
       }
+      rowPtr += table_.nbColumns;
     }
   };
 
-  GlobalVariables::getParallelWorker().addJob("fillEventHistCache", fillEventHistCache);
-  GlobalVariables::getParallelWorker().runJob("fillEventHistCache");
-  GlobalVariables::getParallelWorker().removeJob("fillEventHistCache");
+  GlobalVariables::getParallelWorker().addJob("fillJob", fillJob);
+  GlobalVariables::getParallelWorker().runJob("fillJob");
+  GlobalVariables::getParallelWorker().removeJob("fillJob");
+
+  // Merge the partial sums
+  if( _fillSlotContentList_.size() != _eventBinTableList_.size() ){ _fillSlotContentList_.resize(_eventBinTableList_.size()); }
+  auto& fillSlotContent = _fillSlotContentList_[iTable_];
+  fillSlotContent.assign(table_.nbFillSlots, 0);
+  for( int iThread = 0 ; iThread < nThreads ; iThread++ ){
+    for( size_t iSlot = 0 ; iSlot < table_.nbFillSlots ; iSlot++ ){ fillSlotContent[iSlot] += _fillBufferPerThread_[iThread][iSlot]; }
+  }
 
+  this->writeFillSlotsInHistograms(table_, fillSlotContent, {}, histHolderList_);
+}
+void PlotGenerator::writeFillSlotsInHistograms(const EventBinTable& table_, const std::vector<double>& fillSlotContent_,
+                                               const std::vector<double>& fillSlotDelta_, std::vector<HistHolder>& histHolderList_){
+  for( const auto& histSlot : table_.histSlotOffsetList ){
+    auto& hist = histHolderList_[histSlot.first].histPtr;
+    for( int iBin = 1 ; iBin <= hist->GetNbinsX() ; iBin++ ){
+      double binContent = fillSlotContent_[histSlot.second + iBin - 1];
+      if( not fillSlotDelta_.empty() ){ binContent += fillSlotDelta_[histSlot.second + iBin - 1]; }
+      hist->SetBinContent(iBin, binContent);
+      hist->SetBinError(iBin, TMath::Sqrt(binContent));
+    }
+  }
 }
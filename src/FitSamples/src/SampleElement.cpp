@@ -7,8 +7,13 @@
 
 #include "Logger.h"
 #include "GenericToolbox.h"
+#include "GenericToolbox.Root.h"
 
 #include "TRandom.h"
+#include "RZip.h"
+
+#include <algorithm>
+#include <cstring>
 
 
 LoggerInit([]{ Logger::setUserHeaderStr("[SampleElement]"); });
@@ -24,6 +29,202 @@ void SampleElement::reserveEventMemory(size_t dataSetIndex_, size_t nEvents, con
   eventNbList.emplace_back(nEvents);
   eventList.resize(eventOffSetList.back()+eventNbList.back(), eventBuffer_);
 }
+void SampleElement::reserveDialMemory(size_t nEvents_, size_t nDialsPerEvent_){
+  // one block for the last nEvents_ reserved events, each of them gets nDialsPerEvent_ slots
+  LogThrowIf(nEvents_ > eventList.size(), "Can't reserve dials for more events than the container holds");
+  if( nEvents_ == 0 or nDialsPerEvent_ == 0 ){ return; }
+  dialIdBlockList.emplace_back(nEvents_ * nDialsPerEvent_, DialRegistry::invalidId);
+  uint32_t* slotPtr = dialIdBlockList.back().data();
+  for( size_t iEvent = eventList.size() - nEvents_ ; iEvent < eventList.size() ; iEvent++ ){
+    eventList[iEvent].getRawDialPtrList().setBuffer(slotPtr, nDialsPerEvent_);
+    slotPtr += nDialsPerEvent_;
+  }
+}
+void SampleElement::compactDialMemory(){
+  // move the dial lists, trimmed once the events are indexed, in a single block of the exact size
+  size_t nDials = std::accumulate(eventList.begin(), eventList.end(), size_t(0),
+                                  [](size_t sum_, const PhysicsEvent& ev_){ return sum_ + ev_.getRawDialPtrList().size(); });
+  std::vector<uint32_t> dialIdBlock(nDials, DialRegistry::invalidId);
+  uint32_t* slotPtr = dialIdBlock.data();
+  for( auto& event : eventList ){
+    size_t nEventDials = event.getRawDialPtrList().size();
+    std::copy(event.getRawDialPtrList().data(), event.getRawDialPtrList().data() + nEventDials, slotPtr);
+    event.getRawDialPtrList().setBuffer(slotPtr, nEventDials);
+    slotPtr += nEventDials;
+  }
+  dialIdBlockList.clear();
+  if( nDials != 0 ){ dialIdBlockList.emplace_back(std::move(dialIdBlock)); }
+}
+void SampleElement::releaseDialMemory(){
+  for( auto& event : eventList ){ event.getRawDialPtrList() = DialIdList(); }
+  std::vector<std::vector<uint32_t>>().swap(dialIdBlockList);
+}
+void SampleElement::referenceEvents(const std::vector<PhysicsEvent>& eventList_){
+  LogThrowIf(isLocked, "Can't " << __METHOD_NAME__ << " while locked");
+  LogThrowIf(not eventList.empty(), "Can't reference events in a container that already holds some.");
+  referencedEventListPtr = &eventList_;
+  frozenWeightList.resize(eventList_.size());
+  frozenBinIndexList.resize(eventList_.size());
+  for( size_t iEvent = 0 ; iEvent < eventList_.size() ; iEvent++ ){
+    frozenWeightList[iEvent] = eventList_[iEvent].getEventWeight();
+    frozenBinIndexList[iEvent] = eventList_[iEvent].getSampleBinIndex();
+  }
+}
+void SampleElement::dropEvents(){
+  LogThrowIf(not isLocked, "Can't " << __METHOD_NAME__ << " before the histogram is locked");
+  std::vector<PhysicsEvent>().swap(eventList);
+  std::vector<std::vector<uint32_t>>().swap(dialIdBlockList);
+  std::vector<double>().swap(frozenWeightList);
+  std::vector<int>().swap(frozenBinIndexList);
+  std::vector<std::vector<PhysicsEvent*>>(perBinEventPtrList.size()).swap(perBinEventPtrList);
+  referencedEventListPtr = nullptr;
+  isCompacted = false;
+  std::vector<std::string>().swap(compactVarNameList);
+  std::vector<std::vector<double>>().swap(compactVarColumnList);
+  std::vector<LeafBlock>().swap(leafBlockList);
+  leafPrototypeList.clear();
+  leafBlockSize = 0;
+}
+void SampleElement::compactEvents(const std::vector<std::string>& varNameList_){
+  LogThrowIf(not isLocked, "Can't " << __METHOD_NAME__ << " before the histogram is locked");
+  LogThrowIf(isReferencingEvents(), "Can't " << __METHOD_NAME__ << " on referenced events");
+
+  frozenWeightList.resize(eventList.size());
+  frozenBinIndexList.resize(eventList.size());
+  compactVarNameList = varNameList_;
+  compactVarColumnList.assign(compactVarNameList.size(), std::vector<double>(eventList.size()));
+  std::vector<int> varIndexList;
+  for( auto& varName : compactVarNameList ){ varIndexList.emplace_back(eventList.empty() ? -1 : eventList[0].findVarIndex(varName)); }
+
+  for( size_t iEvent = 0 ; iEvent < eventList.size() ; iEvent++ ){
+    frozenWeightList[iEvent] = eventList[iEvent].getEventWeight();
+    frozenBinIndexList[iEvent] = eventList[iEvent].getSampleBinIndex();
+    for( size_t iVar = 0 ; iVar < varIndexList.size() ; iVar++ ){
+      compactVarColumnList[iVar][iEvent] = eventList[iEvent].getVarAsDouble(varIndexList[iVar]);
+    }
+  }
+
+  std::vector<PhysicsEvent>().swap(eventList);
+  std::vector<std::vector<uint32_t>>().swap(dialIdBlockList);
+  std::vector<std::vector<PhysicsEvent*>>(perBinEventPtrList.size()).swap(perBinEventPtrList);
+  isCompacted = true;
+}
+void SampleElement::packLeaves(const std::vector<std::string>& hotVarNameList_, int compressionSettings_, size_t blockSize_){
+  LogThrowIf(isUsingFrozenColumns(), "Can't " << __METHOD_NAME__ << " on referenced or compacted events");
+  LogThrowIf(isLeavesPacked(), "Leaves of \"" << name << "\" are already packed");
+  LogThrowIf(blockSize_ == 0, "Invalid leaf block size");
+  if( eventList.empty() ){ return; }
+
+  // Hot variables: dense columns (the ones that are not stored leaves have already been used while loading)
+  compactVarNameList.clear();
+  std::vector<int> varIndexList;
+  for( auto& varName : hotVarNameList_ ){
+    int varIndex = eventList[0].findVarIndex(varName, false);
+    if( varIndex == -1 or GenericToolbox::doesElementIsInVector(varName, compactVarNameList) ){ continue; }
+    compactVarNameList.emplace_back(varName);
+    varIndexList.emplace_back(varIndex);
+  }
+  compactVarColumnList.assign(compactVarNameList.size(), std::vector<double>(eventList.size()));
+
+  // Types of the leaves: taken from the first event having them filled
+  const auto& leafNameList = *eventList[0].getCommonLeafNameListPtr();
+  leafPrototypeList.assign(leafNameList.size(), std::vector<GenericToolbox::AnyType>());
+  for( size_t iLeaf = 0 ; iLeaf < leafNameList.size() ; iLeaf++ ){
+    for( auto& event : eventList ){
+      if( event.getLeafHolder(int(iLeaf)).empty() ) continue;
+      leafPrototypeList[iLeaf].emplace_back(event.getLeafHolder(int(iLeaf))[0]);
+      char typeTag = GenericToolbox::findOriginalVariableType(leafPrototypeList[iLeaf][0]);
+      LogThrowIf( typeTag == 0 or typeTag == char(0xFF), leafNameList[iLeaf] << " has an invalid leaf type." )
+      break;
+    }
+  }
+
+  // Cold leaves: [nElements (uint32), raw content of each element] for each leaf of each event, then compressed by block
+  leafBlockSize = blockSize_;
+  std::vector<char> rawBuffer;
+  for( size_t iFirstEvent = 0 ; iFirstEvent < eventList.size() ; iFirstEvent += leafBlockSize ){
+    leafBlockList.emplace_back();
+    auto& block = leafBlockList.back();
+    block.nbEvents = std::min(leafBlockSize, eventList.size() - iFirstEvent);
+
+    rawBuffer.clear();
+    for( size_t iEvent = iFirstEvent ; iEvent < iFirstEvent + block.nbEvents ; iEvent++ ){
+      auto& event = eventList[iEvent];
+      for( size_t iVar = 0 ; iVar < varIndexList.size() ; iVar++ ){
+        compactVarColumnList[iVar][iEvent] = event.getVarAsDouble(varIndexList[iVar]);
+      }
+      for( auto& leaf : event.getLeafContentList() ){
+        auto nbElements = uint32_t(leaf.size());
+        rawBuffer.insert(rawBuffer.end(), (const char*) &nbElements, (const char*) &nbElements + sizeof(nbElements));
+        for( auto& element : leaf ){
+          auto* ph = element.getPlaceHolderPtr();
+          rawBuffer.insert(rawBuffer.end(), (const char*) ph->getVariableAddress(), (const char*) ph->getVariableAddress() + ph->getVariableSize());
+        }
+      }
+      std::vector<std::vector<GenericToolbox::AnyType>>().swap(event.getLeafContentList());
+    }
+
+    block.rawSize = rawBuffer.size();
+    block.buffer.resize(block.rawSize);
+    size_t srcOffset{0};
+    size_t tgtOffset{0};
+    while( srcOffset < block.rawSize ){
+      // R__zip handles at most kMAXZIPBUF bytes per call
+      int srcSize = int(std::min(size_t(kMAXZIPBUF), block.rawSize - srcOffset));
+      int tgtSize = int(std::min(size_t(srcSize), block.buffer.size() - tgtOffset));
+      int zipSize{0};
+      R__zip(compressionSettings_, &srcSize, &rawBuffer[srcOffset], &tgtSize, &block.buffer[tgtOffset], &zipSize);
+      if( zipSize == 0 ){ block.isCompressed = false; break; } // not compressible: kept as is
+      srcOffset += size_t(srcSize);
+      tgtOffset += size_t(zipSize);
+    }
+    if( block.isCompressed ){ block.buffer.resize(tgtOffset); }
+    else{ block.buffer = rawBuffer; }
+    block.buffer.shrink_to_fit();
+  }
+}
+void SampleElement::unpackLeafBlock(size_t iBlock_, std::vector<std::vector<std::vector<GenericToolbox::AnyType>>>& leafContentListBuffer_) const{
+  LogThrowIf(iBlock_ >= leafBlockList.size(), "Invalid leaf block index: " << iBlock_);
+  const auto& block = leafBlockList[iBlock_];
+
+  std::vector<char> rawBuffer;
+  const char* rawPtr = block.buffer.data();
+  if( block.isCompressed ){
+    rawBuffer.resize(block.rawSize);
+    size_t srcOffset{0};
+    size_t tgtOffset{0};
+    while( tgtOffset < block.rawSize ){
+      int srcSize{0};
+      int tgtSize{0};
+      int unzipSize{0};
+      LogThrowIf(R__unzip_header(&srcSize, (unsigned char*) &block.buffer[srcOffset], &tgtSize) != 0,
+                 "Corrupted leaf block " << iBlock_ << " in \"" << name << "\"");
+      R__unzip(&srcSize, (unsigned char*) &block.buffer[srcOffset], &tgtSize, (unsigned char*) &rawBuffer[tgtOffset], &unzipSize);
+      LogThrowIf(unzipSize != tgtSize, "Could not decompress leaf block " << iBlock_ << " in \"" << name << "\"");
+      srcOffset += size_t(srcSize);
+      tgtOffset += size_t(tgtSize);
+    }
+    rawPtr = rawBuffer.data();
+  }
+
+  leafContentListBuffer_.resize(block.nbEvents);
+  for( auto& leafContentList : leafContentListBuffer_ ){
+    leafContentList.resize(leafPrototypeList.size());
+    for( size_t iLeaf = 0 ; iLeaf < leafPrototypeList.size() ; iLeaf++ ){
+      uint32_t nbElements;
+      std::memcpy(&nbElements, rawPtr, sizeof(nbElements));
+      rawPtr += sizeof(nbElements);
+      leafContentList[iLeaf].clear();
+      if( nbElements == 0 ){ continue; }
+      leafContentList[iLeaf].resize(nbElements, leafPrototypeList[iLeaf][0]);
+      for( auto& element : leafContentList[iLeaf] ){
+        auto* ph = element.getPlaceHolderPtr();
+        std::memcpy((void*) ph->getVariableAddress(), rawPtr, ph->getVariableSize());
+        rawPtr += ph->getVariableSize();
+      }
+    }
+  }
+}
 void SampleElement::shrinkEventList(size_t newTotalSize_){
   LogThrowIf(isLocked, "Can't " << __METHOD_NAME__ << " while locked");
   if( eventNbList.empty() and newTotalSize_ == 0 ) return;
@@ -37,7 +238,7 @@ void SampleElement::shrinkEventList(size_t newTotalSize_){
   eventList.shrink_to_fit();
 }
 void SampleElement::updateEventBinIndexes(int iThread_){
-  if( isLocked ) return;
+  if( isLocked or isReferencingEvents() or isLeavesPacked() ) return; // referenced or packed bins are frozen
   int nBins = int(binning.getBinsList().size());
   if(iThread_ <= 0) LogInfo << "Finding bin indexes for \"" << name << "\"..." << std::endl;
   int toDelete = 0;
@@ -68,7 +269,7 @@ void SampleElement::updateEventBinIndexes(int iThread_){
 //  LogTrace << iThread_ << " -> unbinned events: " << toDelete << std::endl;
 }
 void SampleElement::updateBinEventList(int iThread_) {
-  if( isLocked ) return;
+  if( isLocked or isReferencingEvents() ) return; // filled from the frozen columns
 
   if(iThread_ <= 0) LogInfo << "Filling bin event cache for \"" << name << "\"..." << std::endl;
   int nBins = int(perBinEventPtrList.size());
@@ -100,6 +301,33 @@ void SampleElement::refillHistogram(int iThread_){
     iThread_ = 0;
   }
 
+  bool isHistogramChanged{false};
+
+  if( isReferencingEvents() ){
+    // frozen columns: a single sweep over the events, done by the first thread
+    if( iThread_ != 0 ) return;
+    std::vector<double> contentList(perBinEventPtrList.size(), 0);
+    for( size_t iEvent = 0 ; iEvent < frozenWeightList.size() ; iEvent++ ){
+      if( frozenBinIndexList[iEvent] < 0 ) continue;
+      contentList[frozenBinIndexList[iEvent]] += frozenWeightList[iEvent];
+    }
+    auto* binContentArray = histogram->GetArray();
+    auto* binErrorArray = histogram->GetSumw2()->GetArray();
+    for( size_t iBin = 0 ; iBin < contentList.size() ; iBin++ ){
+      if( binContentArray[iBin + 1] != contentList[iBin] * histScale
+          or binErrorArray[iBin + 1] != contentList[iBin] * histScale * histScale ){
+        isHistogramChanged = true;
+      }
+      binContentArray[iBin + 1] = contentList[iBin];
+      binErrorArray[iBin + 1] = contentList[iBin];
+    }
+    if( isHistogramChanged ){
+      if( not isHistogramChangedPerThread.empty() ){ isHistogramChangedPerThread[0] = true; }
+      else{ histogramVersion++; }
+    }
+    return;
+  }
+
 #ifdef GUNDAM_USING_CACHE_MANAGER
   // Size = Nbins + 2 overflow (0 and last)
   auto* binContentArray = histogram->GetArray();
@@ -142,6 +370,12 @@ void SampleElement::refillHistogram(int iThread_){
             content += eventPtr->getEventWeight();
         }
     }
+    // compare with what will be left after rescaleHistogram()
+    if( not isHistogramChanged
+        and ( binContentArray[iBin+1] != content * histScale
+              or histogram->GetSumw2()->GetArray()[iBin+1] != content * histScale * histScale ) ){
+      isHistogramChanged = true;
+    }
     binContentArray[iBin+1] = content;
     histogram->GetSumw2()->GetArray()[iBin+1] = content;
     iBin += nbThreads;
@@ -153,12 +387,20 @@ void SampleElement::refillHistogram(int iThread_){
   int nBins = int(perBinEventPtrList.size());
   auto* binContentArray = histogram->GetArray();
   auto* binErrorArray = histogram->GetSumw2()->GetArray();
+  double content;
   while( iBin < nBins ) {
-    binContentArray[iBin + 1] = 0;
+    content = 0;
     for (auto *eventPtr: perBinEventPtrList[iBin]) {
-      binContentArray[iBin + 1] += eventPtr->getEventWeight();
+      content += eventPtr->getEventWeight();
+    }
+    // compare with what will be left after rescaleHistogram()
+    if( not isHistogramChanged
+        and ( binContentArray[iBin + 1] != content * histScale
+              or binErrorArray[iBin + 1] != content * histScale * histScale ) ){
+      isHistogramChanged = true;
     }
-    binErrorArray[iBin + 1] = binContentArray[iBin + 1];
+    binContentArray[iBin + 1] = content;
+    binErrorArray[iBin + 1] = content;
     iBin += nbThreads;
   }
 
@@ -177,35 +419,79 @@ void SampleElement::refillHistogram(int iThread_){
 //    errBin += nbThreads;
 //  }
 #endif
+
+  // each thread has its own slot
+  if( isHistogramChanged ){
+    if( size_t(iThread_) < isHistogramChangedPerThread.size() ){ isHistogramChangedPerThread[iThread_] = true; }
+    else{ histogramVersion++; } // not sized for threads: only reached by single thread calls
+  }
 }
 void SampleElement::rescaleHistogram() {
   if( isLocked ) return;
   if( histScale != 1 ) histogram->Scale(histScale);
+  this->updateHistogramVersion();
+}
+void SampleElement::updateHistogramVersion(){
+  // called after the parallel refill
+  if( std::any_of(isHistogramChangedPerThread.begin(), isHistogramChangedPerThread.end(), [](char c_){ return c_; }) ){
+    histogramVersion++;
+    std::fill(isHistogramChangedPerThread.begin(), isHistogramChangedPerThread.end(), false);
+  }
 }
 
 void SampleElement::throwStatError(){
   int nCounts;
+  std::vector<double> binScaleList(isReferencingEvents() ? histogram->GetNbinsX() : 0, 1);
   for( int iBin = 1 ; iBin <= histogram->GetNbinsX() ; iBin++ ){
     nCounts = gRandom->Poisson(histogram->GetBinContent(iBin));
     for (auto *eventPtr: perBinEventPtrList[iBin-1]) {
       eventPtr->setEventWeight(eventPtr->getEventWeight()*((double)nCounts/histogram->GetBinContent(iBin)));
     }
+    if( isReferencingEvents() ){ binScaleList[iBin-1] = (double)nCounts/histogram->GetBinContent(iBin); }
     histogram->SetBinContent(iBin, nCounts);
   }
+  for( size_t iEvent = 0 ; iEvent < frozenWeightList.size() ; iEvent++ ){
+    if( frozenBinIndexList[iEvent] < 0 ) continue;
+    frozenWeightList[iEvent] *= binScaleList[frozenBinIndexList[iEvent]];
+  }
+  histogramVersion++;
 }
 
 double SampleElement::getSumWeights() const{
+  if( isUsingFrozenColumns() ){ return std::accumulate(frozenWeightList.begin(), frozenWeightList.end(), double(0.)); }
   return std::accumulate(eventList.begin(), eventList.end(), double(0.),
                          [](double sum_, const PhysicsEvent& ev_){ return sum_ + ev_.getEventWeight(); });
 }
 size_t SampleElement::getNbBinnedEvents() const{
+  if( isUsingFrozenColumns() ){ return size_t(std::count_if(frozenBinIndexList.begin(), frozenBinIndexList.end(), [](int i_){ return i_ != -1; })); }
   return std::accumulate(eventList.begin(), eventList.end(), size_t(0.),
                          [](size_t sum_, const PhysicsEvent& ev_){ return sum_ + (ev_.getSampleBinIndex() != -1); });
 }
+bool SampleElement::isReferencingEvents() const{
+  return referencedEventListPtr != nullptr;
+}
+bool SampleElement::isUsingFrozenColumns() const{
+  return isReferencingEvents() or isCompacted;
+}
+bool SampleElement::isLeavesPacked() const{
+  return not leafBlockList.empty();
+}
+size_t SampleElement::getPackedLeavesSize() const{
+  return std::accumulate(leafBlockList.begin(), leafBlockList.end(), size_t(0),
+                         [](size_t sum_, const LeafBlock& block_){ return sum_ + block_.buffer.size(); });
+}
+size_t SampleElement::getNbEvents() const{
+  return ( isUsingFrozenColumns() ? frozenWeightList.size() : eventList.size() );
+}
+double SampleElement::getCompactVarValue(size_t iEvent_, const std::string& varName_) const{
+  int iVar = GenericToolbox::findElementIndex(varName_, compactVarNameList);
+  LogThrowIf(iVar == -1, "Variable \"" << varName_ << "\" was not kept in the compact events of \"" << name << "\"");
+  return compactVarColumnList[iVar][iEvent_];
+}
 
 void SampleElement::print() const{
   LogInfo << "SampleElement: " << name << std::endl;
   LogInfo << " - " << "Nb bins: " << binning.getBinsList().size() << std::endl;
-  LogInfo << " - " << "Nb events: " << eventList.size() << std::endl;
+  LogInfo << " - " << "Nb events: " << getNbEvents() << std::endl;
   LogInfo << " - " << "Hist rescale: " << histScale << std::endl;
 }
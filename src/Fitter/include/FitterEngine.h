@@ -21,6 +21,10 @@
 #include "string"
 #include "vector"
 #include "memory"
+#include "unordered_map"
+#include "chrono"
+#include "cmath"
+#include "list"
 
 
 class FitterEngine {
@@ -37,6 +41,9 @@ public:
   void setConfig(const nlohmann::json &config_);
   void setNbScanSteps(int nbScanSteps);
   void setEnablePostFitScan(bool enablePostFitScan);
+  void setCheckpointFilePath(const std::string& checkpointFilePath_);
+  void setResumeCheckpointFilePath(const std::string& resumeCheckpointFilePath_);
+  void setWarmStartFilePath(const std::string& warmStartFilePath_);
 
   // Init
   void initialize();
@@ -47,6 +54,10 @@ public:
   double getChi2StatBuffer() const;
   const Propagator& getPropagator() const;
   Propagator& getPropagator();
+  bool isFitDone() const;
+  bool isUseNormalizedFitSpace() const;
+  const std::vector<FitParameter*>& getMinimizerFitParameterPtr() const;
+  const std::shared_ptr<ROOT::Math::Minimizer>& getMinimizer() const;
 
   // Core
   void generateSamplePlots(const std::string& savePath_ = "");
@@ -55,12 +66,13 @@ public:
   void fixGhostFitParameters();
   void scanParameters(int nbSteps_ = -1, const std::string& saveDir_ = "");
   void scanParameter(int iPar, int nbSteps_ = -1, const std::string& saveDir_ = "");
+  void scanParameterPairs(const std::string& saveDir_ = "");
 
   void fit();
   void updateChi2Cache();
   double evalFit(const double* parArray_);
 
-  void writePostFitData(TDirectory* saveDir_);
+  void writePostFitData(TDirectory* saveDir_, const TMatrixDSym* covMatrix_ = nullptr); // covMatrix_ in fit space, taken from the minimizer if nullptr
 
 protected:
   void rescaleParametersStepSize();
@@ -68,6 +80,52 @@ protected:
 
   void checkNumericalAccuracy();
 
+  // Per-thread buffers of the parallel scans: the events and dials are shared and only read
+  struct ScanReplica{
+    std::vector<std::vector<double>> mcBinContentList{}; // [iSample][iBin], same layout as the TH1D arrays
+    std::vector<std::vector<double>> mcBinSumw2List{};
+    std::vector<double> llhStatPerSample{};
+    std::vector<double> sumWeightsPerSample{};
+    std::vector<char> isSampleModifiedList{};
+    double chi2{0};
+    double chi2Stat{0};
+    double chi2Pulls{0};
+  };
+
+  // Parameters moved together on the replicas
+  struct ReplicaMove{
+    std::unordered_map<const FitParameter*, std::vector<double>> slopeList{}; // original parameter shift per unit of each moved one
+    std::vector<std::pair<size_t, size_t>> eventList{}; // {iSample, iEvent} reweighted by the move
+    std::vector<char> isSampleAffectedList{};
+    std::vector<double> penaltyGradient{};
+    std::vector<std::vector<double>> penaltyHessian{};
+  };
+
+  ScanReplica buildReferenceReplica();
+  ReplicaMove buildReplicaMove(const std::vector<FitParameter*>& parList_, bool withPenalty_ = true);
+  void evalReplicaMove(const ReplicaMove& move_, const std::vector<double>& shiftList_, const ScanReplica& reference_, ScanReplica& replica_);
+
+  // Evaluates the chi2 at each point (values of the fit parameters iFitParList_) in parallel, without touching the propagator
+  void evalPointsOnReplicas(const std::vector<int>& iFitParList_, const std::vector<std::vector<double>>& pointList_,
+                            const std::function<void(size_t, const ScanReplica&)>& processPointFct_);
+  void scanParameterPair(int iPar, int jPar, const nlohmann::json& pairConfig_, const std::string& saveDir_);
+
+  // MINOS errors of all the fit parameters, shared across the threads with one minimizer per replica
+  void evalMinosErrorsOnReplicas(std::vector<double>& errLowList_, std::vector<double>& errHighList_,
+                                 std::vector<int>& minosStatusList_, std::vector<char>& isMinosOkList_);
+
+  // Checkpoints: the minimizer point, the nb of calls and the chi2 history, so a killed fit can be resumed
+  void writeCheckpoint(const std::string& stage_);
+  std::string loadCheckpoint(); // returns the stage of the loaded checkpoint
+  std::string evalEventCacheFingerprint();
+
+  // Starting point (and step sizes / error matrix) from the post-fit parameters of a previous output file
+  void warmStartFromFile(const nlohmann::json& warmStartConfig_);
+
+  // Gauss-Newton approximation of the Hessian: returns the post-fit covariance matrix in fit space
+  TMatrixDSym evalAnalyticCovarianceMatrix();
+  void compareAnalyticCovarianceWithHesse(const TMatrixDSym& analyticCovMatrix_, TDirectory* saveDir_);
+
 
 
 private:
@@ -84,6 +142,7 @@ private:
   bool _enableFitMonitor_{false};
   bool _fitHasConverged_{false};
   bool _isBadCovMat_{false};
+  bool _isMinimizing_{false};
 
   int _nbFitCalls_{0};
   int _nbFitParameters_{0};
@@ -103,6 +162,18 @@ private:
 
   ScanConfig _scanConfig_;
 
+  // Checkpoints
+  std::string _checkpointFilePath_{};
+  std::string _resumeCheckpointFilePath_{};
+  double _checkpointIntervalInSeconds_{300};
+  bool _useEventCacheFingerprint_{true};
+  std::chrono::steady_clock::time_point _lastCheckpointTime_{};
+  double _checkpointBestChi2_{std::nan("unset")};
+  std::vector<double> _checkpointBestPoint_{};
+
+  // Warm start
+  std::string _warmStartFilePath_{};
+
   // Buffers
   double _chi2Buffer_{0};
   double _chi2StatBuffer_{0};
@@ -110,6 +181,19 @@ private:
   double _chi2RegBuffer_{0};
   double _parStepGain_{0.1};
 
+  // Likelihood memoization: chi2 buffers of the last fit points, exact matches only, most recently used first
+  struct Chi2CacheEntry{
+    std::vector<double> fitPoint{};
+    double chi2{0};
+    double chi2Stat{0};
+    double chi2Pulls{0};
+    double chi2Reg{0};
+  };
+  size_t _chi2CacheSize_{16};
+  std::list<Chi2CacheEntry> _chi2CacheList_;
+  int _nbChi2CacheHits_{0};
+  bool _isPropagatorStale_{false}; // a cache hit doesn't propagate the parameters on the samples
+
   TTree* _chi2HistoryTree_{nullptr};
 //  std::map<std::string, std::vector<double>> _chi2History_;
 
@@ -117,6 +201,7 @@ private:
   GenericToolbox::CycleTimer _evalFitAvgTimer_;
   GenericToolbox::CycleTimer _outEvalFitAvgTimer_;
   GenericToolbox::CycleTimer _itSpeed_;
+  GenericToolbox::CycleTimer _penaltyEvalTimer_;
 
   const std::map<int, std::string> minuitStatusCodeStr{
       { 0 , "status = 0    : OK" },
@@ -153,12 +238,16 @@ private:
   };
 
 
+  std::vector<ScanReplica> _scanReplicaList_;
+  std::unordered_map<const FitParameter*, std::vector<std::pair<size_t, size_t>>> _scanParameterEventMap_;
+
   struct ScanData{
     std::string folder{};
     std::string title{};
     std::string yTitle{};
     std::vector<double> yPoints{};
     std::function<double()> evalY{};
+    std::function<double(const ScanReplica&)> evalReplicaY{};
   };
   std::vector<ScanData> scanDataDict;
 
@@ -0,0 +1,152 @@
+//
+// MCMCEngine.h
+//
+
+#ifndef GUNDAM_MCMCENGINE_H
+#define GUNDAM_MCMCENGINE_H
+
+
+#include "FitterEngine.h"
+
+#include "GenericToolbox.CycleTimer.h"
+
+#include "TDirectory.h"
+#include "TRandom3.h"
+#include "TTree.h"
+#include "nlohmann/json.hpp"
+
+#include "string"
+#include "vector"
+#include "memory"
+
+
+// Adaptive Metropolis-Hastings sampling of the free fit parameters. The chains run in parallel over the events of the
+// propagator, which are only read: each chain reweights them into its own histogram buffers.
+class MCMCEngine {
+
+public:
+  MCMCEngine();
+  virtual ~MCMCEngine();
+
+  // Reset
+  void reset();
+
+  // Setters
+  void setSaveDir(TDirectory *saveDir);
+  void setConfig(const nlohmann::json &config_);
+  void setFitterEngine(FitterEngine *fitterEnginePtr_);
+
+  // Init
+  void initialize();
+
+  // Core
+  void run();
+
+protected:
+  void buildEventTables();
+  void buildPenaltyQuadraticForm();
+  void buildInitialProposal();
+  void initializeChains();
+
+  struct Chain;
+  void evalChi2(Chain& chain_, const std::vector<double>& parValueList_, double& chi2Stat_, double& chi2Pulls_);
+  void runSteps(Chain& chain_, int nbSteps_);
+  void updateProposal(Chain& chain_);
+  void writeSteps();
+
+
+private:
+  // Parameters
+  TDirectory* _saveDir_{nullptr};
+  nlohmann::json _config_{};
+  FitterEngine* _fitterEnginePtr_{nullptr};
+
+  int _nbChains_{-1};
+  int _nbSteps_{10000};
+  int _nbBurnInSteps_{1000};
+  int _nbStepsPerBlock_{1000};
+  int _adaptationInterval_{500};
+  bool _saveBurnIn_{false};
+  double _targetAcceptance_{0.234};
+  double _startingPointSpread_{0};
+  int _compressionSettings_{404}; // algorithm*100 + level
+  std::string _proposalCovariance_{"auto"}; // "priors", "postFitHessian" or "auto"
+
+  // Internals
+  bool _isInitialized_{false};
+  std::vector<FitParameter*> _freeParList_; // the sampled parameters (fit parameters not fixed)
+  std::vector<double> _startValueList_;
+
+  // Original parameters reweighting the events: value = start + sum_k slope_k * (x_k - x0_k)
+  std::vector<const FitParameter*> _origParList_;
+  std::vector<double> _origStartValueList_;
+  std::vector<std::vector<std::pair<size_t, double>>> _origSlopeList_; // [iFreePar] -> {iOrigPar, slope}
+
+  // Per sample: events folded into a constant weight times the dials of the moving parameters
+  struct EventTable{
+    std::vector<double> baseWeightList{};                // tree weight x responses of the dials not moving
+    std::vector<int> binIndexList{};                     // sample bin, -1 if none
+    std::vector<size_t> dialOffsetList{};                // [iEvent] -> first entry in dialList, size nEvents+1
+    std::vector<std::pair<Dial*, size_t>> dialList{};    // {dial, iOrigPar}
+    double histScale{1};
+    const double* dataBinContent{nullptr};               // skips underflow
+    size_t nbBins{0};
+  };
+  std::vector<EventTable> _eventTableList_;
+
+  // The penalty is quadratic in the parameters: P(x) = P0 + g.dx + dx.H.dx/2
+  double _penaltyStart_{0};
+  std::vector<double> _penaltyGradient_;
+  std::vector<std::vector<double>> _penaltyHessian_;
+
+  std::vector<double> _initialProposalCov_; // nPars x nPars
+
+  struct Chain{
+    TRandom3 prng{};
+    std::vector<double> parValueList{};
+    double chi2{0};
+    double chi2Stat{0};
+    double chi2Pulls{0};
+
+    // per-chain weight buffers
+    std::vector<double> origParValueList{};
+    std::vector<std::vector<double>> binContentList{};
+    std::vector<std::vector<double>> binSumw2List{};
+    std::vector<double> proposedValueList{};
+    std::vector<double> normalDrawList{};
+
+    // proposal: L.z*scale with L lower triangular
+    std::vector<double> choleskyLowerList{};
+    double proposalScale{1};
+    int nbAdaptationSteps{0};
+    int nbWindowAccepted{0};
+    int nbWindowSteps{0};
+    std::vector<double> meanList{};
+    std::vector<double> covSumList{};
+
+    int nbStepsDone{0};
+    int nbAccepted{0};
+
+    // steps waiting to be written
+    std::vector<double> stepParValueList{};
+    std::vector<double> stepChi2List{};
+    std::vector<double> stepChi2StatList{};
+    std::vector<double> stepChi2PullsList{};
+    std::vector<int> stepIndexList{};
+    std::vector<char> stepAcceptedList{};
+  };
+  std::vector<Chain> _chainList_;
+
+  TTree* _stepTree_{nullptr};
+  int _stepTreeChain_{0};
+  int _stepTreeStep_{0};
+  double _stepTreeChi2_{0};
+  double _stepTreeChi2Stat_{0};
+  double _stepTreeChi2Pulls_{0};
+  bool _stepTreeAccepted_{false};
+  std::vector<double> _stepTreeParValueList_;
+
+};
+
+
+#endif //GUNDAM_MCMCENGINE_H
@@ -21,6 +21,8 @@ public:
   int getNbPoints() const;
   const std::pair<double, double> &getParameterSigmaRange() const;
   bool isUseParameterLimits() const;
+  bool isUseParallelScan() const;
+  const nlohmann::json &getTwoDimScanList() const;
 
 protected:
   void readConfig();
@@ -32,6 +34,8 @@ private:
   int _nbPoints_{100};
   std::pair<double, double> _parameterSigmaRange_{-3,3};
   bool _useParameterLimits_{true};
+  bool _useParallelScan_{false};
+  nlohmann::json _twoDimScanList_{}; // entries: {"parameters": [a, b], "nbPoints", "nbRefinements", "deltaChi2Levels", "profile"}
 
 
 };
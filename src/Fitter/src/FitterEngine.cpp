@@ -5,6 +5,7 @@
 #include "FitterEngine.h"
 #include "JsonUtils.h"
 #include "GlobalVariables.h"
+#include "Dial.h"
 
 #include "Logger.h"
 #include "GenericToolbox.Root.h"
@@ -15,10 +16,23 @@
 #include "TGraph.h"
 #include "TLegend.h"
 #include "TH1D.h"
+#include "TH2D.h"
+#include "TROOT.h"
+#include "TList.h"
+#include "TObjArray.h"
 #include "TBox.h"
+#include "TMD5.h"
+#include "TSystem.h"
+#include "TParameter.h"
+#include "Math/ParameterSettings.h"
+#include "RVersion.h"
 
 #include <cmath>
+#include <cstring>
 #include <memory>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdio>
 
 
 LoggerInit([]{
@@ -71,6 +85,15 @@ void FitterEngine::setNbScanSteps(int nbScanSteps) {
 void FitterEngine::setEnablePostFitScan(bool enablePostFitScan) {
   _enablePostFitScan_ = enablePostFitScan;
 }
+void FitterEngine::setCheckpointFilePath(const std::string& checkpointFilePath_) {
+  _checkpointFilePath_ = checkpointFilePath_;
+}
+void FitterEngine::setResumeCheckpointFilePath(const std::string& resumeCheckpointFilePath_) {
+  _resumeCheckpointFilePath_ = resumeCheckpointFilePath_;
+}
+void FitterEngine::setWarmStartFilePath(const std::string& warmStartFilePath_) {
+  _warmStartFilePath_ = warmStartFilePath_;
+}
 
 void FitterEngine::initialize() {
 
@@ -196,8 +219,20 @@ void FitterEngine::initialize() {
 
   this->initializeMinimizer();
 
+  auto warmStartConfig = JsonUtils::fetchValue(_config_, "warmStartConfig", nlohmann::json());
+  if( _warmStartFilePath_.empty() ){ _warmStartFilePath_ = JsonUtils::fetchValue(warmStartConfig, "filePath", _warmStartFilePath_); }
+  if( not _warmStartFilePath_.empty() ){ this->warmStartFromFile(warmStartConfig); }
+
   _scanConfig_ = ScanConfig( JsonUtils::fetchValue(_config_, "scanConfig", nlohmann::json()) );
 
+  auto checkpointConfig = JsonUtils::fetchValue(_config_, "checkpointConfig", nlohmann::json());
+  if( _checkpointFilePath_.empty() ){ _checkpointFilePath_ = JsonUtils::fetchValue(checkpointConfig, "filePath", _checkpointFilePath_); }
+  _checkpointIntervalInSeconds_ = JsonUtils::fetchValue(checkpointConfig, "intervalInSeconds", _checkpointIntervalInSeconds_);
+  _useEventCacheFingerprint_ = JsonUtils::fetchValue(checkpointConfig, "useEventCacheFingerprint", _useEventCacheFingerprint_);
+  if( not _checkpointFilePath_.empty() ){
+    LogInfo << "Fit checkpoints will be written every " << _checkpointIntervalInSeconds_ << "s in: " << _checkpointFilePath_ << std::endl;
+  }
+
 //  checkNumericalAccuracy();
 }
 
@@ -216,6 +251,18 @@ const Propagator& FitterEngine::getPropagator() const {
 Propagator& FitterEngine::getPropagator() {
   return _propagator_;
 }
+bool FitterEngine::isFitDone() const {
+  return _fitIsDone_;
+}
+bool FitterEngine::isUseNormalizedFitSpace() const {
+  return _useNormalizedFitSpace_;
+}
+const std::vector<FitParameter*>& FitterEngine::getMinimizerFitParameterPtr() const {
+  return _minimizerFitParameterPtr_;
+}
+const std::shared_ptr<ROOT::Math::Minimizer>& FitterEngine::getMinimizer() const {
+  return _minimizer_;
+}
 
 void FitterEngine::generateSamplePlots(const std::string& savePath_){
   LogInfo << __METHOD_NAME__ << std::endl;
@@ -269,6 +316,12 @@ void FitterEngine::generateOneSigmaPlots(const std::string& savePath_){
   };
 
   // +1 sigma
+  struct OneSigmaEntry{
+    FitParameterSet* parSetPtr{nullptr};
+    FitParameter* parPtr{nullptr};
+    std::string savePath{};
+  };
+  std::vector<OneSigmaEntry> oneSigmaEntryList;
   for( auto& parSet : _propagator_.getParameterSetsList() ){
 
     if( not parSet.isEnabled() ) continue;
@@ -286,7 +339,7 @@ void FitterEngine::generateOneSigmaPlots(const std::string& savePath_){
         std::string savePath = savePath_;
         if( not savePath.empty() ) savePath += "/";
         savePath += "oneSigma/eigen/" + parSet.getName() + "/" + eigenPar.getTitle() + tag;
-        makeOneSigmaPlotFct(eigenPar, savePath);
+        oneSigmaEntryList.push_back({&parSet, &eigenPar, savePath});
       }
     }
     else{
@@ -297,12 +350,141 @@ void FitterEngine::generateOneSigmaPlots(const std::string& savePath_){
         std::string savePath = savePath_;
         if( not savePath.empty() ) savePath += "/";
         savePath += "oneSigma/original/" + parSet.getName() + "/" + par.getTitle() + tag;
-        makeOneSigmaPlotFct(par, savePath);
+        oneSigmaEntryList.push_back({&parSet, &par, savePath});
       }
     }
 
   }
 
+  if( not JsonUtils::fetchValue(_config_, "incrementalOneSigmaPlots", false) ){
+    for( auto& entry : oneSigmaEntryList ){ makeOneSigmaPlotFct(*entry.parPtr, entry.savePath); }
+  }
+  else{
+    // Only the events reweighted by the moved parameter are looked at: their weight shifts are added
+    // on top of the reference fill. The shifts of several parameters are computed concurrently.
+    LogInfo << "Generating the +1σ plots incrementally..." << std::endl;
+    auto& plotGenerator = _propagator_.getPlotGenerator();
+    const auto& tableList = plotGenerator.getEventBinTableList();
+
+    // {iSample, iEvent} -> {iTable, iEvent}
+    auto parEventList = _propagator_.buildParameterEventMap();
+    std::vector<int> sampleMcTableIndexList(_propagator_.getFitSampleSet().getFitSampleList().size(), -1);
+    for( size_t iSample = 0 ; iSample < sampleMcTableIndexList.size() ; iSample++ ){
+      for( size_t iTable = 0 ; iTable < tableList.size() ; iTable++ ){
+        if( not tableList[iTable].isData
+            and tableList[iTable].eventListPtr == &_propagator_.getFitSampleSet().getFitSampleList()[iSample].getMcContainer().eventList ){
+          sampleMcTableIndexList[iSample] = int(iTable);
+        }
+      }
+    }
+    for( auto& parEvents : parEventList ){
+      // events of samples without any histogram are dropped
+      size_t nKept{0};
+      for( auto& eventIndex : parEvents.second ){
+        if( sampleMcTableIndexList[eventIndex.first] == -1 ) continue;
+        parEvents.second[nKept++] = {size_t(sampleMcTableIndexList[eventIndex.first]), eventIndex.second};
+      }
+      parEvents.second.resize(nKept);
+    }
+
+    int nThreads = GlobalVariables::getNbThreads();
+    size_t batchSize = std::max(size_t(1), JsonUtils::fetchValue(_config_, "oneSigmaPlotsBatchSize", size_t(nThreads)));
+    std::vector<std::unordered_map<const FitParameter*, double>> shiftedValueBatch(batchSize); // original parameters only
+    std::vector<std::vector<std::vector<double>>> fillSlotDeltaBatch(batchSize); // [iEntry][iTable][iFillSlot]
+
+    for( size_t iBatchStart = 0 ; iBatchStart < oneSigmaEntryList.size() ; iBatchStart += batchSize ){
+      size_t nEntries = std::min(batchSize, oneSigmaEntryList.size() - iBatchStart);
+
+      // The eigen propagation is done serially as it touches the parameter sets
+      for( size_t iEntry = 0 ; iEntry < nEntries ; iEntry++ ){
+        auto& entry = oneSigmaEntryList[iBatchStart + iEntry];
+        auto& shiftedValueList = shiftedValueBatch[iEntry];
+        shiftedValueList.clear();
+
+        double currentParValue = entry.parPtr->getParameterValue();
+        if( not entry.parSetPtr->isUseEigenDecompInFit() ){
+          shiftedValueList[entry.parPtr] = currentParValue + entry.parPtr->getStdDevValue();
+          continue;
+        }
+
+        std::vector<double> currentValueList;
+        for( auto& par : entry.parSetPtr->getParameterList() ){ currentValueList.emplace_back(par.getParameterValue()); }
+        entry.parPtr->setParameterValue( currentParValue + entry.parPtr->getStdDevValue() );
+        entry.parSetPtr->propagateEigenToOriginal();
+        for( size_t iPar = 0 ; iPar < currentValueList.size() ; iPar++ ){
+          auto& par = entry.parSetPtr->getParameterList()[iPar];
+          if( par.getParameterValue() != currentValueList[iPar] ){ shiftedValueList[&par] = par.getParameterValue(); }
+        }
+        entry.parPtr->setParameterValue( currentParValue );
+        entry.parSetPtr->propagateEigenToOriginal();
+      }
+
+      std::function<void(int)> evalWeightShiftsFct = [&](int iThread_){
+        int nJobThreads = nThreads;
+        if( iThread_ == -1 ){ iThread_ = 0; nJobThreads = 1; }
+
+        for( size_t iEntry = iThread_ ; iEntry < nEntries ; iEntry += nJobThreads ){
+          const auto& shiftedValueList = shiftedValueBatch[iEntry];
+          auto& fillSlotDeltaList = fillSlotDeltaBatch[iEntry];
+          fillSlotDeltaList.assign(tableList.size(), {});
+
+          std::vector<std::pair<size_t, size_t>> eventList;
+          for( const auto& shiftedValue : shiftedValueList ){
+            auto parEventListIt = parEventList.find(shiftedValue.first);
+            if( parEventListIt == parEventList.end() ) continue;
+            eventList.insert(eventList.end(), parEventListIt->second.begin(), parEventListIt->second.end());
+          }
+          if( shiftedValueList.size() > 1 ){
+            std::sort(eventList.begin(), eventList.end());
+            eventList.erase(std::unique(eventList.begin(), eventList.end()), eventList.end());
+          }
+
+          for( const auto& eventIndex : eventList ){
+            const auto& table = tableList[eventIndex.first];
+            const auto& event = (*table.eventListPtr)[eventIndex.second];
+
+            // same as PhysicsEvent::reweightUsingDialCache, with the moved parameters evaluated out of the dial cache
+            double newWeight = event.getTreeWeight();
+            for( auto* dialPtr : event.getRawDialPtrList() ){
+              if( dialPtr == nullptr ) break;
+              if( Dial::enableMaskCheck and dialPtr->isMasked() ){ continue; }
+              auto shiftedValueIt = shiftedValueList.find(dialPtr->getOwner()->getOwner());
+              if( shiftedValueIt == shiftedValueList.end() ){ newWeight *= dialPtr->evalResponse(); }
+              else{ newWeight *= dialPtr->calcResponse(shiftedValueIt->second); }
+            }
+
+            double deltaWeight = newWeight - event.getEventWeight();
+            if( deltaWeight == 0 ) continue;
+
+            auto& fillSlotDelta = fillSlotDeltaList[eventIndex.first];
+            if( fillSlotDelta.empty() ){ fillSlotDelta.resize(table.nbFillSlots, 0); }
+            const int* rowPtr = &table.fillSlotTable[eventIndex.second * table.nbColumns];
+            for( size_t iColumn = 0 ; iColumn < table.nbColumns ; iColumn++ ){
+              if( rowPtr[iColumn] != -1 ){ fillSlotDelta[rowPtr[iColumn]] += deltaWeight; }
+            }
+          }
+        }
+      };
+      GlobalVariables::getParallelWorker().addJob("FitterEngine::evalOneSigmaWeightShifts", evalWeightShiftsFct);
+      GlobalVariables::getParallelWorker().runJob("FitterEngine::evalOneSigmaWeightShifts");
+      GlobalVariables::getParallelWorker().removeJob("FitterEngine::evalOneSigmaWeightShifts");
+
+      // Writing is serial
+      for( size_t iEntry = 0 ; iEntry < nEntries ; iEntry++ ){
+        auto& entry = oneSigmaEntryList[iBatchStart + iEntry];
+        LogInfo << "Processing " << entry.savePath << " -> " << entry.parPtr->getParameterValue() + entry.parPtr->getStdDevValue() << std::endl;
+
+        auto* saveDir = GenericToolbox::mkdirTFile(_saveDir_, entry.savePath );
+        saveDir->cd();
+
+        plotGenerator.generateSampleHistograms(nullptr, 1, &fillSlotDeltaBatch[iEntry]);
+
+        auto oneSigmaHistList = plotGenerator.getHistHolderList(1);
+        plotGenerator.generateComparisonPlots( oneSigmaHistList, refHistList, saveDir );
+      }
+    }
+  }
+
   _saveDir_->cd();
 
   // Since those were not saved, delete manually
@@ -314,82 +496,107 @@ void FitterEngine::generateOneSigmaPlots(const std::string& savePath_){
 void FitterEngine::fixGhostFitParameters(){
   LogInfo << __METHOD_NAME__ << std::endl;
 
+  // Replicas compute the weights from the dials: when RF are used, the chi2 is taken from the propagator instead
+  bool isParallel = not _propagator_.isUseResponseFunctions();
+  double threshold = JsonUtils::fetchValue(_config_, "ghostParameterDeltaChi2Threshold", 1E-6);
+
   _propagator_.allowRfPropagation(); // since we don't need the weight of each event (only the Chi2 value)
   updateChi2Cache();
 
   LogDebug << "Reference " << GUNDAM_CHI2 << " = " << _chi2StatBuffer_ << std::endl;
-  double baseChi2 = _chi2Buffer_;
   double baseChi2Stat = _chi2StatBuffer_;
-  double baseChi2Syst = _chi2PullsBuffer_;
 
-  // +1 sigma
-  int iFitPar = -1;
-  std::stringstream ssPrint;
-//  double deltaChi2;
-  double deltaChi2Stat;
-//  double deltaChi2Syst;
+  // Parameters reweighting no event are found from the mapping directly, the others are moved by +1 sigma on replicas
+  _scanParameterEventMap_ = _propagator_.buildParameterEventMap();
+  ScanReplica reference;
+  if( isParallel ){ reference = this->buildReferenceReplica(); }
+  int nThreads = GlobalVariables::getNbThreads();
+  if( int(_scanReplicaList_.size()) < nThreads ){ _scanReplicaList_.resize(nThreads); }
+
+#ifndef NOCOLOR
+  std::string red(GenericToolbox::ColorCodes::redBackground);
+  std::string rst(GenericToolbox::ColorCodes::resetColor);
+#else
+  std::string red;
+  std::string rst;
+#endif
 
   for( auto& parSet : _propagator_.getParameterSetsList() ){
 
     if( not JsonUtils::fetchValue(parSet.getConfig(), "fixGhostFitParameters", false) ) continue;
 
-    bool fixNextEigenPars{false};
     auto& parList = parSet.getEffectiveParameterList();
-    for( auto& par : parList ){
-      ssPrint.str("");
+    std::vector<FitParameter*> candidateList;
+    for( auto& par : parList ){ if( par.isEnabled() and not par.isFixed() ){ candidateList.emplace_back(&par); } }
+    std::vector<double> deltaChi2StatList(candidateList.size(), 0);
+    size_t nbWithoutEvents{0};
+
+    // batches of nThreads moves: the event lists of eigen parameters span the whole set
+    for( size_t iBatch = 0 ; iBatch < candidateList.size() ; iBatch += nThreads ){
+      std::vector<size_t> candidateIndexList;
+      std::vector<ReplicaMove> moveList;
+      for( size_t iCand = iBatch ; iCand < std::min(candidateList.size(), iBatch + nThreads) ; iCand++ ){
+        moveList.emplace_back(this->buildReplicaMove({candidateList[iCand]}, false));
+        if( moveList.back().eventList.empty() ){ nbWithoutEvents++; moveList.pop_back(); continue; }
+        candidateIndexList.emplace_back(iCand);
+      }
+
+      if( isParallel ){
+        std::function<void(int)> evalDeltaChi2Fct = [&](int iThread_){
+          int nJobThreads = nThreads;
+          if( iThread_ == -1 ){ iThread_ = 0; nJobThreads = 1; }
+
+          auto& replica = _scanReplicaList_[iThread_];
+          replica = reference;
+          for( size_t iMove = iThread_ ; iMove < moveList.size() ; iMove += nJobThreads ){
+            size_t iCand = candidateIndexList[iMove];
+            this->evalReplicaMove(moveList[iMove], {candidateList[iCand]->getStdDevValue()}, reference, replica);
+            deltaChi2StatList[iCand] = replica.chi2Stat - reference.chi2Stat;
+          }
+        };
+        GlobalVariables::getParallelWorker().addJob(__METHOD_NAME__, evalDeltaChi2Fct);
+        GlobalVariables::getParallelWorker().runJob(__METHOD_NAME__);
+        GlobalVariables::getParallelWorker().removeJob(__METHOD_NAME__);
+      }
+      else{
+        for( size_t iCand : candidateIndexList ){
+          auto& par = *candidateList[iCand];
+          double currentParValue = par.getParameterValue();
+          par.setParameterValue( currentParValue + par.getStdDevValue() );
+          updateChi2Cache();
+          deltaChi2StatList[iCand] = _chi2StatBuffer_ - baseChi2Stat;
+          par.setParameterValue( currentParValue );
+        }
+      }
+    }
 
+    LogInfo << parSet.getName() << ": " << nbWithoutEvents << "/" << candidateList.size()
+            << " parameter(s) reweight no event, " << candidateList.size() - nbWithoutEvents << " tested with +1" << GUNDAM_SIGMA << std::endl;
 
-      ssPrint << "(" << par.getParameterIndex()+1 << "/" << parList.size() << ") +1" << GUNDAM_SIGMA << " on " << parSet.getName() + "/" + par.getTitle();
+    bool fixNextEigenPars{false};
+    for( size_t iCand = 0 ; iCand < candidateList.size() ; iCand++ ){
+      auto& par = *candidateList[iCand];
 
       if( fixNextEigenPars ){
         par.setIsFixed(true);
-#ifndef NOCOLOR
-        std::string red(GenericToolbox::ColorCodes::redBackground);
-        std::string rst(GenericToolbox::ColorCodes::resetColor);
-#else
-        std::string red;
-        std::string rst;
-#endif
-//        LogInfo << red << ssPrint.str() << " -> FIXED AS NEXT EIGEN." << rst << std::endl;
         continue;
       }
 
-      if( par.isEnabled() and not par.isFixed() ){
-        double currentParValue = par.getParameterValue();
-        par.setParameterValue( currentParValue + par.getStdDevValue() );
-
-        ssPrint << " " << currentParValue << " -> " << par.getParameterValue();
-        LogInfo << ssPrint.str() << "..." << std::endl;
-
-        updateChi2Cache();
-        deltaChi2Stat = _chi2StatBuffer_ - baseChi2Stat;
-//        deltaChi2Syst = _chi2PullsBuffer_ - baseChi2Syst;
-//        deltaChi2 = _chi2Buffer_ - baseChi2;
-
-        ssPrint << ": " << GUNDAM_DELTA << GUNDAM_CHI2 << " (stat) = " << deltaChi2Stat;
-
-        LogInfo.moveTerminalCursorBack(1);
-        LogInfo << ssPrint.str() << std::endl;
+      std::stringstream ssPrint;
+      ssPrint << "(" << par.getParameterIndex()+1 << "/" << parList.size() << ") +1" << GUNDAM_SIGMA << " on " << parSet.getName() + "/" + par.getTitle();
+      ssPrint << ": " << GUNDAM_DELTA << GUNDAM_CHI2 << " (stat) = " << deltaChi2StatList[iCand];
 
-        if( std::abs(deltaChi2Stat) < JsonUtils::fetchValue(_config_, "ghostParameterDeltaChi2Threshold", 1E-6) ){
-          par.setIsFixed(true); // ignored in the Chi2 computation of the parSet
-          ssPrint << " < " << JsonUtils::fetchValue(_config_, "ghostParameterDeltaChi2Threshold", 1E-6) << " -> FIXED";
-          LogInfo.moveTerminalCursorBack(1);
-#ifndef NOCOLOR
-        std::string red(GenericToolbox::ColorCodes::redBackground);
-        std::string rst(GenericToolbox::ColorCodes::resetColor);
-#else
-        std::string red;
-        std::string rst;
-#endif
-          LogInfo << red << ssPrint.str() << rst << std::endl;
+      if( std::abs(deltaChi2StatList[iCand]) < threshold ){
+        par.setIsFixed(true); // ignored in the Chi2 computation of the parSet
+        ssPrint << " < " << threshold << " -> FIXED";
+        LogInfo << red << ssPrint.str() << rst << std::endl;
 
-          if( parSet.isUseEigenDecompInFit() and JsonUtils::fetchValue(_config_, "fixGhostEigenParmetersAfterFirstRejected", false) ){
-            fixNextEigenPars = true;
-          }
+        if( parSet.isUseEigenDecompInFit() and JsonUtils::fetchValue(_config_, "fixGhostEigenParmetersAfterFirstRejected", false) ){
+          fixNextEigenPars = true;
         }
-
-        par.setParameterValue( currentParValue );
+      }
+      else{
+        LogInfo << ssPrint.str() << std::endl;
       }
     }
 
@@ -401,15 +608,19 @@ void FitterEngine::fixGhostFitParameters(){
 
   }
 
+  _scanParameterEventMap_.clear();
   updateChi2Cache(); // comeback to old values
   _propagator_.preventRfPropagation();
 }
 void FitterEngine::scanParameters(int nbSteps_, const std::string &saveDir_) {
   LogInfo << "Performing parameter scans..." << std::endl;
+  if( _scanConfig_.isUseParallelScan() ){ _scanParameterEventMap_ = _propagator_.buildParameterEventMap(); } // shared by all scans
   for( int iPar = 0 ; iPar < _minimizer_->NDim() ; iPar++ ){
     if( _minimizer_->IsFixedVariable(iPar) ) continue;
     this->scanParameter(iPar, nbSteps_, saveDir_);
   } // iPar
+  this->scanParameterPairs(saveDir_ + "/2D");
+  _scanParameterEventMap_.clear();
 }
 void FitterEngine::scanParameter(int iPar, int nbSteps_, const std::string &saveDir_) {
   if( nbSteps_ < 0 ){ nbSteps_ = _scanConfig_.getNbPoints(); }
@@ -430,6 +641,7 @@ void FitterEngine::scanParameter(int iPar, int nbSteps_, const std::string &save
     scanEntry.title = "Total Likelihood Scan";
     scanEntry.yTitle = "LLH value";
     scanEntry.evalY = [this](){ return this->_chi2Buffer_; };
+    scanEntry.evalReplicaY = [](const ScanReplica& r_){ return r_.chi2; };
   }
   if( JsonUtils::fetchValue(_scanConfig_.getVarsConfig(), "llhPenalty", true) ){
     scanDataDict.emplace_back();
@@ -440,6 +652,7 @@ void FitterEngine::scanParameter(int iPar, int nbSteps_, const std::string &save
     scanEntry.title = "Penalty Likelihood Scan";
     scanEntry.yTitle = "Penalty LLH value";
     scanEntry.evalY = [this](){ return this->_chi2PullsBuffer_; };
+    scanEntry.evalReplicaY = [](const ScanReplica& r_){ return r_.chi2Pulls; };
   }
   if( JsonUtils::fetchValue(_scanConfig_.getVarsConfig(), "llhStat", true) ){
     scanDataDict.emplace_back();
@@ -449,6 +662,7 @@ void FitterEngine::scanParameter(int iPar, int nbSteps_, const std::string &save
     scanEntry.title = "Stat Likelihood Scan";
     scanEntry.yTitle = "Stat LLH value";
     scanEntry.evalY = [this](){ return this->_chi2StatBuffer_; };
+    scanEntry.evalReplicaY = [](const ScanReplica& r_){ return r_.chi2Stat; };
   }
   if( JsonUtils::fetchValue(_scanConfig_.getVarsConfig(), "llhStatPerSample", false) ){
     for( auto& sample : _propagator_.getFitSampleSet().getFitSampleList() ){
@@ -460,6 +674,8 @@ void FitterEngine::scanParameter(int iPar, int nbSteps_, const std::string &save
       scanEntry.yTitle = "Stat LLH value";
       auto* samplePtr = &sample;
       scanEntry.evalY = [this, samplePtr](){ return _propagator_.getFitSampleSet().evalLikelihood(*samplePtr); };
+      size_t iSample = samplePtr - &_propagator_.getFitSampleSet().getFitSampleList()[0];
+      scanEntry.evalReplicaY = [iSample](const ScanReplica& r_){ return r_.llhStatPerSample[iSample]; };
     }
   }
   if( JsonUtils::fetchValue(_scanConfig_.getVarsConfig(), "llhStatPerSamplePerBin", false) ){
@@ -476,6 +692,13 @@ void FitterEngine::scanParameter(int iPar, int nbSteps_, const std::string &save
         scanEntry.yTitle = "Stat LLH value";
         auto* samplePtr = &sample;
         scanEntry.evalY = [this, samplePtr, iBin](){ return _propagator_.getFitSampleSet().getJointProbabilityFct()->eval(*samplePtr, iBin); };
+        size_t iSample = samplePtr - &_propagator_.getFitSampleSet().getFitSampleList()[0];
+        scanEntry.evalReplicaY = [this, samplePtr, iSample, iBin](const ScanReplica& r_){
+          return _propagator_.getFitSampleSet().getJointProbabilityFct()->eval(
+              &r_.mcBinContentList[iSample][iBin], &r_.mcBinSumw2List[iSample][iBin],
+              samplePtr->getDataContainer().histogram->GetArray() + iBin, 1
+          );
+        };
       }
     }
   }
@@ -489,6 +712,8 @@ void FitterEngine::scanParameter(int iPar, int nbSteps_, const std::string &save
       scanEntry.yTitle = "Total MC event weight";
       auto* samplePtr = &sample;
       scanEntry.evalY = [samplePtr](){ return samplePtr->getMcContainer().getSumWeights(); };
+      size_t iSample = samplePtr - &_propagator_.getFitSampleSet().getFitSampleList()[0];
+      scanEntry.evalReplicaY = [iSample](const ScanReplica& r_){ return r_.sumWeightsPerSample[iSample]; };
     }
   }
   if( JsonUtils::fetchValue(_scanConfig_.getVarsConfig(), "weightPerSamplePerBin", false) ){
@@ -505,6 +730,8 @@ void FitterEngine::scanParameter(int iPar, int nbSteps_, const std::string &save
         scanEntry.yTitle = "Total MC event weight";
         auto* samplePtr = &sample;
         scanEntry.evalY = [samplePtr, iBin](){ return samplePtr->getMcContainer().histogram->GetBinContent(iBin); };
+        size_t iSample = samplePtr - &_propagator_.getFitSampleSet().getFitSampleList()[0];
+        scanEntry.evalReplicaY = [iSample, iBin](const ScanReplica& r_){ return r_.mcBinContentList[iSample][iBin]; };
       }
     }
   }
@@ -519,20 +746,35 @@ void FitterEngine::scanParameter(int iPar, int nbSteps_, const std::string &save
   }
 
   int offSet{0};
+  std::vector<double> parValueList(nbSteps_+1, 0);
   for( int iPt = 0 ; iPt < nbSteps_+1 ; iPt++ ){
-    GenericToolbox::displayProgressBar(iPt, nbSteps_, ssPbar.str());
-
     double newVal = lowBound + double(iPt-offSet)/(nbSteps_-1)*( highBound - lowBound );
     if( offSet == 0 and newVal > origVal ){
       newVal = origVal;
       offSet = 1;
     }
+    parValueList[iPt] = newVal;
+  }
 
-    _minimizerFitParameterPtr_[iPar]->setParameterValue(newVal);
-    this->updateChi2Cache();
-    parPoints[iPt] = _minimizerFitParameterPtr_[iPar]->getParameterValue();
+  if( _scanConfig_.isUseParallelScan() and not _propagator_.isUseResponseFunctions() ){
+    std::vector<std::vector<double>> pointList;
+    for( double parValue : parValueList ){ pointList.push_back({parValue}); }
+    this->evalPointsOnReplicas({iPar}, pointList, [&](size_t iPt_, const ScanReplica& replica_){
+      for( auto& scanEntry : scanDataDict ){ scanEntry.yPoints[iPt_] = scanEntry.evalReplicaY(replica_); }
+    });
+    parPoints = parValueList;
+    GenericToolbox::displayProgressBar(nbSteps_, nbSteps_, ssPbar.str());
+  }
+  else{
+    for( int iPt = 0 ; iPt < nbSteps_+1 ; iPt++ ){
+      GenericToolbox::displayProgressBar(iPt, nbSteps_, ssPbar.str());
+
+      _minimizerFitParameterPtr_[iPar]->setParameterValue(parValueList[iPt]);
+      this->updateChi2Cache();
+      parPoints[iPt] = _minimizerFitParameterPtr_[iPar]->getParameterValue();
 
-    for( auto& scanEntry : scanDataDict ){ scanEntry.yPoints[iPt] = scanEntry.evalY(); }
+      for( auto& scanEntry : scanDataDict ){ scanEntry.yPoints[iPt] = scanEntry.evalY(); }
+    }
   }
 
 
@@ -563,6 +805,571 @@ void FitterEngine::scanParameter(int iPar, int nbSteps_, const std::string &save
 
 }
 
+void FitterEngine::scanParameterPairs(const std::string& saveDir_){
+  if( _scanConfig_.getTwoDimScanList().empty() ) return;
+  LogInfo << "Performing 2D parameter scans..." << std::endl;
+
+  for( const auto& pairConfig : _scanConfig_.getTwoDimScanList() ){
+    auto parNameList = JsonUtils::fetchValue<std::vector<std::string>>(pairConfig, "parameters");
+    LogThrowIf(parNameList.size() != 2, "2D scan entries need exactly 2 parameters: " << pairConfig.dump());
+
+    std::vector<int> iFitParList;
+    for( const auto& parName : parNameList ){
+      for( int iFitPar = 0 ; iFitPar < int(_minimizer_->NDim()) ; iFitPar++ ){
+        if( _minimizer_->VariableName(iFitPar) == parName ){ iFitParList.emplace_back(iFitPar); break; }
+      }
+    }
+    if( iFitParList.size() != 2 ){
+      LogAlert << "Skipping 2D scan of " << GenericToolbox::parseVectorAsString(parNameList) << ": fit parameter not found." << std::endl;
+      continue;
+    }
+    if( _minimizer_->IsFixedVariable(iFitParList[0]) or _minimizer_->IsFixedVariable(iFitParList[1]) ){
+      LogAlert << "Skipping 2D scan of " << GenericToolbox::parseVectorAsString(parNameList) << ": fixed parameter." << std::endl;
+      continue;
+    }
+
+    this->scanParameterPair(iFitParList[0], iFitParList[1], pairConfig, saveDir_);
+  }
+}
+void FitterEngine::scanParameterPair(int iPar, int jPar, const nlohmann::json& pairConfig_, const std::string& saveDir_){
+  // The surface is defined on a fine grid of (nbPoints-1)*2^nbRefinements+1 nodes per axis. Only the coarse nodes are
+  // evaluated first, then each refinement level halves the stride inside the cells crossed by a requested level.
+  int nbCoarsePoints = std::max(2, JsonUtils::fetchValue(pairConfig_, "nbPoints", 11));
+  int nbRefinements = std::max(0, JsonUtils::fetchValue(pairConfig_, "nbRefinements", 3));
+  auto levelList = JsonUtils::fetchValue(pairConfig_, "deltaChi2Levels", std::vector<double>{2.30, 6.18, 11.83}); // 1, 2 and 3 sigma for 2 dof
+  bool isProfiled = JsonUtils::fetchValue(pairConfig_, "profile", false);
+  std::sort(levelList.begin(), levelList.end());
+
+  int stride = 1 << nbRefinements;
+  int nbNodes = (nbCoarsePoints - 1) * stride + 1;
+
+  std::vector<int> iFitParList{iPar, jPar};
+  std::vector<double> origValueList(2);
+  std::vector<std::pair<double, double>> boundList(2);
+  for( int iDim = 0 ; iDim < 2 ; iDim++ ){
+    auto& par = *_minimizerFitParameterPtr_[iFitParList[iDim]];
+    origValueList[iDim] = par.getParameterValue();
+    boundList[iDim].first = origValueList[iDim] + _scanConfig_.getParameterSigmaRange().first * par.getStdDevValue();
+    boundList[iDim].second = origValueList[iDim] + _scanConfig_.getParameterSigmaRange().second * par.getStdDevValue();
+    if( _scanConfig_.isUseParameterLimits() ){
+      boundList[iDim].first = std::max(boundList[iDim].first, par.getMinValue());
+      boundList[iDim].second = std::min(boundList[iDim].second, par.getMaxValue());
+    }
+  }
+  auto getNodeValue = [&](int iDim_, int iNode_){
+    return boundList[iDim_].first + double(iNode_) / (nbNodes - 1) * (boundList[iDim_].second - boundList[iDim_].first);
+  };
+
+  LogInfo << "2D scan of " << _minimizer_->VariableName(iPar) << " vs " << _minimizer_->VariableName(jPar)
+          << ( isProfiled ? " (profiled)" : "" ) << ": " << nbCoarsePoints << "x" << nbCoarsePoints << " coarse points, "
+          << nbRefinements << " refinement level(s)" << std::endl;
+
+  std::vector<double> nodeChi2List(nbNodes * nbNodes, std::nan(""));
+  auto isEvaluated = [&](int i_, int j_){ return not std::isnan(nodeChi2List[i_ * nbNodes + j_]); };
+
+  // Profiling needs the other parameters to be re-minimized: done serially with a minimizer of its own, so the state
+  // of the fit minimizer (minimum, covariance, status, call count) is left untouched for Hesse and MINOS
+  int nFitPars = int(_minimizer_->NDim());
+  std::vector<double> fitSpaceRefValueList;
+  std::unique_ptr<ROOT::Math::Minimizer> profileMinimizer;
+  ROOT::Math::Functor profileFunctor([this, nFitPars](const double* parArray_){
+    for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+      auto& par = *_minimizerFitParameterPtr_[iFitPar];
+      par.setParameterValue(_useNormalizedFitSpace_ ? FitParameterSet::toRealParValue(parArray_[iFitPar], par) : parArray_[iFitPar]);
+    }
+    this->updateChi2Cache();
+    return _chi2Buffer_;
+  }, nFitPars);
+  if( isProfiled ){
+    for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+      auto& par = *_minimizerFitParameterPtr_[iFitPar];
+      fitSpaceRefValueList.emplace_back(
+          _useNormalizedFitSpace_ ? FitParameterSet::toNormalizedParValue(par.getParameterValue(), par) : par.getParameterValue()
+      );
+    }
+
+    profileMinimizer = std::unique_ptr<ROOT::Math::Minimizer>(ROOT::Math::Factory::CreateMinimizer(_minimizerType_, _minimizerAlgo_));
+    LogThrowIf(profileMinimizer == nullptr, "Could not create minimizer: " << _minimizerType_ << "/" << _minimizerAlgo_)
+    profileMinimizer->SetStrategy(_minimizer_->Strategy());
+    profileMinimizer->SetTolerance(_minimizer_->Tolerance());
+    profileMinimizer->SetErrorDef(_minimizer_->ErrorDef());
+    profileMinimizer->SetMaxIterations(_minimizer_->MaxIterations());
+    profileMinimizer->SetMaxFunctionCalls(_minimizer_->MaxFunctionCalls());
+    profileMinimizer->SetPrintLevel(0);
+    profileMinimizer->SetFunction(profileFunctor);
+    for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+      ROOT::Math::ParameterSettings parSettings;
+      _minimizer_->GetVariableSettings(iFitPar, parSettings);
+      double stepSize = (_minimizer_->Errors() != nullptr and _minimizer_->Errors()[iFitPar] > 0 ? _minimizer_->Errors()[iFitPar] : parSettings.StepSize());
+      profileMinimizer->SetVariable(iFitPar, parSettings.Name(), fitSpaceRefValueList[iFitPar], stepSize);
+      if( parSettings.HasLowerLimit() ){ profileMinimizer->SetVariableLowerLimit(iFitPar, parSettings.LowerLimit()); }
+      if( parSettings.HasUpperLimit() ){ profileMinimizer->SetVariableUpperLimit(iFitPar, parSettings.UpperLimit()); }
+      if( parSettings.IsFixed() ){ profileMinimizer->FixVariable(iFitPar); }
+    }
+  }
+  std::vector<double> refValueList;
+  for( auto* parPtr : _minimizerFitParameterPtr_ ){ refValueList.emplace_back(parPtr->getParameterValue()); }
+
+  auto evaluateNodes = [&](const std::vector<std::pair<int, int>>& nodeList_){
+    if( nodeList_.empty() ) return;
+    if( isProfiled ){
+      for( const auto& node : nodeList_ ){
+        for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+          profileMinimizer->SetVariableValue(iFitPar, fitSpaceRefValueList[iFitPar]);
+        }
+        for( int iDim = 0 ; iDim < 2 ; iDim++ ){
+          auto& par = *_minimizerFitParameterPtr_[iFitParList[iDim]];
+          double value = getNodeValue(iDim, ( iDim == 0 ? node.first : node.second ));
+          profileMinimizer->SetVariableValue(iFitParList[iDim], _useNormalizedFitSpace_ ? FitParameterSet::toNormalizedParValue(value, par) : value);
+          profileMinimizer->FixVariable(iFitParList[iDim]);
+        }
+        profileMinimizer->Minimize();
+        nodeChi2List[node.first * nbNodes + node.second] = profileMinimizer->MinValue();
+        for( int iFitPar : iFitParList ){ profileMinimizer->ReleaseVariable(iFitPar); }
+      }
+    }
+    else if( _scanConfig_.isUseParallelScan() and not _propagator_.isUseResponseFunctions() ){
+      std::vector<std::vector<double>> pointList;
+      for( const auto& node : nodeList_ ){ pointList.push_back({getNodeValue(0, node.first), getNodeValue(1, node.second)}); }
+      this->evalPointsOnReplicas(iFitParList, pointList, [&](size_t iPt_, const ScanReplica& replica_){
+        nodeChi2List[nodeList_[iPt_].first * nbNodes + nodeList_[iPt_].second] = replica_.chi2;
+      });
+    }
+    else{
+      for( const auto& node : nodeList_ ){
+        _minimizerFitParameterPtr_[iPar]->setParameterValue(getNodeValue(0, node.first));
+        _minimizerFitParameterPtr_[jPar]->setParameterValue(getNodeValue(1, node.second));
+        this->updateChi2Cache();
+        nodeChi2List[node.first * nbNodes + node.second] = _chi2Buffer_;
+      }
+    }
+  };
+
+  this->updateChi2Cache();
+  double refChi2 = _chi2Buffer_;
+  auto getMinChi2 = [&](){
+    double minChi2 = refChi2;
+    for( double chi2 : nodeChi2List ){ if( not std::isnan(chi2) ){ minChi2 = std::min(minChi2, chi2); } }
+    return minChi2;
+  };
+
+  std::vector<std::pair<int, int>> nodeList;
+  for( int iNode = 0 ; iNode < nbNodes ; iNode += stride ){
+    for( int jNode = 0 ; jNode < nbNodes ; jNode += stride ){ nodeList.emplace_back(iNode, jNode); }
+  }
+  evaluateNodes(nodeList);
+
+  for( ; stride > 1 ; stride /= 2 ){
+    double minChi2 = getMinChi2();
+    int half = stride / 2;
+    nodeList.clear();
+    for( int iNode = 0 ; iNode + stride < nbNodes ; iNode += stride ){
+      for( int jNode = 0 ; jNode + stride < nbNodes ; jNode += stride ){
+        if( not isEvaluated(iNode, jNode) or not isEvaluated(iNode + stride, jNode)
+            or not isEvaluated(iNode, jNode + stride) or not isEvaluated(iNode + stride, jNode + stride) ) continue;
+
+        double lowChi2 = std::min({
+          nodeChi2List[iNode * nbNodes + jNode], nodeChi2List[(iNode + stride) * nbNodes + jNode],
+          nodeChi2List[iNode * nbNodes + jNode + stride], nodeChi2List[(iNode + stride) * nbNodes + jNode + stride]
+        }) - minChi2;
+        double highChi2 = std::max({
+          nodeChi2List[iNode * nbNodes + jNode], nodeChi2List[(iNode + stride) * nbNodes + jNode],
+          nodeChi2List[iNode * nbNodes + jNode + stride], nodeChi2List[(iNode + stride) * nbNodes + jNode + stride]
+        }) - minChi2;
+        if( std::none_of(levelList.begin(), levelList.end(), [&](double level_){ return lowChi2 <= level_ and level_ < highChi2; }) ) continue;
+
+        for( const auto& node : std::vector<std::pair<int, int>>{
+          {iNode + half, jNode}, {iNode, jNode + half}, {iNode + half, jNode + half}, {iNode + stride, jNode + half}, {iNode + half, jNode + stride}
+        } ){
+          if( isEvaluated(node.first, node.second) ) continue;
+          nodeChi2List[node.first * nbNodes + node.second] = -1; // reserved, overwritten below
+          nodeList.emplace_back(node);
+        }
+      }
+    }
+    evaluateNodes(nodeList);
+  }
+
+  // Back to the reference point
+  for( size_t iFitPar = 0 ; iFitPar < _minimizerFitParameterPtr_.size() ; iFitPar++ ){
+    _minimizerFitParameterPtr_[iFitPar]->setParameterValue(refValueList[iFitPar]);
+  }
+  this->updateChi2Cache();
+
+  size_t nbEvaluated = std::count_if(nodeChi2List.begin(), nodeChi2List.end(), [](double chi2_){ return not std::isnan(chi2_); });
+  LogInfo << "2D scan evaluated " << nbEvaluated << " points instead of " << nbNodes * nbNodes << " for the dense grid." << std::endl;
+
+  // Fill the surface: each cell is interpolated from its corners, finer cells override the coarser ones
+  double minChi2 = getMinChi2();
+  std::vector<double> surfaceList(nbNodes * nbNodes, std::nan(""));
+  for( stride = 1 << nbRefinements ; stride >= 1 ; stride /= 2 ){
+    for( int iNode = 0 ; iNode + stride < nbNodes ; iNode += stride ){
+      for( int jNode = 0 ; jNode + stride < nbNodes ; jNode += stride ){
+        if( not isEvaluated(iNode, jNode) or not isEvaluated(iNode + stride, jNode)
+            or not isEvaluated(iNode, jNode + stride) or not isEvaluated(iNode + stride, jNode + stride) ) continue;
+        for( int di = 0 ; di <= stride ; di++ ){
+          for( int dj = 0 ; dj <= stride ; dj++ ){
+            double u = double(di) / stride;
+            double v = double(dj) / stride;
+            surfaceList[(iNode + di) * nbNodes + jNode + dj] =
+                (1 - u) * (1 - v) * nodeChi2List[iNode * nbNodes + jNode]
+                + u * (1 - v) * nodeChi2List[(iNode + stride) * nbNodes + jNode]
+                + (1 - u) * v * nodeChi2List[iNode * nbNodes + jNode + stride]
+                + u * v * nodeChi2List[(iNode + stride) * nbNodes + jNode + stride]
+                - minChi2;
+          }
+        }
+      }
+    }
+  }
+
+  if( _saveDir_ == nullptr ) return;
+
+  std::string pairName = GenericToolbox::replaceSubstringInString(_minimizer_->VariableName(iPar), "/", "_")
+      + "_vs_" + GenericToolbox::replaceSubstringInString(_minimizer_->VariableName(jPar), "/", "_");
+  auto* outDir = GenericToolbox::mkdirTFile(_saveDir_, saveDir_ + "/" + pairName);
+
+  // node-centered bins
+  double halfStepX = 0.5 * (boundList[0].second - boundList[0].first) / (nbNodes - 1);
+  double halfStepY = 0.5 * (boundList[1].second - boundList[1].first) / (nbNodes - 1);
+  TH2D surfaceHist(
+      "deltaChi2", Form("#Delta#chi^{2}%s", ( isProfiled ? " (profiled)" : "" )),
+      nbNodes, boundList[0].first - halfStepX, boundList[0].second + halfStepX,
+      nbNodes, boundList[1].first - halfStepY, boundList[1].second + halfStepY
+  );
+  surfaceHist.SetDirectory(nullptr);
+  surfaceHist.GetXaxis()->SetTitle(_minimizer_->VariableName(iPar).c_str());
+  surfaceHist.GetYaxis()->SetTitle(_minimizer_->VariableName(jPar).c_str());
+  std::vector<double> evalXList, evalYList;
+  for( int iNode = 0 ; iNode < nbNodes ; iNode++ ){
+    for( int jNode = 0 ; jNode < nbNodes ; jNode++ ){
+      surfaceHist.SetBinContent(iNode + 1, jNode + 1, surfaceList[iNode * nbNodes + jNode]);
+      if( isEvaluated(iNode, jNode) ){
+        evalXList.emplace_back(getNodeValue(0, iNode));
+        evalYList.emplace_back(getNodeValue(1, jNode));
+      }
+    }
+  }
+  GenericToolbox::writeInTFile(outDir, &surfaceHist, "deltaChi2_TH2D");
+
+  TGraph evaluatedPoints(int(evalXList.size()), &evalXList[0], &evalYList[0]);
+  evaluatedPoints.SetTitle("Evaluated points");
+  evaluatedPoints.SetMarkerStyle(kFullDotMedium);
+  GenericToolbox::writeInTFile(outDir, &evaluatedPoints, "evaluatedPoints_TGraph");
+
+  // The contour lines are extracted by ROOT's contour algorithm
+  TCanvas contourCanvas("contourCanvas", "contourCanvas", 800, 800);
+  surfaceHist.SetContour(int(levelList.size()), &levelList[0]);
+  surfaceHist.Draw("CONT LIST");
+  contourCanvas.Update();
+  auto* contourList = dynamic_cast<TObjArray*>(gROOT->GetListOfSpecials()->FindObject("contours"));
+  if( contourList == nullptr ){
+    LogAlert << "Could not extract the contours of " << pairName << std::endl;
+    return;
+  }
+  for( int iLevel = 0 ; iLevel < contourList->GetSize() and iLevel < int(levelList.size()) ; iLevel++ ){
+    auto* graphList = dynamic_cast<TList*>(contourList->At(iLevel));
+    if( graphList == nullptr ) continue;
+    for( int iGraph = 0 ; iGraph < graphList->GetSize() ; iGraph++ ){
+      auto* graph = dynamic_cast<TGraph*>(graphList->At(iGraph));
+      if( graph == nullptr ) continue;
+      graph->SetTitle(Form("#Delta#chi^{2} = %g", levelList[iLevel]));
+      GenericToolbox::writeInTFile(outDir, graph, Form("contour_%g_%i_TGraph", levelList[iLevel], iGraph));
+    }
+  }
+}
+
+FitterEngine::ScanReplica FitterEngine::buildReferenceReplica(){
+  // Current state of the samples, the chi2 buffers are expected to be up to date
+  ScanReplica out;
+  bool isSumWeightsNeeded = JsonUtils::fetchValue(_scanConfig_.getVarsConfig(), "weightPerSample", false);
+  for( const auto& sample : _propagator_.getFitSampleSet().getFitSampleList() ){
+    const auto* hist = sample.getMcContainer().histogram.get();
+    out.mcBinContentList.emplace_back(hist->GetArray(), hist->GetArray() + hist->GetNbinsX() + 2);
+    out.mcBinSumw2List.emplace_back(hist->GetSumw2()->GetArray(), hist->GetSumw2()->GetArray() + hist->GetNbinsX() + 2);
+    out.llhStatPerSample.emplace_back(_propagator_.getFitSampleSet().evalLikelihood(sample));
+    out.sumWeightsPerSample.emplace_back( isSumWeightsNeeded ? sample.getMcContainer().getSumWeights() : 0 );
+    out.chi2Stat += out.llhStatPerSample.back();
+  }
+  out.isSampleModifiedList.resize(out.llhStatPerSample.size(), false);
+  out.chi2Pulls = _chi2PullsBuffer_;
+  out.chi2 = out.chi2Stat + out.chi2Pulls;
+  return out;
+}
+FitterEngine::ReplicaMove FitterEngine::buildReplicaMove(const std::vector<FitParameter*>& parList_, bool withPenalty_){
+  size_t nDims = parList_.size();
+  ReplicaMove out;
+
+  auto getParSet = [&](const FitParameter* par_) -> FitParameterSet& {
+    FitParameterSet* out{nullptr};
+    for( auto& parSet : _propagator_.getParameterSetsList() ){ if( &parSet == par_->getOwner() ){ out = &parSet; break; } }
+    LogThrowIf(out == nullptr, "Parameter set of " << par_->getTitle() << " not found.");
+    return *out;
+  };
+
+  // Shift of the original parameters per unit of each moved parameter (the eigen -> original swap is linear)
+  for( size_t iDim = 0 ; iDim < nDims ; iDim++ ){
+    auto& movedPar = *parList_[iDim];
+    auto& parSet = getParSet(parList_[iDim]);
+    if( not parSet.isUseEigenDecompInFit() ){
+      out.slopeList.emplace(&movedPar, std::vector<double>(nDims, 0)).first->second[iDim] = 1.;
+      continue;
+    }
+    double currentValue = movedPar.getParameterValue();
+    std::vector<double> refValueList;
+    for( auto& par : parSet.getParameterList() ){ refValueList.emplace_back(par.getParameterValue()); }
+    movedPar.setParameterValue(currentValue + 1.);
+    parSet.propagateEigenToOriginal();
+    for( size_t iOrigPar = 0 ; iOrigPar < refValueList.size() ; iOrigPar++ ){
+      auto& par = parSet.getParameterList()[iOrigPar];
+      if( par.getParameterValue() == refValueList[iOrigPar] ) continue;
+      out.slopeList.emplace(&par, std::vector<double>(nDims, 0)).first->second[iDim] = par.getParameterValue() - refValueList[iOrigPar];
+    }
+    movedPar.setParameterValue(currentValue);
+    parSet.propagateEigenToOriginal();
+  }
+
+  // Events to look at: {iSample, iEvent}
+  bool isEventMapOwned = _scanParameterEventMap_.empty();
+  if( isEventMapOwned ){ _scanParameterEventMap_ = _propagator_.buildParameterEventMap(); }
+  for( const auto& slope : out.slopeList ){
+    auto parEventListIt = _scanParameterEventMap_.find(slope.first);
+    if( parEventListIt == _scanParameterEventMap_.end() ) continue;
+    out.eventList.insert(out.eventList.end(), parEventListIt->second.begin(), parEventListIt->second.end());
+  }
+  if( isEventMapOwned ){ _scanParameterEventMap_.clear(); }
+  if( out.slopeList.size() > 1 ){
+    std::sort(out.eventList.begin(), out.eventList.end());
+    out.eventList.erase(std::unique(out.eventList.begin(), out.eventList.end()), out.eventList.end());
+  }
+  out.isSampleAffectedList.resize(_propagator_.getFitSampleSet().getFitSampleList().size(), false);
+  for( const auto& eventIndex : out.eventList ){ out.isSampleAffectedList[eventIndex.first] = true; }
+
+  // The penalty is quadratic: P(x0 + t) = P(x0) + t.g + t.H.t/2 (no cross terms between different sets)
+  out.penaltyGradient.resize(nDims, 0);
+  out.penaltyHessian.resize(nDims, std::vector<double>(nDims, 0));
+  if( not withPenalty_ ) return out;
+  for( size_t iDim = 0 ; iDim < nDims ; iDim++ ){
+    auto& parSet = getParSet(parList_[iDim]);
+    TMatrixD parSetPenaltyHessian = parSet.getPenaltyHessian();
+    const auto& effParList = parSet.getEffectiveParameterList();
+    int kPar = int(parList_[iDim] - &effParList[0]);
+    for( int jPar = 0 ; jPar < int(effParList.size()) ; jPar++ ){
+      if( parSetPenaltyHessian[kPar][jPar] == 0 ) continue;
+      out.penaltyGradient[iDim] += parSetPenaltyHessian[kPar][jPar] * (effParList[jPar].getParameterValue() - effParList[jPar].getPriorValue());
+    }
+    for( size_t jDim = 0 ; jDim < nDims ; jDim++ ){
+      if( parList_[jDim]->getOwner() != &parSet ) continue;
+      out.penaltyHessian[iDim][jDim] = parSetPenaltyHessian[kPar][int(parList_[jDim] - &effParList[0])];
+    }
+  }
+  return out;
+}
+void FitterEngine::evalReplicaMove(const ReplicaMove& move_, const std::vector<double>& shiftList_,
+                                   const ScanReplica& reference_, ScanReplica& replica_){
+  // Only reads the events and dials: can be called concurrently on different replicas
+  const auto& sampleList = _propagator_.getFitSampleSet().getFitSampleList();
+  const auto& jointProbability = _propagator_.getFitSampleSet().getJointProbabilityFct();
+  size_t nSamples = sampleList.size();
+  size_t nDims = shiftList_.size();
+
+  // back to the reference for the samples touched by this move or by the previous one
+  for( size_t iSample = 0 ; iSample < nSamples ; iSample++ ){
+    if( not move_.isSampleAffectedList[iSample] and not replica_.isSampleModifiedList[iSample] ) continue;
+    replica_.mcBinContentList[iSample] = reference_.mcBinContentList[iSample];
+    replica_.mcBinSumw2List[iSample] = reference_.mcBinSumw2List[iSample];
+    replica_.sumWeightsPerSample[iSample] = reference_.sumWeightsPerSample[iSample];
+    replica_.isSampleModifiedList[iSample] = move_.isSampleAffectedList[iSample];
+  }
+
+  for( const auto& eventIndex : move_.eventList ){
+    const auto& event = sampleList[eventIndex.first].getMcContainer().eventList[eventIndex.second];
+
+    // same as PhysicsEvent::reweightUsingDialCache, with the moved parameters evaluated out of the dial cache
+    double refWeight = event.getTreeWeight();
+    double newWeight = event.getTreeWeight();
+    for( auto* dialPtr : event.getRawDialPtrList() ){
+      if( dialPtr == nullptr ) break;
+      if( Dial::enableMaskCheck and dialPtr->isMasked() ){ continue; }
+      double response = dialPtr->evalResponse();
+      refWeight *= response;
+      auto slopeIt = move_.slopeList.find(dialPtr->getOwner()->getOwner());
+      if( slopeIt == move_.slopeList.end() ){ newWeight *= response; continue; }
+      double parValue = slopeIt->first->getParameterValue();
+      for( size_t iDim = 0 ; iDim < nDims ; iDim++ ){ parValue += slopeIt->second[iDim] * shiftList_[iDim]; }
+      newWeight *= dialPtr->calcResponse(parValue);
+    }
+
+    double deltaWeight = newWeight - refWeight;
+    if( deltaWeight == 0 ) continue;
+
+    replica_.sumWeightsPerSample[eventIndex.first] += deltaWeight;
+    if( event.getSampleBinIndex() < 0 ) continue;
+    double histScale = sampleList[eventIndex.first].getMcContainer().histScale;
+    replica_.mcBinContentList[eventIndex.first][event.getSampleBinIndex() + 1] += deltaWeight * histScale;
+    replica_.mcBinSumw2List[eventIndex.first][event.getSampleBinIndex() + 1] += deltaWeight * histScale * histScale;
+  }
+
+  replica_.chi2Stat = 0;
+  for( size_t iSample = 0 ; iSample < nSamples ; iSample++ ){
+    if( move_.isSampleAffectedList[iSample] ){
+      replica_.llhStatPerSample[iSample] = jointProbability->eval(
+          replica_.mcBinContentList[iSample].data() + 1, replica_.mcBinSumw2List[iSample].data() + 1,
+          sampleList[iSample].getDataContainer().histogram->GetArray() + 1, replica_.mcBinContentList[iSample].size() - 2
+      );
+    }
+    else{
+      replica_.llhStatPerSample[iSample] = reference_.llhStatPerSample[iSample];
+    }
+    replica_.chi2Stat += replica_.llhStatPerSample[iSample];
+  }
+
+  replica_.chi2Pulls = reference_.chi2Pulls;
+  for( size_t iDim = 0 ; iDim < nDims ; iDim++ ){
+    replica_.chi2Pulls += shiftList_[iDim] * move_.penaltyGradient[iDim];
+    for( size_t jDim = 0 ; jDim < nDims ; jDim++ ){ replica_.chi2Pulls += 0.5 * shiftList_[iDim] * move_.penaltyHessian[iDim][jDim] * shiftList_[jDim]; }
+  }
+  replica_.chi2 = replica_.chi2Stat + replica_.chi2Pulls;
+}
+void FitterEngine::evalPointsOnReplicas(const std::vector<int>& iFitParList_, const std::vector<std::vector<double>>& pointList_,
+                                        const std::function<void(size_t, const ScanReplica&)>& processPointFct_){
+  // Each thread evaluates its own points starting from the current state. Only the events reweighted by the
+  // moved parameters are looked at, and their weight shifts are added to a private copy of the sample bins.
+  size_t nDims = iFitParList_.size();
+
+  this->updateChi2Cache();
+  std::vector<FitParameter*> parList;
+  for( int iFitPar : iFitParList_ ){ parList.emplace_back(_minimizerFitParameterPtr_[iFitPar]); }
+  ReplicaMove move = this->buildReplicaMove(parList);
+  ScanReplica reference = this->buildReferenceReplica();
+
+  int nThreads = GlobalVariables::getNbThreads();
+  if( int(_scanReplicaList_.size()) < nThreads ){ _scanReplicaList_.resize(nThreads); }
+
+  std::function<void(int)> evalPointsFct = [&](int iThread_){
+    int nJobThreads = nThreads;
+    if( iThread_ == -1 ){ iThread_ = 0; nJobThreads = 1; }
+
+    auto& replica = _scanReplicaList_[iThread_];
+    replica = reference;
+    std::vector<double> shiftList(nDims, 0);
+
+    for( size_t iPt = iThread_ ; iPt < pointList_.size() ; iPt += nJobThreads ){
+      for( size_t iDim = 0 ; iDim < nDims ; iDim++ ){ shiftList[iDim] = pointList_[iPt][iDim] - parList[iDim]->getParameterValue(); }
+      this->evalReplicaMove(move, shiftList, reference, replica);
+      processPointFct_(iPt, replica);
+    }
+  };
+
+  GlobalVariables::getParallelWorker().addJob(__METHOD_NAME__, evalPointsFct);
+  GlobalVariables::getParallelWorker().runJob(__METHOD_NAME__);
+  GlobalVariables::getParallelWorker().removeJob(__METHOD_NAME__);
+}
+
+void FitterEngine::evalMinosErrorsOnReplicas(std::vector<double>& errLowList_, std::vector<double>& errHighList_,
+                                             std::vector<int>& minosStatusList_, std::vector<char>& isMinosOkList_){
+  // One minimizer per thread, each evaluating the chi2 on its own replica of the sample bins. The events and dials are
+  // shared and only read. Every minimizer first re-establishes the minimum (starting from it) before running MINOS.
+  LogInfo << __METHOD_NAME__ << std::endl;
+  int nFitPars = int(_minimizer_->NDim());
+  int nThreads = GlobalVariables::getNbThreads();
+
+  // Reference: the minimum
+  for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+    auto& par = *_minimizerFitParameterPtr_[iFitPar];
+    if( _useNormalizedFitSpace_ ){ par.setParameterValue(FitParameterSet::toRealParValue(_minimizer_->X()[iFitPar], par)); }
+    else{ par.setParameterValue(_minimizer_->X()[iFitPar]); }
+  }
+  this->updateChi2Cache();
+  ReplicaMove move = this->buildReplicaMove(_minimizerFitParameterPtr_);
+  ScanReplica reference = this->buildReferenceReplica();
+  if( int(_scanReplicaList_.size()) < nThreads ){ _scanReplicaList_.resize(nThreads); }
+
+  std::vector<ROOT::Math::ParameterSettings> parSettingsList(nFitPars);
+  for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){ _minimizer_->GetVariableSettings(iFitPar, parSettingsList[iFitPar]); }
+
+  // Minuit2Minimizer::Errors() fills a mutable buffer: not from the threads
+  std::vector<double> stepSizeList(nFitPars);
+  const double* fitErrorList = _minimizer_->Errors();
+  for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+    stepSizeList[iFitPar] = (fitErrorList != nullptr and fitErrorList[iFitPar] > 0 ? fitErrorList[iFitPar] : parSettingsList[iFitPar].StepSize());
+  }
+
+  // Error matrix of the minimum over the free parameters, packed lower triangle (element (i, j<=i) at i*(i+1)/2 + j):
+  // seeded in every thread so Migrad only has to confirm the minimum
+  std::vector<int> freeParIndexList;
+  for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){ if( not parSettingsList[iFitPar].IsFixed() ){ freeParIndexList.emplace_back(iFitPar); } }
+  std::vector<double> fitCovList;
+  if( _minimizer_->CovMatrixStatus() > 0 ){
+    fitCovList.reserve(freeParIndexList.size() * (freeParIndexList.size() + 1) / 2);
+    for( size_t iFree = 0 ; iFree < freeParIndexList.size() ; iFree++ ){
+      for( size_t jFree = 0 ; jFree <= iFree ; jFree++ ){
+        fitCovList.emplace_back(_minimizer_->CovMatrix(freeParIndexList[iFree], freeParIndexList[jFree]));
+      }
+    }
+  }
+
+  // The factory goes through the plugin manager: not from the threads
+  std::vector<std::unique_ptr<ROOT::Math::Minimizer>> minimizerList(nThreads);
+  for( auto& minimizer : minimizerList ){
+    minimizer = std::unique_ptr<ROOT::Math::Minimizer>(ROOT::Math::Factory::CreateMinimizer(_minimizerType_, _minimizerAlgo_));
+    LogThrowIf(minimizer == nullptr, "Could not create minimizer: " << _minimizerType_ << "/" << _minimizerAlgo_)
+    minimizer->SetStrategy(_minimizer_->Strategy());
+    minimizer->SetTolerance(_minimizer_->Tolerance());
+    minimizer->SetErrorDef(_minimizer_->ErrorDef());
+    minimizer->SetMaxIterations(_minimizer_->MaxIterations());
+    minimizer->SetMaxFunctionCalls(_minimizer_->MaxFunctionCalls());
+    minimizer->SetPrintLevel(0);
+  }
+
+  int nbDone{0};
+  std::function<void(int)> minosFct = [&](int iThread_){
+    int nJobThreads = nThreads;
+    if( iThread_ == -1 ){ iThread_ = 0; nJobThreads = 1; }
+
+    auto& replica = _scanReplicaList_[iThread_];
+    replica = reference;
+    std::vector<double> shiftList(nFitPars, 0);
+
+    ROOT::Math::Functor functor([&](const double* parArray_){
+      for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+        auto& par = *_minimizerFitParameterPtr_[iFitPar];
+        double parValue = (_useNormalizedFitSpace_ ? FitParameterSet::toRealParValue(parArray_[iFitPar], par) : parArray_[iFitPar]);
+        shiftList[iFitPar] = parValue - par.getParameterValue();
+      }
+      this->evalReplicaMove(move, shiftList, reference, replica);
+      return replica.chi2;
+    }, nFitPars);
+
+    auto& minimizer = minimizerList[iThread_];
+    minimizer->SetFunction(functor);
+    for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+      const auto& parSettings = parSettingsList[iFitPar];
+      minimizer->SetVariable(iFitPar, parSettings.Name(), parSettings.Value(), stepSizeList[iFitPar]);
+      if( parSettings.HasLowerLimit() ){ minimizer->SetVariableLowerLimit(iFitPar, parSettings.LowerLimit()); }
+      if( parSettings.HasUpperLimit() ){ minimizer->SetVariableUpperLimit(iFitPar, parSettings.UpperLimit()); }
+      if( parSettings.IsFixed() ){ minimizer->FixVariable(iFitPar); }
+    }
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,24,0)
+    if( not fitCovList.empty() ){ minimizer->SetCovariance(fitCovList, freeParIndexList.size()); }
+#endif
+    minimizer->Minimize();
+
+    for( int iFitPar = iThread_ ; iFitPar < nFitPars ; iFitPar += nJobThreads ){
+      isMinosOkList_[iFitPar] = minimizer->GetMinosError(iFitPar, errLowList_[iFitPar], errHighList_[iFitPar]);
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,23,02)
+      minosStatusList_[iFitPar] = minimizer->MinosStatus();
+#endif
+      std::lock_guard<std::mutex> guard(GlobalVariables::getThreadMutex());
+      LogInfo << "MINOS " << ++nbDone << "/" << nFitPars << ": " << minimizer->VariableName(iFitPar) << " done." << std::endl;
+    }
+  };
+
+  GlobalVariables::getParallelWorker().addJob(__METHOD_NAME__, minosFct);
+  GlobalVariables::getParallelWorker().runJob(__METHOD_NAME__);
+  GlobalVariables::getParallelWorker().removeJob(__METHOD_NAME__);
+}
+
 void FitterEngine::fit(){
   LogWarning << __METHOD_NAME__ << std::endl;
 
@@ -636,19 +1443,36 @@ void FitterEngine::fit(){
           << "Chi2 # DoF : " << _nbFitBins_ - _minimizer_->NFree()
           << std::endl;
 
+  std::string checkpointStage;
+  if( not _resumeCheckpointFilePath_.empty() ){ checkpointStage = this->loadCheckpoint(); }
+
+  if( checkpointStage == "minimized" ){
+    // Minuit has no state to restore: a Migrad started at the minimum converges in a few calls and provides the
+    // function minimum needed by the post-fit output, Hesse and MINOS
+    LogWarning << "The minimization was over in the checkpoint: re-establishing the minimum from the restored point." << std::endl;
+  }
+
   int nbFitCallOffset = _nbFitCalls_;
   LogInfo << "Fit call offset: " << nbFitCallOffset << std::endl;
+  _lastCheckpointTime_ = std::chrono::steady_clock::now();
+  _checkpointBestChi2_ = std::nan("unset");
   _enableFitMonitor_ = true;
+  _isMinimizing_ = true;
+  int nbCacheHitsOffset = _nbChi2CacheHits_;
   _fitHasConverged_ = _minimizer_->Minimize();
+  _isMinimizing_ = false;
   _enableFitMonitor_ = false;
   int nbMinimizeCalls = _nbFitCalls_ - nbFitCallOffset;
+  if( _isPropagatorStale_ ){ updateChi2Cache(); } // the samples have to match the last point
 
   LogInfo << _convergenceMonitor_.generateMonitorString(); // lasting printout
-  LogInfo << "Minimization ended after " << nbMinimizeCalls << " calls." << std::endl;
+  LogInfo << "Minimization ended after " << nbMinimizeCalls << " calls (" << _nbChi2CacheHits_ - nbCacheHitsOffset << " cached)." << std::endl;
   if(_minimizerAlgo_ == "Migrad") LogWarning << "Status code: " << minuitStatusCodeStr.at(_minimizer_->Status()) << std::endl;
   else LogWarning << "Status code: " << _minimizer_->Status() << std::endl;
   if(_minimizerAlgo_ == "Migrad") LogWarning << "Covariance matrix status code: " << covMatrixStatusCodeStr.at(_minimizer_->CovMatrixStatus()) << std::endl;
   else LogWarning << "Covariance matrix status code: " << _minimizer_->CovMatrixStatus() << std::endl;
+
+  this->writeCheckpoint("minimized");
   if( _saveDir_ != nullptr ){
     GenericToolbox::mkdirTFile(_saveDir_, "fit")->cd();
     _chi2HistoryTree_->Write();
@@ -680,27 +1504,50 @@ void FitterEngine::fit(){
       if     ( errorAlgo == "Minos" ){
         LogWarning << std::endl << GenericToolbox::addUpDownBars("Calling MINOS...") << std::endl;
 
-        double errLow, errHigh;
         _minimizer_->SetPrintLevel(0);
 
-        for( int iFitPar = 0 ; iFitPar < _minimizer_->NDim() ; iFitPar++ ){
-          LogInfo << "Evaluating: " << _minimizer_->VariableName(iFitPar) << "..." << std::endl;
-          bool isOk = _minimizer_->GetMinosError(iFitPar, errLow, errHigh);
+        int nFitPars = int(_minimizer_->NDim());
+        std::vector<double> errLowList(nFitPars, 0);
+        std::vector<double> errHighList(nFitPars, 0);
+        std::vector<int> minosStatusList(nFitPars, -1);
+        std::vector<char> isMinosOkList(nFitPars, false);
+
+        bool useParallelMinos =
+            JsonUtils::fetchValue(_minimizerConfig_, "useParallelMinos", true)
+            and GlobalVariables::getNbThreads() > 1
+            and not _propagator_.isUseResponseFunctions();
+
+        if( useParallelMinos ){
+          this->evalMinosErrorsOnReplicas(errLowList, errHighList, minosStatusList, isMinosOkList);
+        }
+        else{
+          for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+            LogInfo << "Evaluating: " << _minimizer_->VariableName(iFitPar) << "..." << std::endl;
+            isMinosOkList[iFitPar] = _minimizer_->GetMinosError(iFitPar, errLowList[iFitPar], errHighList[iFitPar]);
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,23,02)
+            minosStatusList[iFitPar] = _minimizer_->MinosStatus();
+#endif
+          }
+        }
+
+        for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
 #if ROOT_VERSION_CODE >= ROOT_VERSION(6,23,02)
-          LogWarning << minosStatusCodeStr.at(_minimizer_->MinosStatus()) << std::endl;
+          LogWarning << _minimizer_->VariableName(iFitPar) << ": " << minosStatusCodeStr.at(minosStatusList[iFitPar]) << std::endl;
 #endif
-          if( isOk ){
-            LogInfo << _minimizer_->VariableName(iFitPar) << ": " << errLow << " <- " << _minimizer_->X()[iFitPar] << " -> +" << errHigh << std::endl;
+          if( isMinosOkList[iFitPar] ){
+            LogInfo << _minimizer_->VariableName(iFitPar) << ": " << errLowList[iFitPar] << " <- " << _minimizer_->X()[iFitPar] << " -> +" << errHighList[iFitPar] << std::endl;
           }
           else{
-            LogError << _minimizer_->VariableName(iFitPar) << ": " << errLow << " <- " << _minimizer_->X()[iFitPar] << " -> +" << errHigh
+            LogError << _minimizer_->VariableName(iFitPar) << ": " << errLowList[iFitPar] << " <- " << _minimizer_->X()[iFitPar] << " -> +" << errHighList[iFitPar]
                      << " - MINOS returned an error." << std::endl;
           }
         }
 
         // Put back at minimum
         for( int iFitPar = 0 ; iFitPar < _minimizer_->NDim() ; iFitPar++ ){
-          _minimizerFitParameterPtr_[iFitPar]->setParameterValue(_minimizer_->X()[iFitPar]);
+          auto& par = *_minimizerFitParameterPtr_[iFitPar];
+          if( _useNormalizedFitSpace_ ){ par.setParameterValue(FitParameterSet::toRealParValue(_minimizer_->X()[iFitPar], par)); }
+          else{ par.setParameterValue(_minimizer_->X()[iFitPar]); }
         }
 
         updateChi2Cache();
@@ -724,11 +1571,13 @@ void FitterEngine::fit(){
                 << "Chi2 # DoF : " << _nbFitBins_ - _minimizer_->NFree()
                 << std::endl;
 
-        nbFitCallOffset = _nbFitCalls_;
+        int nbFitCallOffset = _nbFitCalls_;
+        int nbCacheHitsOffset = _nbChi2CacheHits_;
         LogInfo << "Fit call offset: " << nbFitCallOffset << std::endl;
 
         _fitHasConverged_ = _minimizer_->Hesse();
-        LogInfo << "Hesse ended after " << _nbFitCalls_ - nbFitCallOffset << " calls." << std::endl;
+        if( _isPropagatorStale_ ){ updateChi2Cache(); }
+        LogInfo << "Hesse ended after " << _nbFitCalls_ - nbFitCallOffset << " calls (" << _nbChi2CacheHits_ - nbCacheHitsOffset << " cached)." << std::endl;
         LogWarning << "HESSE status code: " << hesseStatusCodeStr.at(_minimizer_->Status()) << std::endl;
         LogWarning << "Covariance matrix status code: " << covMatrixStatusCodeStr.at(_minimizer_->CovMatrixStatus()) << std::endl;
 
@@ -746,6 +1595,25 @@ void FitterEngine::fit(){
         LogInfo << "Writing HESSE post-fit errors" << std::endl;
         this->writePostFitData(GenericToolbox::mkdirTFile(_saveDir_, "postFit/Hesse"));
       }
+      else if( errorAlgo == "AnalyticHessian" ){
+        LogWarning << std::endl << GenericToolbox::addUpDownBars("Building the Gauss-Newton Hessian...") << std::endl;
+        TMatrixDSym analyticCovMatrix = this->evalAnalyticCovarianceMatrix();
+
+        LogInfo << "Writing AnalyticHessian post-fit errors" << std::endl;
+        auto* analyticDir = GenericToolbox::mkdirTFile(_saveDir_, "postFit/AnalyticHessian");
+        this->writePostFitData(analyticDir, &analyticCovMatrix);
+
+        int maxNbParsForHesseComparison = JsonUtils::fetchValue(_minimizerConfig_, "analyticHessianMaxNbParsForHesseComparison", 50);
+        if( JsonUtils::fetchValue(_minimizerConfig_, "analyticHessianCompareWithHesse", false) ){
+          if( int(_minimizer_->NFree()) <= maxNbParsForHesseComparison ){
+            this->compareAnalyticCovarianceWithHesse(analyticCovMatrix, GenericToolbox::mkdirTFile(analyticDir, "hesseComparison"));
+          }
+          else{
+            LogAlert << "Skipping the comparison with HESSE: " << _minimizer_->NFree() << " free parameters > "
+                     << GET_VAR_NAME_VALUE(maxNbParsForHesseComparison) << std::endl;
+          }
+        }
+      }
       else{
         LogError << GET_VAR_NAME_VALUE(errorAlgo) << " not implemented." << std::endl;
       }
@@ -773,15 +1641,18 @@ void FitterEngine::updateChi2Cache(){
   ////////////////////////////////
   // Compute the penalty terms
   ////////////////////////////////
+  GenericToolbox::getElapsedTimeSinceLastCallInMicroSeconds("penaltyEval");
   _chi2PullsBuffer_ = 0;
   _chi2RegBuffer_ = 0;
   for( auto& parSet : _propagator_.getParameterSetsList() ){
     buffer = parSet.getPenaltyChi2();
     _chi2PullsBuffer_ += buffer;
   }
+  _penaltyEvalTimer_.counts++; _penaltyEvalTimer_.cumulated += GenericToolbox::getElapsedTimeSinceLastCallInMicroSeconds("penaltyEval");
 
   _chi2Buffer_ = _chi2StatBuffer_ + _chi2PullsBuffer_ + _chi2RegBuffer_;
 
+  _isPropagatorStale_ = false;
 }
 double FitterEngine::evalFit(const double* parArray_){
   GenericToolbox::getElapsedTimeSinceLastCallInMicroSeconds(__METHOD_NAME__);
@@ -798,8 +1669,35 @@ double FitterEngine::evalFit(const double* parArray_){
     else par->setParameterValue(parArray_[iFitPar++]);
   }
 
-  // Compute the Chi2
-  updateChi2Cache();
+  // Compute the Chi2: Hesse, Minos and the line searches come back on identical points
+  bool isChi2CacheHit{false};
+  for( auto itEntry = _chi2CacheList_.begin() ; itEntry != _chi2CacheList_.end() ; ++itEntry ){
+    if( std::memcmp(&itEntry->fitPoint[0], parArray_, itEntry->fitPoint.size() * sizeof(double)) != 0 ){ continue; }
+    _chi2CacheList_.splice(_chi2CacheList_.begin(), _chi2CacheList_, itEntry);
+    _chi2Buffer_ = itEntry->chi2;
+    _chi2StatBuffer_ = itEntry->chi2Stat;
+    _chi2PullsBuffer_ = itEntry->chi2Pulls;
+    _chi2RegBuffer_ = itEntry->chi2Reg;
+    _nbChi2CacheHits_++;
+    _isPropagatorStale_ = true;
+    isChi2CacheHit = true;
+    break;
+  }
+
+  if( not isChi2CacheHit ){
+    updateChi2Cache();
+
+    if( _chi2CacheSize_ != 0 ){
+      if( _chi2CacheList_.size() < _chi2CacheSize_ ){ _chi2CacheList_.emplace_front(); }
+      else{ _chi2CacheList_.splice(_chi2CacheList_.begin(), _chi2CacheList_, std::prev(_chi2CacheList_.end())); } // recycle the oldest
+      auto& entry = _chi2CacheList_.front();
+      entry.fitPoint.assign(parArray_, parArray_ + _nbFitParameters_);
+      entry.chi2 = _chi2Buffer_;
+      entry.chi2Stat = _chi2StatBuffer_;
+      entry.chi2Pulls = _chi2PullsBuffer_;
+      entry.chi2Reg = _chi2RegBuffer_;
+    }
+  }
 
   _evalFitAvgTimer_.counts++; _evalFitAvgTimer_.cumulated += GenericToolbox::getElapsedTimeSinceLastCallInMicroSeconds(__METHOD_NAME__);
 
@@ -821,6 +1719,9 @@ double FitterEngine::evalFit(const double* parArray_){
     ss << std::endl << "Current CPU usage: " << cpuPercent << "% (" << cpuPercent/GlobalVariables::getNbThreads() << "% efficiency)";
     ss << std::endl << "Avg " << GUNDAM_CHI2 << " computation time: " << _evalFitAvgTimer_;
     ss << std::endl << GUNDAM_CHI2 << "/dof: " << _chi2Buffer_/double(_nbFitBins_ - _minimizer_->NFree());
+    if( _chi2CacheSize_ != 0 ){
+      ss << std::endl << "Cached " << GUNDAM_CHI2 << " hits: " << _nbChi2CacheHits_ << " (" << 100.*double(_nbChi2CacheHits_)/double(_nbFitCalls_) << "% of the calls)";
+    }
     if( not _propagator_.isUseResponseFunctions() ){
       ss << std::endl;
 #ifndef GUNDAM_BATCH
@@ -842,6 +1743,11 @@ double FitterEngine::evalFit(const double* parArray_){
       ss << "├─";
 #endif
       ss << " Avg time to fill histograms:   " << _propagator_.fillProp;
+      ss << std::endl;
+#ifndef GUNDAM_BATCH
+      ss << "├─";
+#endif
+      ss << " Avg time to eval penalties:    " << _penaltyEvalTimer_;
     }
     else{
       ss << GET_VAR_NAME_VALUE(_propagator_.applyRf);
@@ -864,6 +1770,17 @@ double FitterEngine::evalFit(const double* parArray_){
 
   // Fill History
   _chi2HistoryTree_->Fill();
+
+  // Checkpoint: Migrad restarts from the best point seen so far
+  if( _isMinimizing_ and not _checkpointFilePath_.empty() ){
+    if( not (_checkpointBestChi2_ <= _chi2Buffer_) ){
+      _checkpointBestChi2_ = _chi2Buffer_;
+      _checkpointBestPoint_.assign(parArray_, parArray_ + _minimizer_->NDim());
+    }
+    if( std::chrono::duration<double>(std::chrono::steady_clock::now() - _lastCheckpointTime_).count() >= _checkpointIntervalInSeconds_ ){
+      this->writeCheckpoint("minimize");
+    }
+  }
 //  _chi2History_["Total"].emplace_back(_chi2Buffer_);
 //  _chi2History_["Stat"].emplace_back(_chi2StatBuffer_);
 //  _chi2History_["Syst"].emplace_back(_chi2PullsBuffer_);
@@ -872,7 +1789,286 @@ double FitterEngine::evalFit(const double* parArray_){
   return _chi2Buffer_;
 }
 
-void FitterEngine::writePostFitData(TDirectory* saveDir_) {
+void FitterEngine::writeCheckpoint(const std::string& stage_){
+  if( _checkpointFilePath_.empty() ) return;
+  _lastCheckpointTime_ = std::chrono::steady_clock::now();
+
+  // written aside then renamed: a job killed while writing leaves the previous checkpoint intact
+  std::string tempFilePath = _checkpointFilePath_ + ".tmp" + std::to_string(gSystem->GetPid());
+  std::unique_ptr<TFile> checkpointFile( TFile::Open(tempFilePath.c_str(), "RECREATE") );
+  if( checkpointFile == nullptr or checkpointFile->IsZombie() ){
+    LogAlert << "Could not write checkpoint: " << tempFilePath << std::endl;
+    return;
+  }
+  checkpointFile->cd();
+
+  TNamed("stage", stage_.c_str()).Write();
+  TParameter<int>("nbFitCalls", _nbFitCalls_).Write();
+  TParameter<int>("fitHasConverged", _fitHasConverged_).Write();
+  if( _useEventCacheFingerprint_ ){ TNamed("eventCacheFingerprint", this->evalEventCacheFingerprint().c_str()).Write(); }
+
+  // Fit space point, matched by name on resume. The errors hold the minimizer step sizes.
+  int nFitPars = int(_minimizer_->NDim());
+  TH1D fitPoint("fitPoint", "Fit space point", nFitPars, 0, nFitPars);
+  fitPoint.SetDirectory(nullptr);
+  ROOT::Math::ParameterSettings parSettings;
+  for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+    _minimizer_->GetVariableSettings(iFitPar, parSettings);
+    double value = parSettings.Value();
+    if( stage_ == "minimized" ){ value = _minimizer_->X()[iFitPar]; }
+    else if( not _checkpointBestPoint_.empty() ){ value = _checkpointBestPoint_[iFitPar]; }
+    fitPoint.GetXaxis()->SetBinLabel(iFitPar + 1, _minimizer_->VariableName(iFitPar).c_str());
+    fitPoint.SetBinContent(iFitPar + 1, value);
+    fitPoint.SetBinError(iFitPar + 1, parSettings.StepSize());
+  }
+  fitPoint.Write();
+
+  if( _chi2HistoryTree_ != nullptr ){ _chi2HistoryTree_->CloneTree(-1)->Write(); }
+
+  checkpointFile->Close();
+  if( std::rename(tempFilePath.c_str(), _checkpointFilePath_.c_str()) != 0 ){
+    LogAlert << "Could not move checkpoint to: " << _checkpointFilePath_ << std::endl;
+    std::remove(tempFilePath.c_str());
+    return;
+  }
+  LogDebug << "Checkpoint (" << stage_ << ") written after " << _nbFitCalls_ << " calls: " << _checkpointFilePath_ << std::endl;
+}
+std::string FitterEngine::loadCheckpoint(){
+  if( gSystem->AccessPathName(_resumeCheckpointFilePath_.c_str()) ){ // true if it can't be accessed
+    LogAlert << "No checkpoint found at " << _resumeCheckpointFilePath_ << ": starting the fit from scratch." << std::endl;
+    return "";
+  }
+  LogWarning << "Resuming from checkpoint: " << _resumeCheckpointFilePath_ << std::endl;
+
+  std::unique_ptr<TFile> checkpointFile( TFile::Open(_resumeCheckpointFilePath_.c_str(), "READ") );
+  LogThrowIf(checkpointFile == nullptr or checkpointFile->IsZombie(), "Could not open checkpoint: " << _resumeCheckpointFilePath_);
+
+  auto* stage = dynamic_cast<TNamed*>(checkpointFile->Get("stage"));
+  auto* nbFitCalls = dynamic_cast<TParameter<int>*>(checkpointFile->Get("nbFitCalls"));
+  auto* fitHasConverged = dynamic_cast<TParameter<int>*>(checkpointFile->Get("fitHasConverged"));
+  auto* fitPoint = dynamic_cast<TH1D*>(checkpointFile->Get("fitPoint"));
+  LogThrowIf(stage == nullptr or nbFitCalls == nullptr or fitHasConverged == nullptr or fitPoint == nullptr, "Invalid checkpoint file.");
+
+  auto* fingerprint = dynamic_cast<TNamed*>(checkpointFile->Get("eventCacheFingerprint"));
+  if( _useEventCacheFingerprint_ and fingerprint != nullptr ){
+    LogThrowIf(
+        std::string(fingerprint->GetTitle()) != this->evalEventCacheFingerprint(),
+        "The loaded events don't match the ones of the checkpoint: " << _resumeCheckpointFilePath_
+    );
+  }
+
+  // chi2 history of the previous job(s)
+  auto* chi2History = dynamic_cast<TTree*>(checkpointFile->Get("chi2History"));
+  if( chi2History != nullptr and _chi2HistoryTree_ != nullptr ){
+    chi2History->SetBranchAddress("nbFitCalls", &_nbFitCalls_);
+    chi2History->SetBranchAddress("chi2Total", &_chi2Buffer_);
+    chi2History->SetBranchAddress("chi2Stat", &_chi2StatBuffer_);
+    chi2History->SetBranchAddress("chi2Pulls", &_chi2PullsBuffer_);
+    for( Long64_t iEntry = 0 ; iEntry < chi2History->GetEntries() ; iEntry++ ){
+      chi2History->GetEntry(iEntry);
+      _chi2HistoryTree_->Fill();
+    }
+    chi2History->ResetBranchAddresses();
+  }
+
+  int nFitPars = int(_minimizer_->NDim());
+  std::vector<double> fitPointValueList(nFitPars);
+  ROOT::Math::ParameterSettings parSettings;
+  int nbMatched{0};
+  for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+    _minimizer_->GetVariableSettings(iFitPar, parSettings);
+    fitPointValueList[iFitPar] = parSettings.Value();
+    int iBin = fitPoint->GetXaxis()->FindFixBin(_minimizer_->VariableName(iFitPar).c_str());
+    if( iBin < 1 ){
+      LogAlert << "Not in checkpoint, kept at its current value: " << _minimizer_->VariableName(iFitPar) << std::endl;
+      continue;
+    }
+    nbMatched++;
+    fitPointValueList[iFitPar] = fitPoint->GetBinContent(iBin);
+    _minimizer_->SetVariableValue(iFitPar, fitPointValueList[iFitPar]);
+    if( fitPoint->GetBinError(iBin) > 0 ){ _minimizer_->SetVariableStepSize(iFitPar, fitPoint->GetBinError(iBin)); }
+  }
+
+  // not through evalFit: the restored point is not a new call of the chi2 history
+  for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+    auto& par = *_minimizerFitParameterPtr_[iFitPar];
+    if( _useNormalizedFitSpace_ ){ par.setParameterValue(FitParameterSet::toRealParValue(fitPointValueList[iFitPar], par)); }
+    else{ par.setParameterValue(fitPointValueList[iFitPar]); }
+  }
+  this->updateChi2Cache();
+  _nbFitCalls_ = nbFitCalls->GetVal();
+  _fitHasConverged_ = bool(fitHasConverged->GetVal());
+
+  LogInfo << "Checkpoint stage \"" << stage->GetTitle() << "\": " << nbMatched << "/" << nFitPars << " parameters restored after "
+          << _nbFitCalls_ << " calls, " << GUNDAM_CHI2 << " = " << _chi2Buffer_ << std::endl;
+  std::string out = stage->GetTitle();
+  checkpointFile->Close();
+  return out;
+}
+void FitterEngine::warmStartFromFile(const nlohmann::json& warmStartConfig_){
+  LogWarning << "Warm start from previous fit: " << _warmStartFilePath_ << std::endl;
+
+  bool useStepSizes = JsonUtils::fetchValue(warmStartConfig_, "useStepSizes", true);
+  bool useCovarianceMatrix = JsonUtils::fetchValue(warmStartConfig_, "useCovarianceMatrix", false);
+
+  std::unique_ptr<TFile> warmStartFile( TFile::Open(_warmStartFilePath_.c_str(), "READ") );
+  LogThrowIf(warmStartFile == nullptr or warmStartFile->IsZombie(), "Could not open warm start file: " << _warmStartFilePath_);
+
+  // The post-fit errors of the previous job: Hesse ones if any
+  std::vector<std::string> postFitDirCandidates;
+  if( JsonUtils::doKeyExist(warmStartConfig_, "postFitDir") ){
+    postFitDirCandidates.emplace_back(JsonUtils::fetchValue<std::string>(warmStartConfig_, "postFitDir"));
+  }
+  else{
+    postFitDirCandidates = {"FitterEngine/postFit/Hesse", "FitterEngine/postFit/" + _minimizerAlgo_, "FitterEngine/postFit/Migrad"};
+  }
+  TDirectory* errorsDir{nullptr};
+  for( auto& postFitDir : postFitDirCandidates ){
+    errorsDir = warmStartFile->GetDirectory((postFitDir + "/errors").c_str());
+    if( errorsDir != nullptr ){ LogInfo << "Reading post-fit parameters from: " << postFitDir << std::endl; break; }
+  }
+  LogThrowIf(errorsDir == nullptr, "No post-fit errors found in " << _warmStartFilePath_ << ": " << GenericToolbox::parseVectorAsString(postFitDirCandidates));
+
+  // Parameters are matched by set name and title with the bin labels of the post-fit hists
+  int nbMatched{0};
+  int nbMissing{0};
+  std::map<const FitParameter*, std::pair<TH1D*, int>> fitParBinList; // effective parameters only
+  std::map<const FitParameterSet*, TMatrixD*> fitCovMatrixList;
+
+  auto matchBinsFct = [](TH1D* hist_, std::vector<FitParameter>& parList_){
+    std::vector<int> out(parList_.size(), -1);
+    if( hist_ == nullptr ) return out;
+    std::map<std::string, int> titleToBin;
+    for( int iBin = 1 ; iBin <= hist_->GetNbinsX() ; iBin++ ){ titleToBin[hist_->GetXaxis()->GetBinLabel(iBin)] = iBin; }
+    for( auto& par : parList_ ){
+      if( titleToBin.find(par.getTitle()) != titleToBin.end() ){ out[par.getParameterIndex()] = titleToBin[par.getTitle()]; }
+    }
+    return out;
+  };
+
+  for( auto& parSet : _propagator_.getParameterSetsList() ){
+    if( not parSet.isEnabled() ){ continue; }
+
+    auto* parSetDir = errorsDir->GetDirectory(parSet.getName().c_str());
+    if( parSetDir == nullptr ){
+      LogAlert << "\"" << parSet.getName() << "\" not found in warm start file: kept at its current values." << std::endl;
+      continue;
+    }
+
+    // original parameter values
+    auto* valuesHist = dynamic_cast<TH1D*>(parSetDir->Get("values/postFitErrors_TH1D"));
+    auto binList = matchBinsFct(valuesHist, parSet.getParameterList());
+    for( auto& par : parSet.getParameterList() ){
+      if( not par.isEnabled() or par.isFixed() ){ continue; }
+      if( binList[par.getParameterIndex()] == -1 ){
+        LogAlert << "Not in warm start file, kept at its current value: " << par.getFullTitle() << std::endl;
+        nbMissing++;
+        continue;
+      }
+      par.setParameterValue(valuesHist->GetBinContent(binList[par.getParameterIndex()]));
+      nbMatched++;
+    }
+
+    // the fitted ones: errors and covariance of the eigen parameters if they were in the fit
+    TDirectory* fitSpaceDir = parSetDir;
+    if( parSet.isUseEigenDecompInFit() ){
+      parSet.propagateOriginalToEigen();
+      fitSpaceDir = parSetDir->GetDirectory("eigen");
+      if( fitSpaceDir == nullptr ){
+        LogAlert << "\"" << parSet.getName() << "\": no eigen parameters in warm start file, step sizes and covariance not used." << std::endl;
+        continue;
+      }
+    }
+
+    auto* fitValuesHist = dynamic_cast<TH1D*>(fitSpaceDir->Get("values/postFitErrors_TH1D"));
+    auto fitBinList = matchBinsFct(fitValuesHist, parSet.getEffectiveParameterList());
+    for( auto& par : parSet.getEffectiveParameterList() ){
+      if( fitBinList[par.getParameterIndex()] != -1 ){ fitParBinList[&par] = {fitValuesHist, fitBinList[par.getParameterIndex()]}; }
+    }
+    fitCovMatrixList[&parSet] = dynamic_cast<TMatrixD*>(fitSpaceDir->Get("matrices/Covariance_TMatrixD"));
+  }
+
+  // Updating the minimizer starting point
+  for( int iFitPar = 0 ; iFitPar < _nbFitParameters_ ; iFitPar++ ){
+    auto& fitPar = *_minimizerFitParameterPtr_[iFitPar];
+    if( not _useNormalizedFitSpace_ ){ _minimizer_->SetVariableValue(iFitPar, fitPar.getParameterValue()); }
+    else{ _minimizer_->SetVariableValue(iFitPar, FitParameterSet::toNormalizedParValue(fitPar.getParameterValue(), fitPar)); }
+
+    if( not useStepSizes or fitParBinList.find(&fitPar) == fitParBinList.end() ){ continue; }
+    double postFitError = fitParBinList[&fitPar].first->GetBinError(fitParBinList[&fitPar].second);
+    if( not (postFitError > 0) ){ continue; }
+    fitPar.setStepSize(postFitError);
+    if( not _useNormalizedFitSpace_ ){ _minimizer_->SetVariableStepSize(iFitPar, postFitError); }
+    else{ _minimizer_->SetVariableStepSize(iFitPar, FitParameterSet::toNormalizedParRange(postFitError, fitPar)); }
+  }
+
+  if( useCovarianceMatrix ){
+    // Block diagonal per parameter set: the correlations across sets are not kept in the per-set matrices.
+    // Packed lower triangle as expected by MnUserCovariance: element (i, j<=i) at i*(i+1)/2 + j
+    std::vector<double> covMatrix(_nbFitParameters_ * (_nbFitParameters_ + 1) / 2, 0);
+    int nbFilled{0};
+    for( int iFitPar = 0 ; iFitPar < _nbFitParameters_ ; iFitPar++ ){
+      auto& iPar = *_minimizerFitParameterPtr_[iFitPar];
+      double iScale = (_useNormalizedFitSpace_ ? FitParameterSet::toNormalizedParRange(1, iPar) : 1);
+      auto* parCov = fitCovMatrixList[_minimizerFitParameterSetPtr_[iFitPar]];
+
+      if( parCov == nullptr or fitParBinList.find(&iPar) == fitParBinList.end() ){
+        // no information: diagonal from the step size
+        double step = (_useNormalizedFitSpace_ ? FitParameterSet::toNormalizedParRange(iPar.getStepSize(), iPar) : iPar.getStepSize());
+        covMatrix[iFitPar * (iFitPar + 1) / 2 + iFitPar] = step * step;
+        continue;
+      }
+      nbFilled++;
+
+      int iCov = fitParBinList[&iPar].second - 1;
+      for( int jFitPar = 0 ; jFitPar <= iFitPar ; jFitPar++ ){
+        if( _minimizerFitParameterSetPtr_[jFitPar] != _minimizerFitParameterSetPtr_[iFitPar] ){ continue; }
+        auto& jPar = *_minimizerFitParameterPtr_[jFitPar];
+        if( fitParBinList.find(&jPar) == fitParBinList.end() ){ continue; }
+        double jScale = (_useNormalizedFitSpace_ ? FitParameterSet::toNormalizedParRange(1, jPar) : 1);
+        int jCov = fitParBinList[&jPar].second - 1;
+        if( iCov >= parCov->GetNrows() or jCov >= parCov->GetNcols() ){ continue; }
+        covMatrix[iFitPar * (iFitPar + 1) / 2 + jFitPar] = (*parCov)[iCov][jCov] * iScale * jScale;
+      }
+    }
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,24,0)
+    if( _minimizer_->SetCovariance(covMatrix, _nbFitParameters_) ){
+      LogInfo << "Initial error matrix set from the warm start file (" << nbFilled << "/" << _nbFitParameters_ << " parameters)." << std::endl;
+    }
+    else{
+      LogAlert << _minimizerType_ << "/" << _minimizerAlgo_ << " does not accept an initial error matrix: only the step sizes are used." << std::endl;
+    }
+#else
+    LogAlert << "Setting an initial error matrix requires ROOT >= 6.24: only the step sizes are used." << std::endl;
+#endif
+  }
+
+  this->updateChi2Cache();
+
+  LogInfo << "Warm start: " << nbMatched << " parameters matched, " << nbMissing << " kept at their current value, "
+          << GUNDAM_CHI2 << " = " << _chi2Buffer_ << std::endl;
+  warmStartFile->Close();
+}
+std::string FitterEngine::evalEventCacheFingerprint(){
+  // The loaded MC events (weights and bins) and the data histograms
+  TMD5 md5;
+  for( const auto& sample : _propagator_.getFitSampleSet().getFitSampleList() ){
+    std::vector<double> eventData;
+    eventData.reserve(2 * sample.getMcContainer().eventList.size());
+    for( const auto& event : sample.getMcContainer().eventList ){
+      eventData.emplace_back(event.getTreeWeight());
+      eventData.emplace_back(double(event.getSampleBinIndex()));
+    }
+    if( not eventData.empty() ){ md5.Update((const UChar_t*) &eventData[0], UInt_t(eventData.size() * sizeof(double))); }
+    const auto* dataHist = sample.getDataContainer().histogram.get();
+    md5.Update((const UChar_t*) dataHist->GetArray(), UInt_t((dataHist->GetNbinsX() + 2) * sizeof(double)));
+  }
+  md5.Final();
+  return md5.AsString();
+}
+
+void FitterEngine::writePostFitData(TDirectory* saveDir_, const TMatrixDSym* covMatrix_) {
   LogInfo << __METHOD_NAME__ << std::endl;
 
   LogThrowIf(saveDir_==nullptr, "Save dir not specified")
@@ -883,7 +2079,13 @@ void FitterEngine::writePostFitData(TDirectory* saveDir_) {
   auto* matricesDir = GenericToolbox::mkdirTFile(saveDir_, "hessian");
 
   TMatrixDSym totalCovMatrix(int(_minimizer_->NDim()));
-  _minimizer_->GetCovMatrix(totalCovMatrix.GetMatrixArray());
+  if( covMatrix_ != nullptr ){
+    LogThrowIf(covMatrix_->GetNrows() != totalCovMatrix.GetNrows(), "Provided covariance matrix doesn't match the number of fit parameters.")
+    totalCovMatrix = *covMatrix_;
+  }
+  else{
+    _minimizer_->GetCovMatrix(totalCovMatrix.GetMatrixArray());
+  }
 
   std::function<void(TDirectory*)> decomposeCovarianceMatrixFct = [&](TDirectory* outDir_){
     GenericToolbox::writeInTFile(outDir_, BIND_VAR_REF_NAME(totalCovMatrix));
@@ -1463,6 +2665,9 @@ void FitterEngine::initializeMinimizer(bool doReleaseFixed_){
   }
   _nbFitParameters_ = int(_minimizerFitParameterPtr_.size());
 
+  _chi2CacheSize_ = JsonUtils::fetchValue(_config_, "chi2CacheSize", _chi2CacheSize_);
+  _chi2CacheList_.clear();
+
   LogInfo << "Building functor..." << std::endl;
   _functor_ = std::make_shared<ROOT::Math::Functor>(
     this, &FitterEngine::evalFit, _nbFitParameters_
@@ -1549,3 +2754,211 @@ void FitterEngine::checkNumericalAccuracy(){
   }
   LogInfo << "OK" << std::endl;
 }
+
+TMatrixDSym FitterEngine::evalAnalyticCovarianceMatrix(){
+  LogInfo << __METHOD_NAME__ << std::endl;
+
+  // chi2_stat = sum_b f_b(mu_b) -> d2chi2/dxi.dxj ~ sum_b f''_b * dmu_b/dxi * dmu_b/dxj (Gauss-Newton, d2mu terms dropped)
+  // The per-bin derivatives are taken by central differences: 2 propagations per free parameter instead of O(N^2) fit calls.
+  int nFitPars = int(_minimizer_->NDim());
+  double stepFraction = JsonUtils::fetchValue(_minimizerConfig_, "analyticHessianStepFraction", 1E-2);
+  LogInfo << "Using derivative step of " << stepFraction << " sigma." << std::endl;
+
+  auto& sampleList = _propagator_.getFitSampleSet().getFitSampleList();
+  const auto& jointProbability = _propagator_.getFitSampleSet().getJointProbabilityFct();
+
+  auto setFitParameterValue = [&](int iFitPar_, double fitSpaceValue_){
+    auto& par = *_minimizerFitParameterPtr_[iFitPar_];
+    if( _useNormalizedFitSpace_ ) par.setParameterValue(FitParameterSet::toRealParValue(fitSpaceValue_, par));
+    else par.setParameterValue(fitSpaceValue_);
+  };
+  auto fillBinArray = [&](std::vector<double>& out_, const std::function<const TH1D*(const FitSample&)>& getHist_, bool isSumw2_){
+    size_t offset{0};
+    for( const auto& sample : sampleList ){
+      const TH1D* hist = getHist_(sample);
+      const double* array = (isSumw2_ ? hist->GetSumw2()->GetArray() : hist->GetArray()) + 1; // skip underflow
+      size_t nBins = sample.getBinning().getBinsList().size();
+      std::copy(array, array + nBins, out_.begin() + long(offset));
+      offset += nBins;
+    }
+  };
+  auto getMcHist = [](const FitSample& s_) -> const TH1D* { return s_.getMcContainer().histogram.get(); };
+  auto getDataHist = [](const FitSample& s_) -> const TH1D* { return s_.getDataContainer().histogram.get(); };
+
+  // Start from the minimum
+  int nbPropagations{0};
+  for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){ setFitParameterValue(iFitPar, _minimizer_->X()[iFitPar]); }
+  _propagator_.propagateParametersOnSamples(); nbPropagations++;
+
+  std::vector<double> mcBins(_nbFitBins_), mcSumw2Bins(_nbFitBins_), dataBins(_nbFitBins_);
+  fillBinArray(mcBins, getMcHist, false);
+  fillBinArray(mcSumw2Bins, getMcHist, true);
+  fillBinArray(dataBins, getDataHist, false);
+
+  LogInfo << "Computing the curvature of the likelihood in each bin..." << std::endl;
+  std::vector<double> binCurvatureList(_nbFitBins_, 0);
+  for( int iBin = 0 ; iBin < _nbFitBins_ ; iBin++ ){
+    if( mcBins[iBin] <= 0 ) continue;
+    double h = 1E-3 * mcBins[iBin];
+    double predList[3] = {mcBins[iBin] - h, mcBins[iBin], mcBins[iBin] + h};
+    double llhList[3];
+    for( int k = 0 ; k < 3 ; k++ ){
+      llhList[k] = jointProbability->eval(&predList[k], &mcSumw2Bins[iBin], &dataBins[iBin], 1);
+    }
+    // Gauss-Newton requires a positive semi-definite weight
+    binCurvatureList[iBin] = std::max(0., (llhList[0] - 2*llhList[1] + llhList[2]) / (h*h));
+  }
+
+  LogInfo << "Computing the derivatives of the bin contents..." << std::endl;
+  std::vector<std::vector<double>> jacobian(nFitPars); // [iFitPar][iBin], empty if fixed
+  std::vector<double> mcUpBins(_nbFitBins_), mcDownBins(_nbFitBins_);
+  for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+    GenericToolbox::displayProgressBar(iFitPar, nFitPars, "Computing the derivatives of the bin contents...");
+    if( _minimizer_->IsFixedVariable(iFitPar) ) continue;
+
+    auto& par = *_minimizerFitParameterPtr_[iFitPar];
+    double step = stepFraction;
+    if( not _useNormalizedFitSpace_ ){
+      if( par.getStdDevValue() == par.getStdDevValue() and par.getStdDevValue() > 0 ){ step *= par.getStdDevValue(); }
+      else{ step *= par.getStepSize(); }
+    }
+
+    setFitParameterValue(iFitPar, _minimizer_->X()[iFitPar] + step);
+    _propagator_.propagateParametersOnSamples(); nbPropagations++;
+    fillBinArray(mcUpBins, getMcHist, false);
+
+    setFitParameterValue(iFitPar, _minimizer_->X()[iFitPar] - step);
+    _propagator_.propagateParametersOnSamples(); nbPropagations++;
+    fillBinArray(mcDownBins, getMcHist, false);
+
+    setFitParameterValue(iFitPar, _minimizer_->X()[iFitPar]);
+
+    jacobian[iFitPar].resize(_nbFitBins_);
+    for( int iBin = 0 ; iBin < _nbFitBins_ ; iBin++ ){
+      jacobian[iFitPar][iBin] = (mcUpBins[iBin] - mcDownBins[iBin]) / (2*step);
+    }
+  }
+  GenericToolbox::displayProgressBar(nFitPars, nFitPars, "Computing the derivatives of the bin contents...");
+
+  LogInfo << "Building J^T.W.J..." << std::endl;
+  TMatrixDSym hessian(nFitPars);
+  std::function<void(int)> fillHessianFct = [&](int iThread_){
+    int nThreads = GlobalVariables::getNbThreads();
+    if( iThread_ == -1 ){ iThread_ = 0; nThreads = 1; }
+    // each thread owns the (iFitPar, jFitPar <= iFitPar) elements of its rows and their symmetric counterpart
+    for( int iFitPar = iThread_ ; iFitPar < nFitPars ; iFitPar += nThreads ){
+      if( jacobian[iFitPar].empty() ) continue;
+      for( int jFitPar = 0 ; jFitPar <= iFitPar ; jFitPar++ ){
+        if( jacobian[jFitPar].empty() ) continue;
+        double sum{0};
+        for( int iBin = 0 ; iBin < _nbFitBins_ ; iBin++ ){
+          sum += binCurvatureList[iBin] * jacobian[iFitPar][iBin] * jacobian[jFitPar][iBin];
+        }
+        hessian[iFitPar][jFitPar] = sum;
+        hessian[jFitPar][iFitPar] = sum;
+      }
+    }
+  };
+  GlobalVariables::getParallelWorker().addJob(__METHOD_NAME__, fillHessianFct);
+  GlobalVariables::getParallelWorker().runJob(__METHOD_NAME__);
+  GlobalVariables::getParallelWorker().removeJob(__METHOD_NAME__);
+
+  LogInfo << "Adding the penalty terms..." << std::endl;
+  for( auto& parSet : _propagator_.getParameterSetsList() ){
+    if( not parSet.isEnabled() ) continue;
+    TMatrixD penaltyHessian = parSet.getPenaltyHessian();
+
+    // fit parameters belonging to this set, with their index in the effective parameter list
+    std::vector<std::pair<int, int>> indexList;
+    for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+      if( _minimizerFitParameterSetPtr_[iFitPar] != &parSet or jacobian[iFitPar].empty() ) continue;
+      indexList.emplace_back(iFitPar, int(_minimizerFitParameterPtr_[iFitPar] - &parSet.getEffectiveParameterList()[0]));
+    }
+
+    for( const auto& iIndex : indexList ){
+      double iScale = ( _useNormalizedFitSpace_ ? FitParameterSet::toRealParRange(1., *_minimizerFitParameterPtr_[iIndex.first]) : 1. );
+      for( const auto& jIndex : indexList ){
+        double jScale = ( _useNormalizedFitSpace_ ? FitParameterSet::toRealParRange(1., *_minimizerFitParameterPtr_[jIndex.first]) : 1. );
+        hessian[iIndex.first][jIndex.first] += penaltyHessian[iIndex.second][jIndex.second] * iScale * jScale;
+      }
+    }
+  }
+
+  LogInfo << "Inverting the Hessian..." << std::endl;
+  std::vector<int> activeList;
+  for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+    if( jacobian[iFitPar].empty() ) continue;
+    if( hessian[iFitPar][iFitPar] <= 0 ){
+      LogAlert << _minimizer_->VariableName(iFitPar) << " has no constraint from the data nor the penalty: its error is left at 0." << std::endl;
+      continue;
+    }
+    activeList.emplace_back(iFitPar);
+  }
+
+  TMatrixDSym activeHessian(int(activeList.size()));
+  for( int i = 0 ; i < int(activeList.size()) ; i++ ){
+    for( int j = 0 ; j < int(activeList.size()) ; j++ ){ activeHessian[i][j] = hessian[activeList[i]][activeList[j]]; }
+  }
+  double det{0};
+  activeHessian.Invert(&det);
+  if( det <= 0 ){ LogAlert << "The Gauss-Newton Hessian is not positive definite: " << GET_VAR_NAME_VALUE(det) << std::endl; }
+
+  // Same convention as Minuit: V = 2 * ErrorDef * (d2chi2)^-1
+  TMatrixDSym covMatrix(nFitPars);
+  for( int i = 0 ; i < int(activeList.size()) ; i++ ){
+    for( int j = 0 ; j < int(activeList.size()) ; j++ ){
+      covMatrix[activeList[i]][activeList[j]] = 2. * _minimizer_->ErrorDef() * activeHessian[i][j];
+    }
+  }
+
+  LogInfo << "Hessian built with " << nbPropagations << " propagations." << std::endl;
+
+  // Back to the minimum
+  this->updateChi2Cache();
+
+  return covMatrix;
+}
+void FitterEngine::compareAnalyticCovarianceWithHesse(const TMatrixDSym& analyticCovMatrix_, TDirectory* saveDir_){
+  LogInfo << __METHOD_NAME__ << std::endl;
+
+  LogWarning << std::endl << GenericToolbox::addUpDownBars("Calling HESSE for comparison...") << std::endl;
+  int nbFitCallOffset = _nbFitCalls_;
+  _minimizer_->Hesse();
+  if( _isPropagatorStale_ ){ updateChi2Cache(); }
+  LogInfo << "Hesse ended after " << _nbFitCalls_ - nbFitCallOffset << " calls." << std::endl;
+  LogWarning << "Covariance matrix status code: " << covMatrixStatusCodeStr.at(_minimizer_->CovMatrixStatus()) << std::endl;
+
+  int nFitPars = int(_minimizer_->NDim());
+  TMatrixDSym hesseCovMatrix(nFitPars);
+  _minimizer_->GetCovMatrix(hesseCovMatrix.GetMatrixArray());
+
+  auto* errorRatioHist = new TH1D("analyticOverHesseErrors", "AnalyticHessian / Hesse errors", nFitPars, 0, nFitPars);
+
+  GenericToolbox::TablePrinter t;
+  t.setColTitles({{"Parameter"}, {"AnalyticHessian"}, {"Hesse"}, {"Ratio"}});
+
+  double maxDeviation{0};
+  for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+    double analyticError = std::sqrt(std::max(0., analyticCovMatrix_[iFitPar][iFitPar]));
+    double hesseError = std::sqrt(std::max(0., hesseCovMatrix[iFitPar][iFitPar]));
+    double ratio = ( hesseError != 0 ? analyticError / hesseError : std::nan("unset") );
+
+    t.addTableLine({_minimizer_->VariableName(iFitPar), std::to_string(analyticError), std::to_string(hesseError), std::to_string(ratio)});
+    errorRatioHist->SetBinContent(iFitPar+1, ratio);
+    errorRatioHist->GetXaxis()->SetBinLabel(iFitPar+1, _minimizer_->VariableName(iFitPar).c_str());
+    if( ratio == ratio ){ maxDeviation = std::max(maxDeviation, std::abs(ratio - 1)); }
+  }
+  t.printTable();
+  LogInfo << "Max relative deviation of the errors w.r.t. HESSE: " << maxDeviation * 100 << "%" << std::endl;
+
+  GenericToolbox::writeInTFile(saveDir_, errorRatioHist, "analyticOverHesseErrors");
+  GenericToolbox::writeInTFile(saveDir_, BIND_VAR_REF_NAME(hesseCovMatrix));
+
+  // Hesse leaves the parameters at its last evaluation point
+  for( int iFitPar = 0 ; iFitPar < nFitPars ; iFitPar++ ){
+    auto& par = *_minimizerFitParameterPtr_[iFitPar];
+    if( _useNormalizedFitSpace_ ) par.setParameterValue(FitParameterSet::toRealParValue(_minimizer_->X()[iFitPar], par));
+    else par.setParameterValue(_minimizer_->X()[iFitPar]);
+  }
+  this->updateChi2Cache();
+}
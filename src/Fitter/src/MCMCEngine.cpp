@@ -0,0 +1,530 @@
+//
+// MCMCEngine.cpp
+//
+
+#include "MCMCEngine.h"
+#include "JsonUtils.h"
+#include "GlobalVariables.h"
+#include "Dial.h"
+
+#include "Logger.h"
+#include "GenericToolbox.Root.h"
+#include "GenericToolbox.h"
+#include "GenericToolbox.TablePrinter.h"
+
+#include "TDecompChol.h"
+#include "TMatrixDSym.h"
+#include "TH1D.h"
+
+#include <cmath>
+#include <chrono>
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+
+
+LoggerInit([]{
+  Logger::setUserHeaderStr("[MCMCEngine]");
+});
+
+MCMCEngine::MCMCEngine() { this->reset(); }
+MCMCEngine::~MCMCEngine() { this->reset(); }
+
+void MCMCEngine::reset() {
+  _isInitialized_ = false;
+  _saveDir_ = nullptr;
+  _config_.clear();
+  _fitterEnginePtr_ = nullptr;
+
+  _freeParList_.clear();
+  _startValueList_.clear();
+  _origParList_.clear();
+  _origStartValueList_.clear();
+  _origSlopeList_.clear();
+  _eventTableList_.clear();
+  _penaltyGradient_.clear();
+  _penaltyHessian_.clear();
+  _initialProposalCov_.clear();
+  _chainList_.clear();
+
+  _stepTree_ = nullptr;
+}
+
+void MCMCEngine::setSaveDir(TDirectory *saveDir) {
+  _saveDir_ = saveDir;
+}
+void MCMCEngine::setConfig(const nlohmann::json &config_) {
+  _config_ = config_;
+  JsonUtils::forwardConfig(_config_);
+}
+void MCMCEngine::setFitterEngine(FitterEngine *fitterEnginePtr_) {
+  _fitterEnginePtr_ = fitterEnginePtr_;
+}
+
+void MCMCEngine::initialize() {
+  LogThrowIf(_fitterEnginePtr_ == nullptr, "FitterEngine not set.");
+  LogThrowIf(_fitterEnginePtr_->getMinimizer() == nullptr, "FitterEngine has not been initialized.");
+
+  _nbChains_ = JsonUtils::fetchValue(_config_, "nbChains", GlobalVariables::getNbThreads());
+  _nbSteps_ = JsonUtils::fetchValue(_config_, "nbSteps", _nbSteps_);
+  _nbBurnInSteps_ = JsonUtils::fetchValue(_config_, "nbBurnInSteps", _nbBurnInSteps_);
+  _nbStepsPerBlock_ = std::max(1, JsonUtils::fetchValue(_config_, "nbStepsPerBlock", _nbStepsPerBlock_));
+  _adaptationInterval_ = std::max(1, JsonUtils::fetchValue(_config_, "adaptationInterval", _adaptationInterval_));
+  _saveBurnIn_ = JsonUtils::fetchValue(_config_, "saveBurnIn", _saveBurnIn_);
+  _targetAcceptance_ = JsonUtils::fetchValue(_config_, "targetAcceptance", _targetAcceptance_);
+  _startingPointSpread_ = JsonUtils::fetchValue(_config_, "startingPointSpread", _startingPointSpread_);
+  _compressionSettings_ = JsonUtils::fetchValue(_config_, "compressionSettings", _compressionSettings_);
+  _proposalCovariance_ = JsonUtils::fetchValue(_config_, "proposalCovariance", _proposalCovariance_);
+  LogThrowIf(_nbChains_ < 1, "Invalid number of chains: " << _nbChains_);
+
+  _fitterEnginePtr_->getPropagator().preventRfPropagation(); // dials are evaluated directly
+  _fitterEnginePtr_->updateChi2Cache();
+
+  _freeParList_ = _fitterEnginePtr_->getMinimizerFitParameterPtr();
+  _startValueList_.clear();
+  for( auto* parPtr : _freeParList_ ){ _startValueList_.emplace_back(parPtr->getParameterValue()); }
+  LogInfo << "Sampling " << _freeParList_.size() << " parameters with " << _nbChains_ << " chain(s) of "
+          << _nbBurnInSteps_ << " burn-in + " << _nbSteps_ << " steps." << std::endl;
+
+  this->buildEventTables();
+  this->buildPenaltyQuadraticForm();
+  this->buildInitialProposal();
+  this->initializeChains();
+
+  _isInitialized_ = true;
+}
+
+void MCMCEngine::run() {
+  LogThrowIf(not _isInitialized_, "MCMCEngine not initialized.");
+  LogWarning << std::endl << GenericToolbox::addUpDownBars("Running MCMC chains...") << std::endl;
+
+  size_t nPars = _freeParList_.size();
+  if( _saveDir_ != nullptr ){
+    GenericToolbox::mkdirTFile(_saveDir_, "chains")->cd();
+    _stepTree_ = new TTree("steps", "MCMC steps");
+    _stepTreeParValueList_.resize(std::max(nPars, size_t(1)), 0);
+    _stepTree_->Branch("chain", &_stepTreeChain_);
+    _stepTree_->Branch("step", &_stepTreeStep_);
+    _stepTree_->Branch("chi2", &_stepTreeChi2_);
+    _stepTree_->Branch("chi2Stat", &_stepTreeChi2Stat_);
+    _stepTree_->Branch("chi2Pulls", &_stepTreeChi2Pulls_);
+    _stepTree_->Branch("accepted", &_stepTreeAccepted_);
+    _stepTree_->Branch("parameters", &_stepTreeParValueList_[0], Form("parameters[%i]/D", int(nPars)));
+    for( int iBranch = 0 ; iBranch < _stepTree_->GetListOfBranches()->GetEntries() ; iBranch++ ){
+      dynamic_cast<TBranch*>(_stepTree_->GetListOfBranches()->At(iBranch))->SetCompressionSettings(_compressionSettings_);
+    }
+
+    // index of the "parameters" branch -> parameter title
+    TH1D startPoint("startPoint", "Starting point", int(nPars), 0, double(nPars));
+    startPoint.SetDirectory(nullptr);
+    for( size_t iPar = 0 ; iPar < nPars ; iPar++ ){
+      startPoint.GetXaxis()->SetBinLabel(int(iPar) + 1, _freeParList_[iPar]->getFullTitle().c_str());
+      startPoint.SetBinContent(int(iPar) + 1, _startValueList_[iPar]);
+    }
+    GenericToolbox::writeInTFile(GenericToolbox::mkdirTFile(_saveDir_, "chains"), &startPoint, "startPoint_TH1D");
+    GenericToolbox::mkdirTFile(_saveDir_, "chains")->cd();
+  }
+
+  int nThreads = GlobalVariables::getNbThreads();
+  int nbTotalSteps = _nbBurnInSteps_ + _nbSteps_;
+  int nbBlockSteps{0};
+  std::function<void(int)> runChainsFct = [&](int iThread_){
+    int nJobThreads = nThreads;
+    if( iThread_ == -1 ){ iThread_ = 0; nJobThreads = 1; }
+    for( size_t iChain = iThread_ ; iChain < _chainList_.size() ; iChain += nJobThreads ){
+      this->runSteps(_chainList_[iChain], nbBlockSteps);
+    }
+  };
+  GlobalVariables::getParallelWorker().addJob(__METHOD_NAME__, runChainsFct);
+
+  auto startTime = std::chrono::steady_clock::now();
+  for( int nbDone = 0 ; nbDone < nbTotalSteps ; nbDone += nbBlockSteps ){
+    nbBlockSteps = std::min(_nbStepsPerBlock_, nbTotalSteps - nbDone);
+    if( nbDone < _nbBurnInSteps_ ){ nbBlockSteps = std::min(nbBlockSteps, _nbBurnInSteps_ - nbDone); } // blocks don't straddle the burn-in
+
+    auto blockStartTime = std::chrono::steady_clock::now();
+    GlobalVariables::getParallelWorker().runJob(__METHOD_NAME__);
+    double blockTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - blockStartTime).count();
+
+    this->writeSteps();
+
+    int nbAccepted{0};
+    for( const auto& chain : _chainList_ ){ nbAccepted += chain.nbAccepted; }
+    LogInfo << ( nbDone < _nbBurnInSteps_ ? "Burn-in: " : "Sampling: " ) << nbDone + nbBlockSteps << "/" << nbTotalSteps
+            << " steps per chain, " << double(nbBlockSteps) / blockTime << " steps/s per chain, acceptance: "
+            << double(nbAccepted) / double((nbDone + nbBlockSteps) * _chainList_.size()) << std::endl;
+  }
+  GlobalVariables::getParallelWorker().removeJob(__METHOD_NAME__);
+  double totalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+  GenericToolbox::TablePrinter t;
+  t.setColTitles({{"Chain"}, {"Steps"}, {"Acceptance"}, {"Proposal scale"}, {"Final chi2"}});
+  for( size_t iChain = 0 ; iChain < _chainList_.size() ; iChain++ ){
+    const auto& chain = _chainList_[iChain];
+    t.addTableLine({
+      std::to_string(iChain), std::to_string(chain.nbStepsDone),
+      std::to_string(double(chain.nbAccepted) / chain.nbStepsDone), std::to_string(chain.proposalScale), std::to_string(chain.chi2)
+    });
+  }
+  t.printTable();
+  LogInfo << "MCMC done in " << totalTime << " s: " << double(nbTotalSteps) / totalTime << " steps/s per chain." << std::endl;
+
+  if( _stepTree_ != nullptr ){
+    GenericToolbox::mkdirTFile(_saveDir_, "chains")->cd();
+    _stepTree_->Write();
+  }
+}
+
+void MCMCEngine::buildEventTables(){
+  LogInfo << "Building the per-chain reweighting tables..." << std::endl;
+
+  auto getParSet = [&](const FitParameter* par_) -> FitParameterSet& {
+    FitParameterSet* out{nullptr};
+    for( auto& parSet : _fitterEnginePtr_->getPropagator().getParameterSetsList() ){ if( &parSet == par_->getOwner() ){ out = &parSet; break; } }
+    LogThrowIf(out == nullptr, "Parameter set of " << par_->getTitle() << " not found.");
+    return *out;
+  };
+
+  // Original parameters moved by each free one (the eigen -> original swap is linear)
+  std::unordered_map<const FitParameter*, size_t> origIndexDict;
+  auto getOrigIndex = [&](const FitParameter* par_){
+    auto it = origIndexDict.find(par_);
+    if( it != origIndexDict.end() ) return it->second;
+    origIndexDict[par_] = _origParList_.size();
+    _origParList_.emplace_back(par_);
+    _origStartValueList_.emplace_back(par_->getParameterValue());
+    return _origParList_.size() - 1;
+  };
+
+  _origSlopeList_.clear();
+  _origSlopeList_.resize(_freeParList_.size());
+  for( size_t iPar = 0 ; iPar < _freeParList_.size() ; iPar++ ){
+    auto& parSet = getParSet(_freeParList_[iPar]);
+    if( not parSet.isUseEigenDecompInFit() ){
+      _origSlopeList_[iPar].emplace_back(getOrigIndex(_freeParList_[iPar]), 1.);
+      continue;
+    }
+    std::vector<double> refValueList;
+    for( auto& par : parSet.getParameterList() ){ refValueList.emplace_back(par.getParameterValue()); }
+    _freeParList_[iPar]->setParameterValue(_startValueList_[iPar] + 1.);
+    parSet.propagateEigenToOriginal();
+    for( size_t iOrigPar = 0 ; iOrigPar < refValueList.size() ; iOrigPar++ ){
+      auto& par = parSet.getParameterList()[iOrigPar];
+      if( par.getParameterValue() == refValueList[iOrigPar] ) continue;
+      _origSlopeList_[iPar].emplace_back(getOrigIndex(&par), par.getParameterValue() - refValueList[iOrigPar]);
+    }
+    _freeParList_[iPar]->setParameterValue(_startValueList_[iPar]);
+    parSet.propagateEigenToOriginal();
+  }
+
+  // The responses of the dials not moving are folded into a constant weight per event
+  size_t nbDials{0};
+  _eventTableList_.clear();
+  for( auto& sample : _fitterEnginePtr_->getPropagator().getFitSampleSet().getFitSampleList() ){
+    _eventTableList_.emplace_back();
+    auto& table = _eventTableList_.back();
+    table.histScale = sample.getMcContainer().histScale;
+    table.dataBinContent = sample.getDataContainer().histogram->GetArray() + 1;
+    table.nbBins = size_t(sample.getDataContainer().histogram->GetNbinsX());
+    table.dialOffsetList.emplace_back(0);
+
+    for( auto& event : sample.getMcContainer().eventList ){
+      if( event.getSampleBinIndex() < 0 ) continue;
+      double baseWeight = event.getTreeWeight();
+      for( auto* dialPtr : event.getRawDialPtrList() ){
+        if( dialPtr == nullptr ) break;
+        if( Dial::enableMaskCheck and dialPtr->isMasked() ){ continue; }
+        auto origIt = origIndexDict.find(dialPtr->getOwner()->getOwner());
+        if( origIt == origIndexDict.end() ){ baseWeight *= dialPtr->evalResponse(); }
+        else{ table.dialList.emplace_back(dialPtr, origIt->second); }
+      }
+      table.baseWeightList.emplace_back(baseWeight);
+      table.binIndexList.emplace_back(event.getSampleBinIndex());
+      table.dialOffsetList.emplace_back(table.dialList.size());
+    }
+    nbDials += table.dialList.size();
+  }
+  LogInfo << _origParList_.size() << " original parameters moving " << nbDials << " dials." << std::endl;
+}
+void MCMCEngine::buildPenaltyQuadraticForm(){
+  size_t nPars = _freeParList_.size();
+  _penaltyGradient_.assign(nPars, 0);
+  _penaltyHessian_.assign(nPars, std::vector<double>(nPars, 0));
+
+  _penaltyStart_ = _fitterEnginePtr_->getChi2Buffer() - _fitterEnginePtr_->getChi2StatBuffer();
+
+  std::unordered_map<const FitParameterSet*, TMatrixD> hessianDict;
+  for( size_t iPar = 0 ; iPar < nPars ; iPar++ ){
+    auto* parSetPtr = _freeParList_[iPar]->getOwner();
+    if( hessianDict.find(parSetPtr) == hessianDict.end() ){ hessianDict.emplace(parSetPtr, parSetPtr->getPenaltyHessian()); }
+    const auto& parSetHessian = hessianDict.at(parSetPtr);
+    const auto& effParList = parSetPtr->getEffectiveParameterList();
+    int kPar = int(_freeParList_[iPar] - &effParList[0]);
+    for( int jPar = 0 ; jPar < int(effParList.size()) ; jPar++ ){
+      if( parSetHessian[kPar][jPar] == 0 ) continue;
+      _penaltyGradient_[iPar] += parSetHessian[kPar][jPar] * (effParList[jPar].getParameterValue() - effParList[jPar].getPriorValue());
+    }
+    for( size_t jPar = 0 ; jPar < nPars ; jPar++ ){
+      if( _freeParList_[jPar]->getOwner() != parSetPtr ) continue;
+      _penaltyHessian_[iPar][jPar] = parSetHessian[kPar][int(_freeParList_[jPar] - &effParList[0])];
+    }
+  }
+}
+void MCMCEngine::buildInitialProposal(){
+  int nPars = int(_freeParList_.size());
+  std::string source = _proposalCovariance_;
+  if( source == "auto" ){ source = ( _fitterEnginePtr_->isFitDone() ? "postFitHessian" : "priors" ); }
+  LogInfo << "Initial proposal covariance taken from: " << source << std::endl;
+
+  TMatrixDSym covMatrix(nPars);
+  if( source == "postFitHessian" ){
+    LogThrowIf(not _fitterEnginePtr_->isFitDone(), "postFitHessian proposal requested while the fit has not been done.");
+    const auto& minimizer = _fitterEnginePtr_->getMinimizer();
+    for( int iPar = 0 ; iPar < nPars ; iPar++ ){
+      double iScale = ( _fitterEnginePtr_->isUseNormalizedFitSpace() ? FitParameterSet::toRealParRange(1., *_freeParList_[iPar]) : 1. );
+      for( int jPar = 0 ; jPar < nPars ; jPar++ ){
+        double jScale = ( _fitterEnginePtr_->isUseNormalizedFitSpace() ? FitParameterSet::toRealParRange(1., *_freeParList_[jPar]) : 1. );
+        covMatrix[iPar][jPar] = minimizer->CovMatrix(iPar, jPar) * iScale * jScale;
+      }
+    }
+  }
+  else if( source == "priors" ){
+    // prior covariance = 2 x inverse of the penalty Hessian, parameters without prior get their step width
+    TMatrixDSym hessian(nPars);
+    for( int iPar = 0 ; iPar < nPars ; iPar++ ){
+      for( int jPar = 0 ; jPar < nPars ; jPar++ ){ hessian[iPar][jPar] = _penaltyHessian_[iPar][jPar]; }
+      if( hessian[iPar][iPar] == 0 ){ hessian[iPar][iPar] = 2. / std::pow(_freeParList_[iPar]->getStdDevValue(), 2); }
+    }
+    double det;
+    hessian.Invert(&det);
+    if( det == 0 ){
+      LogAlert << "Singular prior Hessian: using the parameter widths only." << std::endl;
+      for( int iPar = 0 ; iPar < nPars ; iPar++ ){ covMatrix[iPar][iPar] = std::pow(_freeParList_[iPar]->getStdDevValue(), 2); }
+    }
+    else{
+      covMatrix = hessian;
+      covMatrix *= 2.;
+    }
+  }
+  else{
+    LogThrow("Unknown proposalCovariance: " << source);
+  }
+
+  _initialProposalCov_.resize(nPars * nPars);
+  for( int iPar = 0 ; iPar < nPars ; iPar++ ){
+    for( int jPar = 0 ; jPar < nPars ; jPar++ ){ _initialProposalCov_[iPar * nPars + jPar] = covMatrix[iPar][jPar]; }
+  }
+
+  if( _saveDir_ != nullptr ){ GenericToolbox::writeInTFile(GenericToolbox::mkdirTFile(_saveDir_, "proposal"), &covMatrix, "initialProposalCovariance"); }
+}
+void MCMCEngine::initializeChains(){
+  size_t nPars = _freeParList_.size();
+
+  _chainList_.clear();
+  _chainList_.resize(_nbChains_);
+  for( auto& chain : _chainList_ ){
+    chain.prng.SetSeed(gRandom->Integer(std::numeric_limits<UInt_t>::max()));
+    chain.parValueList = _startValueList_;
+    chain.origParValueList.resize(_origParList_.size());
+    for( const auto& table : _eventTableList_ ){
+      chain.binContentList.emplace_back(table.nbBins, 0);
+      chain.binSumw2List.emplace_back(table.nbBins, 0);
+    }
+    chain.proposedValueList.resize(nPars);
+    chain.normalDrawList.resize(nPars);
+    chain.meanList.assign(nPars, 0);
+    chain.covSumList.assign(nPars * nPars, 0);
+
+    // Optimal scaling for gaussian targets: 2.38^2/d
+    chain.proposalScale = 2.38 / std::sqrt(double(std::max(nPars, size_t(1))));
+    this->updateProposal(chain);
+  }
+
+  // Optional spread of the starting points, drawn from the initial proposal
+  if( _startingPointSpread_ != 0 ){
+    for( auto& chain : _chainList_ ){
+      for( size_t iPar = 0 ; iPar < nPars ; iPar++ ){ chain.normalDrawList[iPar] = chain.prng.Gaus(); }
+      for( size_t iPar = 0 ; iPar < nPars ; iPar++ ){
+        for( size_t jPar = 0 ; jPar <= iPar ; jPar++ ){
+          chain.parValueList[iPar] += _startingPointSpread_ * chain.choleskyLowerList[iPar * nPars + jPar] * chain.normalDrawList[jPar];
+        }
+        auto& par = *_freeParList_[iPar];
+        if( par.getMinValue() == par.getMinValue() ){ chain.parValueList[iPar] = std::max(chain.parValueList[iPar], par.getMinValue()); }
+        if( par.getMaxValue() == par.getMaxValue() ){ chain.parValueList[iPar] = std::min(chain.parValueList[iPar], par.getMaxValue()); }
+      }
+    }
+  }
+
+  for( auto& chain : _chainList_ ){
+    this->evalChi2(chain, chain.parValueList, chain.chi2Stat, chain.chi2Pulls);
+    chain.chi2 = chain.chi2Stat + chain.chi2Pulls;
+  }
+  LogInfo << "Starting chi2 = " << _chainList_[0].chi2 << " (FitterEngine: " << _fitterEnginePtr_->getChi2Buffer() << ")" << std::endl;
+}
+
+void MCMCEngine::evalChi2(Chain& chain_, const std::vector<double>& parValueList_, double& chi2Stat_, double& chi2Pulls_){
+  // Only reads the events and dials: chains can be evaluated concurrently
+  const auto& jointProbability = _fitterEnginePtr_->getPropagator().getFitSampleSet().getJointProbabilityFct();
+  size_t nPars = parValueList_.size();
+
+  chain_.origParValueList = _origStartValueList_;
+  for( size_t iPar = 0 ; iPar < nPars ; iPar++ ){
+    double delta = parValueList_[iPar] - _startValueList_[iPar];
+    if( delta == 0 ) continue;
+    for( const auto& slope : _origSlopeList_[iPar] ){ chain_.origParValueList[slope.first] += slope.second * delta; }
+  }
+
+  chi2Stat_ = 0;
+  for( size_t iSample = 0 ; iSample < _eventTableList_.size() ; iSample++ ){
+    const auto& table = _eventTableList_[iSample];
+    auto& binContent = chain_.binContentList[iSample];
+    auto& binSumw2 = chain_.binSumw2List[iSample];
+    std::fill(binContent.begin(), binContent.end(), 0);
+    std::fill(binSumw2.begin(), binSumw2.end(), 0);
+
+    for( size_t iEvent = 0 ; iEvent < table.baseWeightList.size() ; iEvent++ ){
+      double weight = table.baseWeightList[iEvent];
+      for( size_t iDial = table.dialOffsetList[iEvent] ; iDial < table.dialOffsetList[iEvent + 1] ; iDial++ ){
+        weight *= table.dialList[iDial].first->calcResponse(chain_.origParValueList[table.dialList[iDial].second]);
+      }
+      binContent[table.binIndexList[iEvent]] += weight * table.histScale;
+      binSumw2[table.binIndexList[iEvent]] += weight * table.histScale * table.histScale;
+    }
+
+    chi2Stat_ += jointProbability->eval(binContent.data(), binSumw2.data(), table.dataBinContent, table.nbBins);
+  }
+
+  chi2Pulls_ = _penaltyStart_;
+  for( size_t iPar = 0 ; iPar < nPars ; iPar++ ){
+    double iDelta = parValueList_[iPar] - _startValueList_[iPar];
+    if( iDelta == 0 ) continue;
+    chi2Pulls_ += iDelta * _penaltyGradient_[iPar];
+    for( size_t jPar = 0 ; jPar < nPars ; jPar++ ){
+      chi2Pulls_ += 0.5 * iDelta * _penaltyHessian_[iPar][jPar] * (parValueList_[jPar] - _startValueList_[jPar]);
+    }
+  }
+}
+void MCMCEngine::runSteps(Chain& chain_, int nbSteps_){
+  size_t nPars = _freeParList_.size();
+
+  for( int iStep = 0 ; iStep < nbSteps_ ; iStep++ ){
+    bool isBurnIn = chain_.nbStepsDone < _nbBurnInSteps_;
+
+    // Proposal: x' = x + scale * L.z
+    for( size_t iPar = 0 ; iPar < nPars ; iPar++ ){ chain_.normalDrawList[iPar] = chain_.prng.Gaus(); }
+    bool isInRange{true};
+    for( size_t iPar = 0 ; iPar < nPars ; iPar++ ){
+      double shift{0};
+      for( size_t jPar = 0 ; jPar <= iPar ; jPar++ ){ shift += chain_.choleskyLowerList[iPar * nPars + jPar] * chain_.normalDrawList[jPar]; }
+      chain_.proposedValueList[iPar] = chain_.parValueList[iPar] + chain_.proposalScale * shift;
+
+      auto& par = *_freeParList_[iPar];
+      if( par.getMinValue() == par.getMinValue() and chain_.proposedValueList[iPar] < par.getMinValue() ){ isInRange = false; }
+      if( par.getMaxValue() == par.getMaxValue() and chain_.proposedValueList[iPar] > par.getMaxValue() ){ isInRange = false; }
+    }
+
+    bool isAccepted{false};
+    if( isInRange ){
+      double chi2Stat, chi2Pulls;
+      this->evalChi2(chain_, chain_.proposedValueList, chi2Stat, chi2Pulls);
+      // posterior ~ exp(-chi2/2)
+      if( std::log(chain_.prng.Uniform()) < -0.5 * (chi2Stat + chi2Pulls - chain_.chi2) ){
+        isAccepted = true;
+        chain_.parValueList.swap(chain_.proposedValueList);
+        chain_.chi2Stat = chi2Stat;
+        chain_.chi2Pulls = chi2Pulls;
+        chain_.chi2 = chi2Stat + chi2Pulls;
+      }
+    }
+
+    chain_.nbStepsDone++;
+    if( isAccepted ) chain_.nbAccepted++;
+
+    if( isBurnIn ){
+      // Running mean and covariance of the visited points (Welford)
+      chain_.nbAdaptationSteps++;
+      chain_.nbWindowSteps++;
+      if( isAccepted ) chain_.nbWindowAccepted++;
+      double n = chain_.nbAdaptationSteps;
+      for( size_t iPar = 0 ; iPar < nPars ; iPar++ ){ chain_.normalDrawList[iPar] = chain_.parValueList[iPar] - chain_.meanList[iPar]; }
+      for( size_t iPar = 0 ; iPar < nPars ; iPar++ ){ chain_.meanList[iPar] += chain_.normalDrawList[iPar] / n; }
+      for( size_t iPar = 0 ; iPar < nPars ; iPar++ ){
+        for( size_t jPar = 0 ; jPar < nPars ; jPar++ ){
+          chain_.covSumList[iPar * nPars + jPar] += chain_.normalDrawList[iPar] * (chain_.parValueList[jPar] - chain_.meanList[jPar]);
+        }
+      }
+      if( chain_.nbWindowSteps == _adaptationInterval_ ){ this->updateProposal(chain_); }
+    }
+
+    if( not isBurnIn or _saveBurnIn_ ){
+      chain_.stepParValueList.insert(chain_.stepParValueList.end(), chain_.parValueList.begin(), chain_.parValueList.end());
+      chain_.stepChi2List.emplace_back(chain_.chi2);
+      chain_.stepChi2StatList.emplace_back(chain_.chi2Stat);
+      chain_.stepChi2PullsList.emplace_back(chain_.chi2Pulls);
+      chain_.stepIndexList.emplace_back(chain_.nbStepsDone - 1);
+      chain_.stepAcceptedList.emplace_back(isAccepted);
+    }
+  }
+}
+void MCMCEngine::updateProposal(Chain& chain_){
+  // Haario et al. adaptive Metropolis: the proposal follows the covariance of the chain history once it has enough
+  // points, and its scale is tuned towards the target acceptance rate. Only done during the burn-in.
+  int nPars = int(_freeParList_.size());
+
+  if( chain_.nbWindowSteps != 0 ){
+    double acceptance = double(chain_.nbWindowAccepted) / chain_.nbWindowSteps;
+    chain_.proposalScale *= std::exp(acceptance - _targetAcceptance_);
+  }
+  chain_.nbWindowSteps = 0;
+  chain_.nbWindowAccepted = 0;
+
+  TMatrixDSym covMatrix(nPars);
+  bool useHistory = chain_.nbAdaptationSteps > 2 * nPars;
+  for( int iPar = 0 ; iPar < nPars ; iPar++ ){
+    for( int jPar = 0 ; jPar < nPars ; jPar++ ){
+      if( useHistory ){ covMatrix[iPar][jPar] = chain_.covSumList[iPar * nPars + jPar] / (chain_.nbAdaptationSteps - 1); }
+      else{ covMatrix[iPar][jPar] = _initialProposalCov_[iPar * nPars + jPar]; }
+    }
+    // regularization: keeps a stuck direction explorable
+    if( useHistory ){ covMatrix[iPar][iPar] += 1E-6 * _initialProposalCov_[iPar * nPars + iPar]; }
+  }
+
+  chain_.choleskyLowerList.assign(nPars * nPars, 0);
+  TDecompChol choleskyDecomp(covMatrix);
+  if( nPars != 0 and choleskyDecomp.Decompose() ){
+    const TMatrixD& uMatrix = choleskyDecomp.GetU(); // A = U^T.U
+    for( int iPar = 0 ; iPar < nPars ; iPar++ ){
+      for( int jPar = 0 ; jPar <= iPar ; jPar++ ){ chain_.choleskyLowerList[iPar * nPars + jPar] = uMatrix[jPar][iPar]; }
+    }
+  }
+  else{
+    for( int iPar = 0 ; iPar < nPars ; iPar++ ){
+      chain_.choleskyLowerList[iPar * nPars + iPar] = std::sqrt(std::abs(covMatrix[iPar][iPar]));
+    }
+  }
+}
+void MCMCEngine::writeSteps(){
+  for( size_t iChain = 0 ; iChain < _chainList_.size() ; iChain++ ){
+    auto& chain = _chainList_[iChain];
+    if( _stepTree_ != nullptr ){
+      size_t nPars = _freeParList_.size();
+      _stepTreeChain_ = int(iChain);
+      for( size_t iStep = 0 ; iStep < chain.stepIndexList.size() ; iStep++ ){
+        _stepTreeStep_ = chain.stepIndexList[iStep];
+        _stepTreeChi2_ = chain.stepChi2List[iStep];
+        _stepTreeChi2Stat_ = chain.stepChi2StatList[iStep];
+        _stepTreeChi2Pulls_ = chain.stepChi2PullsList[iStep];
+        _stepTreeAccepted_ = chain.stepAcceptedList[iStep];
+        std::copy(chain.stepParValueList.begin() + long(iStep * nPars), chain.stepParValueList.begin() + long((iStep + 1) * nPars), _stepTreeParValueList_.begin());
+        _stepTree_->Fill();
+      }
+    }
+    chain.stepParValueList.clear();
+    chain.stepChi2List.clear();
+    chain.stepChi2StatList.clear();
+    chain.stepChi2PullsList.clear();
+    chain.stepIndexList.clear();
+    chain.stepAcceptedList.clear();
+  }
+  if( _stepTree_ != nullptr ){ _stepTree_->AutoSave("SaveSelf"); } // what is written survives a killed job
+}
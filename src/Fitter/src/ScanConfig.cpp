@@ -19,6 +19,9 @@ void ScanConfig::readConfig() {
   _useParameterLimits_ = JsonUtils::fetchValue(_config_, "useParameterLimits", _useParameterLimits_);
   _nbPoints_ = JsonUtils::fetchValue(_config_, "nbPoints", _nbPoints_);
   _parameterSigmaRange_ = JsonUtils::fetchValue(_config_, "parameterSigmaRange", _parameterSigmaRange_);
+  _useParallelScan_ = JsonUtils::fetchValue(_config_, "useParallelScan", _useParallelScan_);
+
+  _twoDimScanList_ = JsonUtils::fetchValue(_config_, "twoDimScanList", _twoDimScanList_);
 
   _varsConfig_ = JsonUtils::fetchValue(_config_, "varsConfig", nlohmann::json());
 }
@@ -32,6 +35,12 @@ const std::pair<double, double> &ScanConfig::getParameterSigmaRange() const {
 bool ScanConfig::isUseParameterLimits() const {
   return _useParameterLimits_;
 }
+bool ScanConfig::isUseParallelScan() const {
+  return _useParallelScan_;
+}
+const nlohmann::json &ScanConfig::getTwoDimScanList() const {
+  return _twoDimScanList_;
+}
 
 const nlohmann::json &ScanConfig::getVarsConfig() const {
   return _varsConfig_;
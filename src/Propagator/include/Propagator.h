@@ -18,6 +18,7 @@
 
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <future>
 
 class Propagator {
@@ -57,6 +58,9 @@ public:
   void refillSampleHistograms();
   void applyResponseFunctions();
 
+  // {iSample, iEvent} of the MC events reweighted by each parameter. Built on demand as it holds one entry per event per parameter.
+  std::unordered_map<const FitParameter*, std::vector<std::pair<size_t, size_t>>> buildParameterEventMap() const;
+
   // Switches
   void preventRfPropagation();
   void allowRfPropagation();
@@ -70,6 +74,8 @@ protected:
   void initializeThreads();
 
   void makeResponseFunctions();
+  void buildParameterSampleMasks();
+  void updateSampleUpdateFlags();
 
   // multi-threaded
   void updateDialResponses(int iThread_);
@@ -100,6 +106,25 @@ private:
   // Monitoring
   bool _showEventBreakdown_{true};
 
+  // Data container of Asimov fits: "copy" the MC events, "reference" them with frozen weights,
+  // keep the "histogram" only, or "auto" (reference if data plots are requested, histogram otherwise)
+  std::string _asimovDataContainer_{"auto"};
+
+  // Real data: once binned, keep the histogram and the variables of the data plots only
+  bool _compactDataContainers_{false};
+
+  // Once binned, keep the plotted leaves as dense columns and pack the others in compressed blocks of events
+  bool _packEventLeaves_{false};
+  int _leavesCompressionSettings_{404}; // algorithm*100 + level
+
+  // Per-parameter sample masks: only the samples touched by the moved parameters are reweighted/refilled
+  bool _useParameterSampleMasks_{true};
+  bool _isLastPropagatedStateValid_{false};
+  std::vector<const FitParameter*> _maskedParameterList_;
+  std::vector<double> _lastPropagatedValueList_; // [iPar]
+  std::vector<std::vector<char>> _parameterSampleMaskList_; // [iPar][iSample]
+  std::vector<char> _sampleUpdateFlagList_; // [iSample]
+
   // Response functions (WIP)
   std::map<FitSample*, std::shared_ptr<TH1D>> _nominalSamplesMcHistogram_;
   std::map<FitSample*, std::vector<std::shared_ptr<TH1D>>> _responseFunctionsSamplesMcHistogram_;
@@ -10,6 +10,7 @@
 
 #include "FitParameterSet.h"
 #include "Dial.h"
+#include "DialRegistry.h"
 #include "JsonUtils.h"
 #include "GlobalVariables.h"
 
@@ -19,6 +20,8 @@
 
 #include <memory>
 #include <vector>
+#include <unordered_map>
+#include <algorithm>
 
 LoggerInit([]{
   Logger::setUserHeaderStr("[Propagator]");
@@ -30,6 +33,7 @@ Propagator::~Propagator() { this->reset(); }
 void Propagator::reset() {
   _isInitialized_ = false;
   _parameterSetsList_.clear();
+  DialRegistry::reset(); // the registered dials were owned by the parameter sets
   _saveDir_ = nullptr;
 
   std::vector<std::string> jobNameRemoveList;
@@ -76,6 +80,14 @@ void Propagator::initialize() {
 
   // Monitoring parameters
   _showEventBreakdown_ = JsonUtils::fetchValue(_config_, "showEventBreakdown", _showEventBreakdown_);
+  _useParameterSampleMasks_ = JsonUtils::fetchValue(_config_, "useParameterSampleMasks", _useParameterSampleMasks_);
+  _asimovDataContainer_ = JsonUtils::fetchValue(_config_, "asimovDataContainer", _asimovDataContainer_);
+  LogThrowIf(not GenericToolbox::doesElementIsInVector(_asimovDataContainer_, std::vector<std::string>{"auto", "copy", "reference", "histogram"}),
+             "Unknown asimovDataContainer: " << _asimovDataContainer_);
+  _compactDataContainers_ = JsonUtils::fetchValue(_config_, "compactDataContainers", _compactDataContainers_);
+  _packEventLeaves_ = JsonUtils::fetchValue(_config_, "packEventLeaves", _packEventLeaves_);
+  _leavesCompressionSettings_ = JsonUtils::fetchValue(_config_, "leavesCompressionSettings", _leavesCompressionSettings_);
+  Dial::useResponseKernels = JsonUtils::fetchValue(_config_, "useDialResponseKernels", Dial::useResponseKernels);
 
   LogInfo << std::endl << GenericToolbox::addUpDownBars("Initializing parameters...") << std::endl;
   auto parameterSetListConfig = JsonUtils::fetchValue(_config_, "parameterSetListConfig", nlohmann::json());
@@ -113,6 +125,7 @@ void Propagator::initialize() {
   auto fitSampleSetConfig = JsonUtils::fetchValue(_config_, "fitSampleSetConfig", nlohmann::json());
   _fitSampleSet_.setConfig(fitSampleSetConfig);
   _fitSampleSet_.initialize();
+  _sampleUpdateFlagList_.resize(_fitSampleSet_.getFitSampleList().size(), true);
 
   LogInfo << std::endl << GenericToolbox::addUpDownBars("Initializing the plot generator") << std::endl;
   auto plotGeneratorConfig = JsonUtils::fetchValue(_config_, "plotGeneratorConfig", nlohmann::json());
@@ -179,9 +192,16 @@ void Propagator::initialize() {
     LogInfo << "Propagating prior parameters on events..." << std::endl;
     this->reweightMcEvents();
 
-    // Copies MC events in data container for both Asimov and FakeData event types
-    LogWarning << "Copying loaded mc-like event to data container..." << std::endl;
-    _fitSampleSet_.copyMcEventListToDataContainer();
+    if( allAsimov and _asimovDataContainer_ != "copy" ){
+      // The MC events stay loaded: the data container only needs their current weights
+      LogWarning << "Referencing loaded mc-like event in data container..." << std::endl;
+      _fitSampleSet_.referenceMcEventListInDataContainer( _asimovDataContainer_ == "histogram" ); // "auto" decided once the plots are defined
+    }
+    else{
+      // Copies MC events in data container for both Asimov and FakeData event types
+      LogWarning << "Copying loaded mc-like event to data container..." << std::endl;
+      _fitSampleSet_.copyMcEventListToDataContainer();
+    }
 
     // back to prior
     if( _throwAsimovToyParameters_ ){
@@ -193,6 +213,10 @@ void Propagator::initialize() {
 
   if( not allAsimov ){
     // reload everything
+    // The dials are registered again while loading: the data events (not reweighted) drop their ids with the registry
+    for( auto& sample : _fitSampleSet_.getFitSampleList() ){ sample.getDataContainer().releaseDialMemory(); }
+    DialRegistry::reset();
+
     // Filling the mc containers
     _fitSampleSet_.clearMcContainers();
     for( auto& dataSet : _dataSetList_ ){
@@ -317,12 +341,59 @@ void Propagator::initialize() {
   LogInfo << "Filling up sample histograms..." << std::endl;
   _fitSampleSet_.updateSampleHistograms();
 
+  // Variables of the data plots: the only ones the compacted data containers keep
+  bool hasDataPlots = std::any_of(_plotGenerator_.getHistHolderList().begin(), _plotGenerator_.getHistHolderList().end(),
+                                  [](const HistHolder& h_){ return h_.isData; });
+  std::vector<std::string> dataPlotVarList;
+  if( _compactDataContainers_ ){
+    for( auto& varName : _plotGenerator_.fetchListOfVarToPlot(true) ){
+      if( not GenericToolbox::doesElementIsInVector(varName, dataPlotVarList) ){ dataPlotVarList.emplace_back(varName); }
+    }
+    for( auto& varName : _plotGenerator_.fetchListOfSplitVarNames() ){
+      if( not GenericToolbox::doesElementIsInVector(varName, dataPlotVarList) ){ dataPlotVarList.emplace_back(varName); }
+    }
+  }
+
   // Now the data won't be refilled each time
   for( auto& sample : _fitSampleSet_.getFitSampleList() ){
-    if( _throwAsimovToyParameters_ and _enableStatThrowInToys_ ){ sample.getDataContainer().throwStatError(); }
-    sample.getDataContainer().isLocked = true;
+    auto& dataContainer = sample.getDataContainer();
+    if( _throwAsimovToyParameters_ and _enableStatThrowInToys_ ){ dataContainer.throwStatError(); }
+    dataContainer.isLocked = true;
+
+    if( dataContainer.isReferencingEvents() ){
+      if( _asimovDataContainer_ == "auto" and not hasDataPlots ){ dataContainer.isHistogramOnly = true; }
+    }
+    else if( _compactDataContainers_ ){
+      if( not hasDataPlots ){ dataContainer.isHistogramOnly = true; }
+      else{
+        LogInfo << "Compacting the data events of \"" << sample.getName() << "\": " << dataContainer.eventList.size()
+                << " events, " << dataPlotVarList.size() << " variables kept" << std::endl;
+        dataContainer.compactEvents(dataPlotVarList);
+      }
+    }
+
+    if( dataContainer.isHistogramOnly ){
+      LogInfo << "Keeping the data histogram of \"" << sample.getName() << "\" only (" << dataContainer.getNbEvents() << " events dropped)" << std::endl;
+      dataContainer.dropEvents();
+    }
   }
 
+  if( _packEventLeaves_ ){
+    // the fit only reads the weights and bins of the events: the leaves are only used by the plots and the trees
+    auto hotVarList = _plotGenerator_.fetchRequestedLeafNames();
+    for( auto& sample : _fitSampleSet_.getFitSampleList() ){
+      for( auto* container : { &sample.getMcContainer(), &sample.getDataContainer() } ){
+        if( container->isUsingFrozenColumns() or container->eventList.empty() ){ continue; }
+        container->packLeaves(hotVarList, _leavesCompressionSettings_);
+        LogInfo << "Packed the leaves of \"" << container->name << "\": " << container->compactVarNameList.size() << " hot variables, "
+                << container->leafBlockList.size() << " blocks of cold leaves ("
+                << GenericToolbox::parseSizeUnits(double(container->getPackedLeavesSize())) << ")" << std::endl;
+      }
+    }
+  }
+
+  if( _useParameterSampleMasks_ ){ this->buildParameterSampleMasks(); }
+
   _useResponseFunctions_ = JsonUtils::fetchValue<nlohmann::json>(_config_, "DEV_useResponseFunctions", false);
   if( _useResponseFunctions_ ){ this->makeResponseFunctions(); }
 
@@ -376,8 +447,14 @@ void Propagator::propagateParametersOnSamples(){
 
   if(not _useResponseFunctions_ or not _isRfPropagationEnabled_ ){
 //    if(GlobalVariables::isEnableDevMode()) updateDialResponses();
+    if( _useParameterSampleMasks_ ){ this->updateSampleUpdateFlags(); }
     reweightMcEvents();
     refillSampleHistograms();
+    if( _useParameterSampleMasks_ ){
+      // direct calls of reweightMcEvents() / refillSampleHistograms() are always processing every sample
+      std::fill(_sampleUpdateFlagList_.begin(), _sampleUpdateFlagList_.end(), true);
+      _isLastPropagatedStateValid_ = true;
+    }
   }
   else{
     applyResponseFunctions();
@@ -390,6 +467,7 @@ void Propagator::updateDialResponses(){
   dialUpdate.counts++; dialUpdate.cumulated += GenericToolbox::getElapsedTimeSinceLastCallInMicroSeconds(__METHOD_NAME__);
 }
 void Propagator::reweightMcEvents() {
+  _isLastPropagatedStateValid_ = false;
   bool usedGPU{false};
 #ifdef GUNDAM_USING_CACHE_MANAGER
 #ifdef DUMP_PARAMETERS
@@ -425,14 +503,17 @@ void Propagator::reweightMcEvents() {
 }
 
 void Propagator::refillSampleHistograms(){
+  _isLastPropagatedStateValid_ = false;
   GenericToolbox::getElapsedTimeSinceLastCallInMicroSeconds(__METHOD_NAME__);
   GlobalVariables::getParallelWorker().runJob("Propagator::refillSampleHistograms");
   fillProp.counts++; fillProp.cumulated += GenericToolbox::getElapsedTimeSinceLastCallInMicroSeconds(__METHOD_NAME__);
 }
 
 void Propagator::applyResponseFunctions(){
+  _isLastPropagatedStateValid_ = false;
   GenericToolbox::getElapsedTimeSinceLastCallInMicroSeconds(__METHOD_NAME__);
   GlobalVariables::getParallelWorker().runJob("Propagator::applyResponseFunctions");
+  for( auto& sample : _fitSampleSet_.getFitSampleList() ){ sample.getMcContainer().histogramVersion++; }
   applyRf.counts++; applyRf.cumulated += GenericToolbox::getElapsedTimeSinceLastCallInMicroSeconds(__METHOD_NAME__);
 }
 
@@ -480,15 +561,17 @@ void Propagator::initializeThreads() {
 
 
   std::function<void(int)> refillSampleHistogramsFct = [this](int iThread){
-    for( auto& sample : _fitSampleSet_.getFitSampleList() ){
-      sample.getMcContainer().refillHistogram(iThread);
-      sample.getDataContainer().refillHistogram(iThread);
+    for( size_t iSample = 0 ; iSample < _fitSampleSet_.getFitSampleList().size() ; iSample++ ){
+      if( not _sampleUpdateFlagList_[iSample] ) continue;
+      _fitSampleSet_.getFitSampleList()[iSample].getMcContainer().refillHistogram(iThread);
+      _fitSampleSet_.getFitSampleList()[iSample].getDataContainer().refillHistogram(iThread);
     }
   };
   std::function<void()> refillSampleHistogramsPostParallelFct = [this](){
-    for( auto& sample : _fitSampleSet_.getFitSampleList() ){
-      sample.getMcContainer().rescaleHistogram();
-      sample.getDataContainer().rescaleHistogram();
+    for( size_t iSample = 0 ; iSample < _fitSampleSet_.getFitSampleList().size() ; iSample++ ){
+      if( not _sampleUpdateFlagList_[iSample] ) continue;
+      _fitSampleSet_.getFitSampleList()[iSample].getMcContainer().rescaleHistogram();
+      _fitSampleSet_.getFitSampleList()[iSample].getDataContainer().rescaleHistogram();
     }
   };
   GlobalVariables::getParallelWorker().addJob("Propagator::refillSampleHistograms", refillSampleHistogramsFct);
@@ -562,6 +645,79 @@ void Propagator::makeResponseFunctions(){
   LogInfo << "RF built" << std::endl;
 }
 
+std::unordered_map<const FitParameter*, std::vector<std::pair<size_t, size_t>>> Propagator::buildParameterEventMap() const{
+  LogInfo << "Mapping the parameters to the events they reweight..." << std::endl;
+  std::unordered_map<const FitParameter*, std::vector<std::pair<size_t, size_t>>> out;
+
+  const auto& sampleList = _fitSampleSet_.getFitSampleList();
+  for( size_t iSample = 0 ; iSample < sampleList.size() ; iSample++ ){
+    const auto& eventList = sampleList[iSample].getMcContainer().eventList;
+    for( size_t iEvent = 0 ; iEvent < eventList.size() ; iEvent++ ){
+      for( auto* dialPtr : eventList[iEvent].getRawDialPtrList() ){
+        if( dialPtr == nullptr ) break;
+        if( dialPtr->getOwner() == nullptr or dialPtr->getOwner()->getOwner() == nullptr ) continue;
+        auto& parEventList = out[dialPtr->getOwner()->getOwner()];
+        if( parEventList.empty() or parEventList.back() != std::make_pair(iSample, iEvent) ){ parEventList.emplace_back(iSample, iEvent); }
+      }
+    }
+  }
+
+  return out;
+}
+void Propagator::buildParameterSampleMasks(){
+  LogInfo << "Building per-parameter sample masks..." << std::endl;
+
+  std::unordered_map<const FitParameter*, size_t> parIndexDict;
+  _maskedParameterList_.clear();
+  for( auto& parSet : _parameterSetsList_ ){
+    for( auto& par : parSet.getParameterList() ){
+      parIndexDict[&par] = _maskedParameterList_.size();
+      _maskedParameterList_.emplace_back(&par);
+    }
+  }
+
+  size_t nSamples = _fitSampleSet_.getFitSampleList().size();
+  _parameterSampleMaskList_.clear();
+  _parameterSampleMaskList_.resize(_maskedParameterList_.size(), std::vector<char>(nSamples, false));
+
+  const FitParameter* lastParPtr{nullptr};
+  for( size_t iSample = 0 ; iSample < nSamples ; iSample++ ){
+    for( auto& event : _fitSampleSet_.getFitSampleList()[iSample].getMcContainer().eventList ){
+      for( auto* dialPtr : event.getRawDialPtrList() ){
+        if( dialPtr == nullptr ) break;
+        if( dialPtr->getOwner() == nullptr or dialPtr->getOwner()->getOwner() == nullptr ) continue;
+        if( dialPtr->getOwner()->getOwner() == lastParPtr ) continue; // consecutive dials often share the same par
+        lastParPtr = dialPtr->getOwner()->getOwner();
+        _parameterSampleMaskList_[parIndexDict.at(lastParPtr)][iSample] = true;
+      }
+    }
+    lastParPtr = nullptr;
+  }
+
+  size_t nLinks{0};
+  for( auto& mask : _parameterSampleMaskList_ ){ nLinks += std::count(mask.begin(), mask.end(), true); }
+  LogInfo << _maskedParameterList_.size() << " parameters are linked to " << nLinks << " samples in total ("
+  << nSamples << " samples)." << std::endl;
+
+  _lastPropagatedValueList_.clear();
+  _lastPropagatedValueList_.resize(_maskedParameterList_.size(), std::nan("unset"));
+  _isLastPropagatedStateValid_ = false;
+}
+void Propagator::updateSampleUpdateFlags(){
+  // Dial masks can be changed without any parameter value being moved
+  bool isFullUpdate{not _isLastPropagatedStateValid_ or Dial::enableMaskCheck or _maskedParameterList_.empty()};
+  std::fill(_sampleUpdateFlagList_.begin(), _sampleUpdateFlagList_.end(), isFullUpdate);
+
+  for( size_t iPar = 0 ; iPar < _maskedParameterList_.size() ; iPar++ ){
+    if( _maskedParameterList_[iPar]->getParameterValue() == _lastPropagatedValueList_[iPar] ) continue;
+    _lastPropagatedValueList_[iPar] = _maskedParameterList_[iPar]->getParameterValue();
+    if( isFullUpdate ) continue;
+    for( size_t iSample = 0 ; iSample < _sampleUpdateFlagList_.size() ; iSample++ ){
+      if( _parameterSampleMaskList_[iPar][iSample] ){ _sampleUpdateFlagList_[iSample] = true; }
+    }
+  }
+}
+
 void Propagator::updateDialResponses(int iThread_){
   int nThreads = GlobalVariables::getNbThreads();
   if(iThread_ == -1){
@@ -595,6 +751,7 @@ void Propagator::reweightMcEvents(int iThread_) {
     _fitSampleSet_.getFitSampleList().begin(), _fitSampleSet_.getFitSampleList().end(),
     [&](auto& s){
       if( s.getMcContainer().eventList.empty() ) return;
+      if( not _sampleUpdateFlagList_[&s - &_fitSampleSet_.getFitSampleList()[0]] ) return;
       nToProcess = long(s.getMcContainer().eventList.size())/nThreads;
       offset = iThread_*nToProcess;
       if( iThread_+1==nThreads ) nToProcess += long(s.getMcContainer().eventList.size())%nThreads;
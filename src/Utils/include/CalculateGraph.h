@@ -0,0 +1,85 @@
+//
+// CalculateGraph.h
+//
+
+#ifndef CALCULATE_GRAPH_H_SEEN
+#define CALCULATE_GRAPH_H_SEEN
+// Calculate a graph (linear interpolation between points).  This adds a
+// function that can be called from CPU (with c++), or a GPU (with CUDA).  It
+// gives the same result as TGraph::Eval, without the virtual calls.
+
+// Wrap the CUDA compiler attributes into a definition.  When this is compiled
+// with a CUDA compiler __CUDACC__ will be defined.  In that case, the code
+// will be compiled with cuda attributes for both the host (i.e. __host__) and
+// gpu (i.e. __device__).  If it's compiled with a normal C compiler, this is
+// compiled as inline.
+#ifndef DEVICE_CALLABLE_INLINE
+#ifdef __CUDACC__
+// This is used with a cuda compiler (i.e. nvcc)
+#define DEVICE_CALLABLE_INLINE __host__ __device__ inline
+#else
+// This is used for a non-cuda compiler
+#define DEVICE_CALLABLE_INLINE /* __host__ __device__ inline */
+#endif
+#endif
+
+// Allow the floating point type to be overriden.  This would normally be done
+// using a typedef, but that doesn't play well with the CUDA compiler.
+#ifndef DEVICE_FLOATING_POINT
+#define DEVICE_FLOATING_POINT double
+#endif
+
+// Place in a private name space so it plays nicely with CUDA
+namespace {
+    // Interpolate one point of a graph.  The segment is found by bisection,
+    // so there is no limit on the number of points.
+    //
+    // This takes the parameter value, a minimum and maximum bound, the
+    // buffer of data for this graph, and the number of data elements in the
+    // graph data.  The input data is arrange as
+    //
+    // data[0] -- 1 if the graph is linearly extrapolated past its end points,
+    //            0 if it is flat
+    // data[1+2*n+0] -- The function value for point n
+    // data[1+2*n+1] -- The place of point n
+    DEVICE_CALLABLE_INLINE
+    double CalculateGraph(double x,
+                          const double lowerBound, double upperBound,
+                          const DEVICE_FLOATING_POINT* data,
+                          const int dim) {
+
+        const int pointCount = (dim-1)/2;
+        if (pointCount < 2) return data[1];
+
+        if (data[0] < 0.5) {
+            if (x < data[1+1]) x = data[1+1];
+            if (x > data[1+2*(pointCount-1)+1]) {
+                x = data[1+2*(pointCount-1)+1];
+            }
+        }
+
+        // Find the segment holding x.  Outside of the graph, the first or
+        // last segment is used (like TGraph::Eval).
+        int low = 0;
+        int high = pointCount-1;
+        while (high - low > 1) {
+            const int middle = (low+high)/2;
+            if (x < data[1+2*middle+1]) high = middle;
+            else low = middle;
+        }
+
+        const double x1 = data[1+2*low+1];
+        const double x2 = data[1+2*high+1];
+        const double y1 = data[1+2*low];
+        const double y2 = data[1+2*high];
+
+        double v = y1;
+        if (x2 != x1) v = y1 + (x-x1)*(y2-y1)/(x2-x1);
+
+        if (v < lowerBound) v = lowerBound;
+        if (v > upperBound) v = upperBound;
+
+        return v;
+    }
+}
+#endif
@@ -0,0 +1,124 @@
+//
+// CompiledFormula.h
+//
+
+#ifndef GUNDAM_COMPILEDFORMULA_H
+#define GUNDAM_COMPILEDFORMULA_H
+
+#include "vector"
+#include "string"
+#include "cmath"
+#include "algorithm"
+
+
+// Stack bytecode for the TFormula-like expressions of the configs: numbers, "[name]" parameters, x/y/z/t or x[i]
+// variables, arithmetic, comparison and logic operators, and the common math functions. Once the parameters are bound
+// to column indexes, evaluating does no allocation and no string lookup. Anything else is reported as not valid, so
+// the caller can keep the TFormula (or TTreeFormula).
+class CompiledFormula {
+
+public:
+  enum class OpCode : unsigned char {
+    Constant, Load,
+    Negate, Not,
+    Add, Subtract, Multiply, Divide, Modulo, Power,
+    TreeDivide, TreeModulo, // TTreeFormula: x/0 = 0, % on the Long64_t casts
+    Less, LessEqual, Greater, GreaterEqual, Equal, NotEqual, And, Or,
+    Abs, Sqrt, Exp, Log, Log10, Sin, Cos, Tan, Min, Max
+  };
+  struct Instruction{
+    OpCode opCode{OpCode::Constant};
+    int slot{-1};       // Load: parameter or variable index in the expression
+    int index{-1};      // Load: index handed to the loader (= slot until bound)
+    double value{0};    // Constant
+  };
+
+  static const int maxStackSize{64};
+
+  static double treeDivide(double a_, double b_){ return ( b_ == 0 ? 0 : a_ / b_ ); }
+  static double treeModulo(double a_, double b_){
+    auto b = static_cast<long long>(b_);
+    return ( b == 0 ? 0 : double(static_cast<long long>(a_) % b) );
+  }
+
+public:
+  CompiledFormula() = default;
+  explicit CompiledFormula(const std::string& expression_, bool bareNamesAreParameters_ = false){ this->compile(expression_, bareNamesAreParameters_); }
+
+  // Returns false if the expression uses a construct which is not handled (see getErrorMessage())
+  // bareNamesAreParameters_: TTreeFormula syntax, the leaf names are written without brackets
+  bool compile(const std::string& expression_, bool bareNamesAreParameters_ = false);
+
+  // The "[name]" parameters will be loaded from these indexes, given in the order of getParameterNameList()
+  void bindParameters(const std::vector<int>& indexList_);
+
+  bool isValid() const { return _isValid_; }
+  const std::string& getExpression() const { return _expression_; }
+  const std::string& getErrorMessage() const { return _errorMessage_; }
+  const std::vector<std::string>& getParameterNameList() const { return _parameterNameList_; }
+  int getNbVariables() const { return _nbVariables_; }
+
+  // loader_(index) returns the value of the bound parameter, or of the variable x[index]
+  template<typename Loader> double eval(const Loader& loader_) const;
+  double evalValues(const double* valueList_) const { return this->eval([valueList_](int index_){ return valueList_[index_]; }); }
+
+  // Column-wise evaluation of nRows_ entries: each instruction runs as one loop over the rows. columnList_[index] holds
+  // the values of the bound index, buffer_ is the scratch space of the stack (kept by the caller to be reused).
+  void evalColumns(size_t nRows_, const double* const* columnList_, std::vector<double>& buffer_, double* output_) const;
+
+private:
+  bool _isValid_{false};
+  std::string _expression_{};
+  std::string _errorMessage_{};
+  std::vector<std::string> _parameterNameList_{};
+  int _nbVariables_{0};
+  int _maxStackDepth_{0};
+  std::vector<Instruction> _instructionList_{};
+
+};
+
+
+template<typename Loader> double CompiledFormula::eval(const Loader& loader_) const{
+  double stack[maxStackSize];
+  int top{-1};
+
+  for( const auto& instruction : _instructionList_ ){
+    switch( instruction.opCode ){
+      case OpCode::Constant:     stack[++top] = instruction.value; break;
+      case OpCode::Load:         stack[++top] = loader_(instruction.index); break;
+      case OpCode::Negate:       stack[top] = -stack[top]; break;
+      case OpCode::Not:          stack[top] = ( stack[top] == 0 ); break;
+      case OpCode::Abs:          stack[top] = std::abs(stack[top]); break;
+      case OpCode::Sqrt:         stack[top] = std::sqrt(stack[top]); break;
+      case OpCode::Exp:          stack[top] = std::exp(stack[top]); break;
+      case OpCode::Log:          stack[top] = std::log(stack[top]); break;
+      case OpCode::Log10:        stack[top] = std::log10(stack[top]); break;
+      case OpCode::Sin:          stack[top] = std::sin(stack[top]); break;
+      case OpCode::Cos:          stack[top] = std::cos(stack[top]); break;
+      case OpCode::Tan:          stack[top] = std::tan(stack[top]); break;
+      case OpCode::Add:          top--; stack[top] = stack[top] + stack[top+1]; break;
+      case OpCode::Subtract:     top--; stack[top] = stack[top] - stack[top+1]; break;
+      case OpCode::Multiply:     top--; stack[top] = stack[top] * stack[top+1]; break;
+      case OpCode::Divide:       top--; stack[top] = stack[top] / stack[top+1]; break;
+      case OpCode::Modulo:       top--; stack[top] = std::fmod(stack[top], stack[top+1]); break;
+      case OpCode::TreeDivide:   top--; stack[top] = treeDivide(stack[top], stack[top+1]); break;
+      case OpCode::TreeModulo:   top--; stack[top] = treeModulo(stack[top], stack[top+1]); break;
+      case OpCode::Power:        top--; stack[top] = std::pow(stack[top], stack[top+1]); break;
+      case OpCode::Less:         top--; stack[top] = ( stack[top] < stack[top+1] ); break;
+      case OpCode::LessEqual:    top--; stack[top] = ( stack[top] <= stack[top+1] ); break;
+      case OpCode::Greater:      top--; stack[top] = ( stack[top] > stack[top+1] ); break;
+      case OpCode::GreaterEqual: top--; stack[top] = ( stack[top] >= stack[top+1] ); break;
+      case OpCode::Equal:        top--; stack[top] = ( stack[top] == stack[top+1] ); break;
+      case OpCode::NotEqual:     top--; stack[top] = ( stack[top] != stack[top+1] ); break;
+      case OpCode::And:          top--; stack[top] = ( stack[top] != 0 and stack[top+1] != 0 ); break;
+      case OpCode::Or:           top--; stack[top] = ( stack[top] != 0 or stack[top+1] != 0 ); break;
+      case OpCode::Min:          top--; stack[top] = std::min(stack[top], stack[top+1]); break;
+      case OpCode::Max:          top--; stack[top] = std::max(stack[top], stack[top+1]); break;
+    }
+  }
+
+  return stack[0];
+}
+
+
+#endif //GUNDAM_COMPILEDFORMULA_H
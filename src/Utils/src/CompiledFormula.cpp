@@ -0,0 +1,347 @@
+//
+// CompiledFormula.cpp
+//
+
+#include "CompiledFormula.h"
+
+#include "Logger.h"
+
+#include "cstdlib"
+#include "cctype"
+#include "sstream"
+#include "stdexcept"
+#include "map"
+
+LoggerInit([]{
+  Logger::setUserHeaderStr("[CompiledFormula]");
+});
+
+
+namespace {
+
+  // Recursive descent parser emitting the bytecode in reverse polish order. Precedence follows TFormula, from the
+  // loosest: ||, &&, == !=, < <= > >=, + -, * / %, unary - + !, ^
+  class FormulaParser{
+
+  public:
+    FormulaParser(const std::string& expression_, bool bareNamesAreParameters_,
+                  std::vector<CompiledFormula::Instruction>& instructionList_,
+                  std::vector<std::string>& parameterNameList_, int& nbVariables_, int& maxStackDepth_):
+        _str_(expression_), _bareNamesAreParameters_(bareNamesAreParameters_), _instructionList_(instructionList_),
+        _parameterNameList_(parameterNameList_), _nbVariables_(nbVariables_), _maxStackDepth_(maxStackDepth_) {}
+
+    void parse(){
+      this->parseOr();
+      this->skipSpaces();
+      if( _pos_ != _str_.size() ){ this->fail("unexpected character"); }
+      if( not _parameterNameList_.empty() and _nbVariables_ != 0 ){ this->fail("parameters and variables can't be mixed"); }
+    }
+
+  private:
+    void fail(const std::string& reason_) const {
+      std::stringstream ss;
+      ss << reason_ << " at position " << _pos_;
+      throw std::runtime_error(ss.str());
+    }
+    void skipSpaces(){ while( _pos_ < _str_.size() and std::isspace(static_cast<unsigned char>(_str_[_pos_])) ){ _pos_++; } }
+    bool accept(const char* token_){
+      this->skipSpaces();
+      size_t length = std::char_traits<char>::length(token_);
+      if( _str_.compare(_pos_, length, token_) != 0 ){ return false; }
+      _pos_ += length;
+      return true;
+    }
+    void expect(const char* token_){ if( not this->accept(token_) ){ this->fail(std::string("expected \"") + token_ + "\""); } }
+
+    void emit(CompiledFormula::OpCode opCode_, int nbPopped_, int slot_ = -1, double value_ = 0){
+      CompiledFormula::Instruction instruction;
+      instruction.opCode = opCode_;
+      instruction.slot = slot_;
+      instruction.index = slot_;
+      instruction.value = value_;
+      _instructionList_.emplace_back(instruction);
+
+      _stackSize_ += 1 - nbPopped_;
+      if( _stackSize_ > CompiledFormula::maxStackSize ){ this->fail("expression too deep"); }
+      _maxStackDepth_ = std::max(_maxStackDepth_, _stackSize_);
+    }
+
+    void emitParameter(const std::string& name_){
+      int slot{0};
+      while( slot < int(_parameterNameList_.size()) and _parameterNameList_[slot] != name_ ){ slot++; }
+      if( slot == int(_parameterNameList_.size()) ){ _parameterNameList_.emplace_back(name_); }
+      this->emit(CompiledFormula::OpCode::Load, 0, slot);
+    }
+
+    void parseOr(){
+      this->parseAnd();
+      while( this->accept("||") ){ this->parseAnd(); this->emit(CompiledFormula::OpCode::Or, 2); }
+    }
+    void parseAnd(){
+      this->parseEquality();
+      while( this->accept("&&") ){ this->parseEquality(); this->emit(CompiledFormula::OpCode::And, 2); }
+    }
+    void parseEquality(){
+      this->parseComparison();
+      while( true ){
+        if     ( this->accept("==") ){ this->parseComparison(); this->emit(CompiledFormula::OpCode::Equal, 2); }
+        else if( this->accept("!=") ){ this->parseComparison(); this->emit(CompiledFormula::OpCode::NotEqual, 2); }
+        else{ break; }
+      }
+    }
+    void parseComparison(){
+      this->parseAdditive();
+      while( true ){
+        if     ( this->accept("<=") ){ this->parseAdditive(); this->emit(CompiledFormula::OpCode::LessEqual, 2); }
+        else if( this->accept(">=") ){ this->parseAdditive(); this->emit(CompiledFormula::OpCode::GreaterEqual, 2); }
+        else if( this->accept("<") ) { this->parseAdditive(); this->emit(CompiledFormula::OpCode::Less, 2); }
+        else if( this->accept(">") ) { this->parseAdditive(); this->emit(CompiledFormula::OpCode::Greater, 2); }
+        else{ break; }
+      }
+    }
+    void parseAdditive(){
+      this->parseMultiplicative();
+      while( true ){
+        if     ( this->accept("+") ){ this->parseMultiplicative(); this->emit(CompiledFormula::OpCode::Add, 2); }
+        else if( this->accept("-") ){ this->parseMultiplicative(); this->emit(CompiledFormula::OpCode::Subtract, 2); }
+        else{ break; }
+      }
+    }
+    void parseMultiplicative(){
+      this->parseUnary();
+      while( true ){
+        if     ( this->accept("*") ){ this->parseUnary(); this->emit(CompiledFormula::OpCode::Multiply, 2); }
+        else if( this->accept("/") ){
+          this->parseUnary();
+          this->emit(_bareNamesAreParameters_ ? CompiledFormula::OpCode::TreeDivide : CompiledFormula::OpCode::Divide, 2);
+        }
+        else if( this->accept("%") ){
+          this->parseUnary();
+          this->emit(_bareNamesAreParameters_ ? CompiledFormula::OpCode::TreeModulo : CompiledFormula::OpCode::Modulo, 2);
+        }
+        else{ break; }
+      }
+    }
+    void parseUnary(){
+      if( this->accept("-") ){ this->parseUnary(); this->emit(CompiledFormula::OpCode::Negate, 1); return; }
+      if( this->accept("+") ){ this->parseUnary(); return; }
+      this->skipSpaces();
+      if( _str_.compare(_pos_, 2, "!=") != 0 and this->accept("!") ){ this->parseUnary(); this->emit(CompiledFormula::OpCode::Not, 1); return; }
+      this->parsePower();
+    }
+    void parsePower(){
+      this->parsePrimary();
+      if( this->accept("^") ){ this->parseUnary(); this->emit(CompiledFormula::OpCode::Power, 2); }
+    }
+
+    void parsePrimary(){
+      this->skipSpaces();
+      if( _pos_ == _str_.size() ){ this->fail("unexpected end of expression"); }
+
+      char c = _str_[_pos_];
+      if( c == '(' ){
+        _pos_++;
+        this->parseOr();
+        this->expect(")");
+      }
+      else if( c == '[' ){
+        // parameter, bound to a column later
+        size_t end = _str_.find(']', _pos_);
+        if( end == std::string::npos ){ this->fail("unterminated parameter name"); }
+        std::string name = _str_.substr(_pos_ + 1, end - _pos_ - 1);
+        _pos_ = end + 1;
+        this->emitParameter(name);
+      }
+      else if( std::isdigit(static_cast<unsigned char>(c)) or c == '.' ){
+        const char* begin = _str_.c_str() + _pos_;
+        char* end{nullptr};
+        double value = std::strtod(begin, &end);
+        if( end == begin ){ this->fail("invalid number"); }
+        _pos_ += size_t(end - begin);
+        this->emit(CompiledFormula::OpCode::Constant, 0, -1, value);
+      }
+      else if( std::isalpha(static_cast<unsigned char>(c)) or c == '_' ){
+        this->parseIdentifier();
+      }
+      else{
+        this->fail("unexpected character");
+      }
+    }
+
+    void parseIdentifier(){
+      size_t begin = _pos_;
+      while( _pos_ < _str_.size() ){
+        if( std::isalnum(static_cast<unsigned char>(_str_[_pos_])) or _str_[_pos_] == '_' ){ _pos_++; }
+        else if( _str_.compare(_pos_, 2, "::") == 0 ){ _pos_ += 2; }
+        else{ break; }
+      }
+      std::string name = _str_.substr(begin, _pos_ - begin);
+      this->skipSpaces();
+      bool isCall = ( _pos_ < _str_.size() and _str_[_pos_] == '(' );
+
+      // leaf names
+      if( _bareNamesAreParameters_ and not isCall and name != "pi" ){
+        if( _pos_ < _str_.size() and ( _str_[_pos_] == '[' or _str_[_pos_] == '.' ) ){ this->fail("arrays and objects are not handled"); }
+        this->emitParameter(name);
+        return;
+      }
+
+      // variables
+      static const std::map<std::string, int> variableIndexDict{{"x", 0}, {"y", 1}, {"z", 2}, {"t", 3}};
+      if( variableIndexDict.find(name) != variableIndexDict.end() ){
+        int index = variableIndexDict.at(name);
+        if( name == "x" and this->accept("[") ){
+          this->skipSpaces();
+          const char* numBegin = _str_.c_str() + _pos_;
+          char* numEnd{nullptr};
+          index = int(std::strtol(numBegin, &numEnd, 10));
+          if( numEnd == numBegin or index < 0 ){ this->fail("invalid variable index"); }
+          _pos_ += size_t(numEnd - numBegin);
+          this->expect("]");
+        }
+        _nbVariables_ = std::max(_nbVariables_, index + 1);
+        this->emit(CompiledFormula::OpCode::Load, 0, index);
+        return;
+      }
+
+      // constants
+      if( name == "pi" or name == "TMath::Pi" ){
+        if( name == "TMath::Pi" ){ this->expect("("); this->expect(")"); }
+        this->emit(CompiledFormula::OpCode::Constant, 0, -1, M_PI);
+        return;
+      }
+
+      // functions
+      static const std::map<std::string, std::pair<CompiledFormula::OpCode, int>> functionDict{
+          {"abs", {CompiledFormula::OpCode::Abs, 1}}, {"fabs", {CompiledFormula::OpCode::Abs, 1}}, {"TMath::Abs", {CompiledFormula::OpCode::Abs, 1}},
+          {"sqrt", {CompiledFormula::OpCode::Sqrt, 1}}, {"TMath::Sqrt", {CompiledFormula::OpCode::Sqrt, 1}},
+          {"exp", {CompiledFormula::OpCode::Exp, 1}}, {"TMath::Exp", {CompiledFormula::OpCode::Exp, 1}},
+          {"log", {CompiledFormula::OpCode::Log, 1}}, {"TMath::Log", {CompiledFormula::OpCode::Log, 1}},
+          {"log10", {CompiledFormula::OpCode::Log10, 1}}, {"TMath::Log10", {CompiledFormula::OpCode::Log10, 1}},
+          {"sin", {CompiledFormula::OpCode::Sin, 1}}, {"TMath::Sin", {CompiledFormula::OpCode::Sin, 1}},
+          {"cos", {CompiledFormula::OpCode::Cos, 1}}, {"TMath::Cos", {CompiledFormula::OpCode::Cos, 1}},
+          {"tan", {CompiledFormula::OpCode::Tan, 1}}, {"TMath::Tan", {CompiledFormula::OpCode::Tan, 1}},
+          {"pow", {CompiledFormula::OpCode::Power, 2}}, {"TMath::Power", {CompiledFormula::OpCode::Power, 2}},
+          {"min", {CompiledFormula::OpCode::Min, 2}}, {"TMath::Min", {CompiledFormula::OpCode::Min, 2}},
+          {"max", {CompiledFormula::OpCode::Max, 2}}, {"TMath::Max", {CompiledFormula::OpCode::Max, 2}},
+      };
+      auto functionIt = functionDict.find(name);
+      if( functionIt == functionDict.end() ){ this->fail("unknown identifier \"" + name + "\""); }
+
+      this->expect("(");
+      for( int iArg = 0 ; iArg < functionIt->second.second ; iArg++ ){
+        if( iArg != 0 ){ this->expect(","); }
+        this->parseOr();
+      }
+      this->expect(")");
+      this->emit(functionIt->second.first, functionIt->second.second);
+    }
+
+  private:
+    const std::string& _str_;
+    bool _bareNamesAreParameters_{false};
+    size_t _pos_{0};
+    int _stackSize_{0};
+    std::vector<CompiledFormula::Instruction>& _instructionList_;
+    std::vector<std::string>& _parameterNameList_;
+    int& _nbVariables_;
+    int& _maxStackDepth_;
+
+  };
+
+}
+
+
+bool CompiledFormula::compile(const std::string& expression_, bool bareNamesAreParameters_){
+  _expression_ = expression_;
+  _errorMessage_.clear();
+  _parameterNameList_.clear();
+  _nbVariables_ = 0;
+  _maxStackDepth_ = 0;
+  _instructionList_.clear();
+  _isValid_ = false;
+
+  try{
+    FormulaParser(
+        _expression_, bareNamesAreParameters_, _instructionList_, _parameterNameList_, _nbVariables_, _maxStackDepth_
+    ).parse();
+    _isValid_ = true;
+  }
+  catch( const std::runtime_error& error_ ){
+    _errorMessage_ = error_.what();
+    _parameterNameList_.clear();
+    _nbVariables_ = 0;
+    _maxStackDepth_ = 0;
+    _instructionList_.clear();
+  }
+
+  return _isValid_;
+}
+
+void CompiledFormula::bindParameters(const std::vector<int>& indexList_){
+  LogThrowIf(not _isValid_, "Can't bind the parameters of an invalid formula: \"" << _expression_ << "\"")
+  LogThrowIf(indexList_.size() != _parameterNameList_.size(),
+             "\"" << _expression_ << "\": " << indexList_.size() << " indexes provided for "
+             << _parameterNameList_.size() << " parameters")
+
+  for( auto& instruction : _instructionList_ ){
+    if( instruction.opCode == OpCode::Load ){ instruction.index = indexList_[instruction.slot]; }
+  }
+}
+
+void CompiledFormula::evalColumns(size_t nRows_, const double* const* columnList_, std::vector<double>& buffer_, double* output_) const{
+  LogThrowIf(not _isValid_, "Can't evaluate an invalid formula: \"" << _expression_ << "\"")
+  if( nRows_ == 0 ){ return; }
+  if( buffer_.size() < size_t(_maxStackDepth_) * nRows_ ){ buffer_.resize(size_t(_maxStackDepth_) * nRows_); }
+
+  int top{-1};
+  auto unary = [&](auto op_){
+    double* a = &buffer_[size_t(top) * nRows_];
+    for( size_t iRow = 0 ; iRow < nRows_ ; iRow++ ){ a[iRow] = op_(a[iRow]); }
+  };
+  auto binary = [&](auto op_){
+    top--;
+    double* a = &buffer_[size_t(top) * nRows_];
+    const double* b = a + nRows_;
+    for( size_t iRow = 0 ; iRow < nRows_ ; iRow++ ){ a[iRow] = op_(a[iRow], b[iRow]); }
+  };
+
+  for( const auto& instruction : _instructionList_ ){
+    switch( instruction.opCode ){
+      case OpCode::Constant:
+        top++; std::fill(&buffer_[size_t(top) * nRows_], &buffer_[size_t(top) * nRows_] + nRows_, instruction.value); break;
+      case OpCode::Load:
+        top++; std::copy(columnList_[instruction.index], columnList_[instruction.index] + nRows_, &buffer_[size_t(top) * nRows_]); break;
+      case OpCode::Negate:       unary([](double a_){ return -a_; }); break;
+      case OpCode::Not:          unary([](double a_){ return double(a_ == 0); }); break;
+      case OpCode::Abs:          unary([](double a_){ return std::abs(a_); }); break;
+      case OpCode::Sqrt:         unary([](double a_){ return std::sqrt(a_); }); break;
+      case OpCode::Exp:          unary([](double a_){ return std::exp(a_); }); break;
+      case OpCode::Log:          unary([](double a_){ return std::log(a_); }); break;
+      case OpCode::Log10:        unary([](double a_){ return std::log10(a_); }); break;
+      case OpCode::Sin:          unary([](double a_){ return std::sin(a_); }); break;
+      case OpCode::Cos:          unary([](double a_){ return std::cos(a_); }); break;
+      case OpCode::Tan:          unary([](double a_){ return std::tan(a_); }); break;
+      case OpCode::Add:          binary([](double a_, double b_){ return a_ + b_; }); break;
+      case OpCode::Subtract:     binary([](double a_, double b_){ return a_ - b_; }); break;
+      case OpCode::Multiply:     binary([](double a_, double b_){ return a_ * b_; }); break;
+      case OpCode::Divide:       binary([](double a_, double b_){ return a_ / b_; }); break;
+      case OpCode::Modulo:       binary([](double a_, double b_){ return std::fmod(a_, b_); }); break;
+      case OpCode::TreeDivide:   binary(&CompiledFormula::treeDivide); break;
+      case OpCode::TreeModulo:   binary(&CompiledFormula::treeModulo); break;
+      case OpCode::Power:        binary([](double a_, double b_){ return std::pow(a_, b_); }); break;
+      case OpCode::Less:         binary([](double a_, double b_){ return double(a_ < b_); }); break;
+      case OpCode::LessEqual:    binary([](double a_, double b_){ return double(a_ <= b_); }); break;
+      case OpCode::Greater:      binary([](double a_, double b_){ return double(a_ > b_); }); break;
+      case OpCode::GreaterEqual: binary([](double a_, double b_){ return double(a_ >= b_); }); break;
+      case OpCode::Equal:        binary([](double a_, double b_){ return double(a_ == b_); }); break;
+      case OpCode::NotEqual:     binary([](double a_, double b_){ return double(a_ != b_); }); break;
+      case OpCode::And:          binary([](double a_, double b_){ return double(a_ != 0 and b_ != 0); }); break;
+      case OpCode::Or:           binary([](double a_, double b_){ return double(a_ != 0 or b_ != 0); }); break;
+      case OpCode::Min:          binary([](double a_, double b_){ return std::min(a_, b_); }); break;
+      case OpCode::Max:          binary([](double a_, double b_){ return std::max(a_, b_); }); break;
+    }
+  }
+
+  std::copy(&buffer_[0], &buffer_[0] + nRows_, output_);
+}